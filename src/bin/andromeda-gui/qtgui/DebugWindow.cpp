@@ -13,6 +13,8 @@ using Andromeda::StringUtil;
 using Andromeda::Filesystem::Filedata::CacheManager;
 #include "andromeda/filesystem/filedata/CachingAllocator.hpp"
 using Andromeda::Filesystem::Filedata::CachingAllocator;
+#include "andromeda/filesystem/filedata/DiskCache.hpp"
+using Andromeda::Filesystem::Filedata::DiskCache;
 
 namespace AndromedaGui {
 namespace QtGui {
@@ -129,16 +131,35 @@ void DebugWindow::UpdateCacheStats()
             << " (" << cacheStats.totalPages << " pages)"
         << ", currentDirty: " << StringUtil::bytesToStringF(cacheStats.currentDirty).c_str() 
             << " (" << StringUtil::bytesToStringF(cacheStats.dirtyLimit).c_str() << " limit)"
-            << " (" << cacheStats.dirtyPages << " pages)";
+            << " (" << cacheStats.dirtyPages << " pages)"
+        << ", probation: " << cacheStats.probationPages << " pages"
+        << ", readHits: " << cacheStats.readHits << ", readMisses: " << cacheStats.readMisses;
     mQtUi->cacheMgrStats->setText(cacheText);
 
     const CachingAllocator::Stats allocStats { mCacheManager->GetPageAllocator().GetStats() };
+    const CachingAllocator::OSStats osStats { mCacheManager->GetPageAllocator().GetOSStats() };
     QString allocText; QTextStream(&allocText)
         << "curAlloc: " << StringUtil::bytesToStringF(allocStats.curAlloc).c_str()
             << " (" << StringUtil::bytesToStringF(allocStats.maxAlloc).c_str() << " max)"
         << ", curFree: " << StringUtil::bytesToStringF(allocStats.curFree).c_str()
-        << ", allocs: " << allocStats.allocs << ", recycles: " << allocStats.recycles;
+        << ", allocs: " << allocStats.allocs << ", recycles: " << allocStats.recycles
+        << ", arenas: " << osStats.arenas << " (" << StringUtil::bytesToStringF(osStats.arenaFree).c_str() << " free)"
+        << ", VMAs: " << osStats.vmaCount << ", RSS: " << StringUtil::bytesToStringF(osStats.rssBytes).c_str();
     mQtUi->cacheAllocStats->setText(allocText);
+
+    const DiskCache* const diskCache { mCacheManager->GetDiskCache() };
+    QString diskText;
+    if (!diskCache) diskText = "disabled";
+    else
+    {
+        const DiskCache::Stats diskStats { diskCache->GetStats() };
+        QTextStream(&diskText)
+            << "currentTotal: " << StringUtil::bytesToStringF(diskStats.currentTotal).c_str()
+                << " (" << diskStats.totalPages << " pages)"
+            << ", pendingStores: " << diskStats.pendingStores << " (" << diskStats.droppedStores << " dropped)"
+            << ", hits: " << diskStats.hits << ", misses: " << diskStats.misses;
+    }
+    mQtUi->diskCacheStats->setText(diskText);
 }
 
 } // namespace QtGui
@@ -67,7 +67,7 @@ protected slots:
     void SetDebugFilter(const QString& filter);
     /** Updates and repaints the GUI debug log widget from buffered debug lines - NOT QT THREAD SAFE */
     void UpdateDebugLog();
-    /** Updates the cache manager and allocator stats labels - NOT QT THREAD SAFE */
+    /** Updates the cache manager, allocator and disk cache stats labels - NOT QT THREAD SAFE */
     void UpdateCacheStats();
 
 private:
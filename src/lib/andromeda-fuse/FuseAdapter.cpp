@@ -10,6 +10,8 @@
 
 #include "libfuse_Includes.h"
 #include "FuseAdapter.hpp"
+#include "FuseInodes.hpp"
+#include "FuseLowLevel.hpp"
 #include "FuseOperations.hpp"
 
 #include "andromeda/Debug.hpp"
@@ -18,8 +20,14 @@ using Andromeda::Debug;
 using Andromeda::PlatformUtil;
 #include "andromeda/SharedMutex.hpp"
 using Andromeda::SharedLockW;
+#include "andromeda/backend/BackendImpl.hpp"
 #include "andromeda/filesystem/Folder.hpp"
 using Andromeda::Filesystem::Folder;
+#include "andromeda/filesystem/FSConfig.hpp"
+using Andromeda::Filesystem::FSConfig;
+using Andromeda::Filesystem::Item;
+#include "andromeda/filesystem/filedata/FetchPool.hpp"
+using Andromeda::Filesystem::Filedata::FetchPool;
 
 using UniqueLock = std::unique_lock<std::mutex>;
 
@@ -255,17 +263,130 @@ struct FuseMount
 
 #endif // LIBFUSE2
 
+#if A2FUSE_LOWLEVEL
+
+/*****************************************************/
+/** Scope-managed fuse_session_new/fuse_session_destroy (low-level API) */
+struct FuseSession
+{
+    /** @param fargs FuseArguments reference */
+    FuseSession(FuseAdapter& adapter, FuseArguments& fargs): 
+        mDebug(__func__,this), mAdapter(adapter), mInodes(*adapter.GetRootFolder())
+    {
+        MDBG_INFO("() fuse_session_new()");
+
+        mSession = fuse_session_new(&(fargs.mFuseArgs), // NOLINT(cppcoreguidelines-prefer-member-initializer)
+            &mOps, sizeof(mOps), static_cast<void*>(&adapter));
+
+        if (!mSession) throw FuseAdapter::Exception("fuse_session_new() failed");
+        mAdapter.mInodes = &mInodes; // register with adapter
+
+        Item::SetRemoteChangeFunc([this](const Item& item, const std::string& name){ 
+            NotifyRemoteChange(item, name); });
+    };
+
+    ~FuseSession()
+    {
+        Item::SetRemoteChangeFunc(nullptr);
+        mNotifier.reset(); // drop pending, finish running
+        mAdapter.mInodes = nullptr;
+
+        MDBG_INFO("() fuse_session_destroy()");
+        fuse_session_destroy(mSession);
+    };
+    DELETE_COPY(FuseSession)
+    DELETE_MOVE(FuseSession)
+
+    /** 
+     * Invalidates the kernel's cache of a remotely changed item, if the kernel knows it
+     * The notify is deferred since it can block on requests that may be waiting on the item's lock
+     */
+    void NotifyRemoteChange(const Item& item, const std::string& name)
+    {
+        const fuse_ino_t ino { mInodes.FindIno(item) };
+        if (!ino) return; // kernel has nothing cached
+
+        MDBG_INFO("(ino:" << ino << ", name:" << name << ")");
+
+        // READAHEAD so the single worker sends them in order
+        mNotifier->AddJob(this, FetchPool::Priority::READAHEAD, [this, ino, name]()
+        {
+            const int retval { name.empty()
+                ? fuse_lowlevel_notify_inval_inode(mSession, ino, 0, 0)
+                : fuse_lowlevel_notify_inval_entry(mSession, ino, name.c_str(), name.size()) };
+            // -ENOENT if the kernel already forgot, -ENOTCONN if unmounted
+            if (retval != FUSE_SUCCESS) { MDBG_INFO("... notify failed: " << retval); }
+        });
+    }
+
+    mutable Debug mDebug;
+    FuseAdapter& mAdapter;
+    /** inode table for the session */
+    FuseInodes mInodes;
+    /** fuse low-level operations struct */
+    a2fuse_lowlevel_ops mOps;
+    /** Fuse session pointer */
+    struct fuse_session* mSession;
+    /** Thread that sends cache invalidations to the kernel */
+    std::unique_ptr<FetchPool> mNotifier { std::make_unique<FetchPool>(1) };
+};
+
+/*****************************************************/
+/** Scope-managed fuse_session_mount/fuse_session_unmount */
+struct FuseSessionMount
+{
+    /** @param session FuseSession reference
+      * @param path filesystem path to mount */
+    FuseSessionMount(FuseAdapter& adapter, FuseSession& session, const char* const path): 
+        mDebug(__func__,this), mAdapter(adapter), mSession(session), mPath(path)
+    {
+        MDBG_INFO("() fuse_session_mount(path:" << path << ")");
+
+        const int retval { fuse_session_mount(mSession.mSession, path) };
+        if (retval != FUSE_SUCCESS)
+            throw FuseAdapter::Exception("fuse_session_mount() failed",retval);
+        mAdapter.mFuseSessionMount = this; // register with adapter
+    };
+
+    /** Exit and unmount the FUSE session */
+    void TriggerUnmount() const
+    {
+        MDBG_INFO("() fuse_session_exit()");
+        fuse_session_exit(mSession.mSession); // flag loop to stop
+
+        // same as FuseMount, the loop is not interrupted until the next FS operation
+        mAdapter.TrySystemUnmount(mPath);
+    }
+
+    ~FuseSessionMount() 
+    {
+        mAdapter.mFuseSessionMount = nullptr;
+
+        MDBG_INFO("() fuse_session_unmount()");
+        fuse_session_unmount(mSession.mSession);
+    }
+    DELETE_COPY(FuseSessionMount)
+    DELETE_MOVE(FuseSessionMount)
+
+    mutable Debug mDebug;
+    FuseAdapter& mAdapter;
+    FuseSession& mSession;
+    /** mounted path */
+    const char* const mPath;
+};
+
+#endif // A2FUSE_LOWLEVEL
+
 /*****************************************************/
 /** Scope-managed fuse_set/remove_signal_handlers */
 struct FuseSignals
 {
-    /** @param context FuseContext reference */
-    explicit FuseSignals(FuseContext& context) : mDebug(__func__,this)
+    /** @param session fuse_session pointer */
+    explicit FuseSignals(struct fuse_session* session) : 
+        mDebug(__func__,this), mFuseSession(session)
     { 
         MDBG_INFO("() fuse_set_signal_handlers()");
 
-        mFuseSession = fuse_get_session(context.mFuse); // NOLINT(cppcoreguidelines-prefer-member-initializer)
-
         const int retval { fuse_set_signal_handlers(mFuseSession) };
         if (retval != FUSE_SUCCESS)
             throw FuseAdapter::Exception("fuse_set_signal_handlers() failed",retval);
@@ -291,6 +412,17 @@ FuseAdapter::FuseAdapter(const std::string& mountPath, Folder& root, const FuseO
     mRootFolder(root.TryLockScope()) // assume valid
 {
     MDBG_INFO("(path:" << mMountPath << ")");
+
+#if A2FUSE_WRITEBACK
+    // the kernel flushes cached pages at any offset, which needs random writes (one filesystem)
+    if (mOptions.writebackCache && !(root.HasFSConfig() && 
+        root.GetFSConfig().GetWriteMode() >= FSConfig::WriteMode::RANDOM &&
+        root.GetBackend().GetConfig().canRandWrite()))
+    {
+        MDBG_ERROR("... WARNING writeback cache needs random write support, disabling");
+        mOptions.writebackCache = false;
+    }
+#endif // A2FUSE_WRITEBACK
 }
 
 /*****************************************************/
@@ -336,9 +468,21 @@ void FuseAdapter::FuseMain(bool regSignals, bool daemonize, const FuseAdapter::F
         // For WinFSP, use the current user
         fuseArgs.AddArg("uid=-1,gid=-1");
     #endif // WIN32
+    #if LIBFUSE2 // fuse3 sets these in FuseOperations::init
+        fuseArgs.AddArg("auto_cache,attr_timeout="+std::to_string(mOptions.attrTimeout.count())+
+            ",entry_timeout="+std::to_string(mOptions.entryTimeout.count()));
+    #endif // LIBFUSE2
         for (const std::string& fuseArg : mOptions.fuseArgs)
             fuseArgs.AddArg(fuseArg);
 
+    #if A2FUSE_LOWLEVEL
+        if (mOptions.lowLevel)
+        {
+            FuseMainLowLevel(fuseArgs, regSignals, daemonize, forkFunc);
+            SignalInit(); return; // just in case
+        }
+    #endif // A2FUSE_LOWLEVEL
+
     #if LIBFUSE2
         FuseMount mount(fuseArgs, mMountPath.c_str());
         FuseContext context(*this, mount, fuseArgs);
@@ -347,19 +491,10 @@ void FuseAdapter::FuseMain(bool regSignals, bool daemonize, const FuseAdapter::F
         const FuseMount mount(*this, context, mMountPath.c_str());
     #endif // LIBFUSE2
 
-        if (daemonize)
-        {
-            MDBG_INFO("... fuse_daemonize()");
-
-            const int retval { fuse_daemonize(0) };
-            if (retval != FUSE_SUCCESS)
-                throw FuseAdapter::Exception("fuse_daemonize() failed",retval);
-
-            if (forkFunc) forkFunc();
-        }
+        if (daemonize) Daemonize(forkFunc);
         
-        const std::unique_ptr<FuseSignals> signalsPtr {
-            regSignals ? std::make_unique<FuseSignals>(context) : nullptr };
+        const std::unique_ptr<FuseSignals> signalsPtr { regSignals ? 
+            std::make_unique<FuseSignals>(fuse_get_session(context.mFuse)) : nullptr };
 
         { // retval scope
             int retval = -1;
@@ -397,6 +532,53 @@ void FuseAdapter::FuseMain(bool regSignals, bool daemonize, const FuseAdapter::F
     SignalInit(); // just in case fuse fails but doesn't throw
 }
 
+#if A2FUSE_LOWLEVEL
+/*****************************************************/
+void FuseAdapter::FuseMainLowLevel(FuseArguments& fuseArgs, bool regSignals, bool daemonize, const FuseAdapter::ForkFunc& forkFunc)
+{
+    MDBG_INFO("()");
+
+    FuseSession session(*this, fuseArgs);
+    const FuseSessionMount mount(*this, session, mMountPath.c_str());
+
+    if (daemonize) Daemonize(forkFunc);
+
+    const std::unique_ptr<FuseSignals> signalsPtr { regSignals ? 
+        std::make_unique<FuseSignals>(session.mSession) : nullptr };
+
+    int retval = -1;
+    if (mOptions.enableThreading)
+    {
+        MDBG_INFO("() fuse_session_loop_mt()");
+        struct fuse_loop_config loop_config { }; // zero
+        loop_config.max_idle_threads = mOptions.maxIdleThreads;
+        retval = fuse_session_loop_mt(session.mSession, &loop_config);
+        MDBG_INFO("() fuse_session_loop_mt() returned!");
+    }
+    else
+    {
+        MDBG_INFO("() fuse_session_loop()");
+        retval = fuse_session_loop(session.mSession);
+        MDBG_INFO("() fuse_session_loop() returned!");
+    }
+
+    if (retval < 0)
+        throw FuseAdapter::Exception("fuse_session_loop() failed",retval); 
+}
+#endif // A2FUSE_LOWLEVEL
+
+/*****************************************************/
+void FuseAdapter::Daemonize(const FuseAdapter::ForkFunc& forkFunc)
+{
+    MDBG_INFO("() fuse_daemonize()");
+
+    const int retval { fuse_daemonize(0) };
+    if (retval != FUSE_SUCCESS)
+        throw FuseAdapter::Exception("fuse_daemonize() failed",retval);
+
+    if (forkFunc) forkFunc();
+}
+
 /*****************************************************/
 void FuseAdapter::SignalInit()
 {
@@ -419,6 +601,10 @@ FuseAdapter::~FuseAdapter()
     if (mFuseMount) 
         mFuseMount->TriggerUnmount();
 #endif // LIBFUSE2
+#if A2FUSE_LOWLEVEL
+    if (mFuseSessionMount)
+        mFuseSessionMount->TriggerUnmount();
+#endif // A2FUSE_LOWLEVEL
 
     if (mFuseThread.joinable())
     {
@@ -10,6 +10,7 @@
 #include <thread>
 
 #include "FuseOptions.hpp"
+#include "libfuse_Config.h"
 #include "andromeda/BaseException.hpp"
 #include "andromeda/common.hpp"
 #include "andromeda/Debug.hpp"
@@ -18,9 +19,14 @@
 
 namespace AndromedaFuse {
 
+struct FuseArguments;
 struct FuseContext;
+class FuseInodes;
+struct FuseLowLevel;
 struct FuseMount;
 struct FuseOperations;
+struct FuseSession;
+struct FuseSessionMount;
 
 /** Static class for FUSE operations */
 class FuseAdapter
@@ -92,6 +98,11 @@ public:
 
     /** Returns the root folder with a scope lock */
     inline Andromeda::Filesystem::Folder::ScopeLocked& GetRootFolder() { return mRootFolder; }
+
+#if A2FUSE_LOWLEVEL
+    /** Returns the inode table (only while running the low-level API) */
+    inline FuseInodes& GetInodes() { return *mInodes; }
+#endif // A2FUSE_LOWLEVEL
     
     /** Print version text to stdout */
     static void ShowVersionText();
@@ -99,6 +110,7 @@ public:
 private:
 
     friend struct FuseOperations;
+    friend struct FuseLowLevel;
 
     /** 
      * Runs/mounts libfuse (blocking) 
@@ -109,6 +121,21 @@ private:
      */
     void FuseMain(bool regSignals, bool daemonize, const ForkFunc& forkFunc) noexcept;
 
+#if A2FUSE_LOWLEVEL
+    /** 
+     * Runs/mounts the low-level libfuse session (blocking)
+     * @param fuseArgs FuseArguments reference
+     * @throws Exception for any FUSE issues
+     */
+    void FuseMainLowLevel(FuseArguments& fuseArgs, bool regSignals, bool daemonize, const ForkFunc& forkFunc);
+#endif // A2FUSE_LOWLEVEL
+
+    /** 
+     * Forks to a detached process then runs forkFunc if set
+     * @throws Exception if fuse_daemonize fails
+     */
+    void Daemonize(const ForkFunc& forkFunc);
+
     /** Signals initialization complete */
     void SignalInit();
 
@@ -134,6 +161,14 @@ private:
     FuseMount* mFuseMount { nullptr };
 #endif // LIBFUSE2
 
+#if A2FUSE_LOWLEVEL
+    friend struct FuseSession;
+    friend struct FuseSessionMount;
+    FuseSessionMount* mFuseSessionMount { nullptr };
+    /** Inode table for the low-level API, while a session exists */
+    FuseInodes* mInodes { nullptr };
+#endif // A2FUSE_LOWLEVEL
+
     bool mInitialized { false };
     std::mutex mInitMutex;
     std::condition_variable mInitCV;
@@ -0,0 +1,231 @@
+
+#include <cerrno>
+#if WIN32
+#define EHOSTDOWN EIO
+#endif // WIN32
+
+#include "FuseAdapter.hpp"
+#include "FuseCommon.hpp"
+#include "FuseOptions.hpp"
+
+#include "andromeda/BaseException.hpp"
+using Andromeda::BaseException;
+#include "andromeda/Debug.hpp"
+using Andromeda::Debug;
+#include "andromeda/SharedMutex.hpp"
+using Andromeda::SharedLockR;
+using Andromeda::SharedLockW;
+#include "andromeda/backend/BackendImpl.hpp"
+using Andromeda::Backend::BackendImpl;
+#include "andromeda/backend/HTTPRunner.hpp"
+using Andromeda::Backend::HTTPRunner;
+#include "andromeda/filesystem/Item.hpp"
+using Andromeda::Filesystem::Item;
+#include "andromeda/filesystem/File.hpp"
+using Andromeda::Filesystem::File;
+#include "andromeda/filesystem/Folder.hpp"
+using Andromeda::Filesystem::Folder;
+#include "andromeda/filesystem/filedata/CacheManager.hpp"
+using Andromeda::Filesystem::Filedata::CacheManager;
+
+namespace AndromedaFuse {
+
+namespace { // anonymous
+Debug sDebug("FuseCommon",nullptr); // NOLINT(cert-err58-cpp)
+} // anonymous namespace
+
+/*****************************************************/
+int CatchAsErrno(const char* const fname, const std::function<int()>& func, const char* const path)
+{
+    try { return func(); }
+
+    #define SDBG_INFO_EXC(e) SDBG_INFO(": " << fname << "... " << path << ": " << e.what());
+    #define SDBG_ERROR_EXC(e) SDBG_ERROR(": " << fname << "... " << path << ": " << e.what());
+
+    // Item exceptions
+    catch (const Folder::NotFileException& e)
+    {
+        SDBG_INFO_EXC(e); return -EISDIR;
+    }
+    catch (const Folder::NotFolderException& e)
+    {
+        SDBG_INFO_EXC(e); return -ENOTDIR;
+    }
+    catch (const Folder::NotFoundException& e)
+    {
+        SDBG_INFO_EXC(e); return -ENOENT;
+    }
+    catch (const Folder::DuplicateItemException& e)
+    {
+        SDBG_INFO_EXC(e); return -EEXIST;
+    }
+    catch (const Folder::ModifyException& e)
+    {
+        SDBG_ERROR_EXC(e); return -ENOTSUP;
+    }
+    catch (const File::WriteTypeException& e)
+    {
+        SDBG_ERROR_EXC(e); return -ENOTSUP;
+    }
+    catch (const Item::ReadOnlyFSException& e)
+    {
+        SDBG_INFO_EXC(e); return -EROFS;
+    }
+    catch (const Item::NullParentException& e)
+    {
+        SDBG_ERROR_EXC(e); return -ENOTSUP;
+    }
+    catch (const CacheManager::MemoryException& e)
+    {
+        SDBG_ERROR_EXC(e); return -ENOMEM;
+    }
+
+    // Backend exceptions
+    catch (const BackendImpl::UnsupportedException& e)
+    {
+        SDBG_ERROR_EXC(e); return -ENOTSUP;
+    }
+    catch (const BackendImpl::ReadOnlyFSException& e)
+    {
+        SDBG_INFO_EXC(e); return -EROFS;
+    }
+    catch (const BackendImpl::DeniedException& e)
+    {
+        SDBG_INFO_EXC(e); return -EACCES;
+    }
+    catch (const BackendImpl::NotFoundException& e)  
+    {
+        SDBG_INFO_EXC(e); return -ENOENT;
+    }
+    catch (const BackendImpl::WriteSizeException& e)
+    {
+        SDBG_ERROR_EXC(e); return -ENOTSUP;
+    }
+    catch (const HTTPRunner::ConnectionException& e)
+    {
+        SDBG_ERROR_EXC(e); return -EHOSTDOWN;
+    }
+
+    catch (const BaseException& e) // anything else
+    {
+        SDBG_ERROR_EXC(e); return -EIO;
+    }
+}
+
+// TODO if Windows calls utimens then the conversion of timespec->double->timespec will not match
+// maybe the server will need to actually store timespec sec/nsec...? may be important for syncing
+
+/*****************************************************/
+Item::Date timespec_to_date(const timespec& t)
+{ 
+    return static_cast<Item::Date>(t.tv_sec) + static_cast<Item::Date>(t.tv_nsec)/1e9; 
+}
+
+/*****************************************************/
+void want_writeback(const FuseOptions& options, struct fuse_conn_info* conn)
+{
+#if A2FUSE_WRITEBACK
+    if (options.writebackCache && (conn->capable & FUSE_CAP_WRITEBACK_CACHE)) // NOLINT(hicpp-signed-bitwise)
+    {
+        SDBG_INFO("... enabling writeback cache");
+        // the kernel batches writes and owns the size/mtime, sets mtime with setattr/utimens
+        conn->want |= FUSE_CAP_WRITEBACK_CACHE;
+    }
+#endif // A2FUSE_WRITEBACK
+}
+
+/*****************************************************/
+void want_splice(struct fuse_conn_info* conn)
+{
+#if A2FUSE_SPLICE
+    // replies are sent from resident pages with writev, splicing them would add a copy into the pipe
+    if (conn->capable & FUSE_CAP_SPLICE_READ) // NOLINT(hicpp-signed-bitwise)
+        conn->want |= FUSE_CAP_SPLICE_READ;
+#endif // A2FUSE_SPLICE
+}
+
+#if A2FUSE_SPLICE
+/*****************************************************/
+size_t write_bufvec(File& file, struct fuse_bufvec* bufv, const uint64_t offset, const SharedLockW& fileLock)
+{
+    const size_t size { fuse_buf_size(bufv) };
+
+    return file.WriteBytes([&](char* buffer, const size_t length)->size_t
+    {
+        struct fuse_bufvec dst = FUSE_BUFVEC_INIT(length);
+        dst.buf[0].mem = buffer;
+
+        // advances bufv so the next page continues where this left off
+        const ssize_t copied { fuse_buf_copy(&dst, bufv, static_cast<fuse_buf_copy_flags>(0)) };
+        if (copied < 0) throw FuseAdapter::Exception("fuse_buf_copy() failed", static_cast<int>(copied));
+        return static_cast<size_t>(copied); // short if the pipe ran out, only that much is written
+    }, offset, size, fileLock);
+}
+#endif // A2FUSE_SPLICE
+
+namespace { // anonymous
+
+/*****************************************************/
+constexpr void date_to_timespec(const Item::Date time, timespec& spec)
+{
+    spec.tv_sec = static_cast<decltype(spec.tv_sec)>(time); // truncate to int
+    spec.tv_nsec = static_cast<decltype(spec.tv_nsec)>((time-static_cast<Item::Date>(spec.tv_sec))*1e9);
+}
+
+} // anonymous namespace
+
+/*****************************************************/
+void item_stat(const Item::ScopeLocked& item, const SharedLockR& itemLock, 
+    const FuseOptions& options, uid_t uid, gid_t gid, struct stat* stbuf)
+{    
+    const Item::Type itemType { item->GetType() };
+    if (itemType == Item::Type::FILE)
+    {
+        stbuf->st_mode = S_IFREG | static_cast<decltype(stbuf->st_mode)>(
+            options.fileMode); 
+
+        const File& file { dynamic_cast<const File&>(*item) };
+        stbuf->st_size = static_cast<decltype(stbuf->st_size)>(file.GetSize(itemLock));
+        stbuf->st_blksize = static_cast<decltype(stbuf->st_blksize)>(file.GetPageSize());
+    }
+    else if (itemType == Item::Type::FOLDER)
+    {
+        stbuf->st_mode = S_IFDIR | static_cast<decltype(stbuf->st_mode)>(
+            options.dirMode);
+
+        stbuf->st_size = 0;
+        stbuf->st_blksize = 4096; // meaningless?
+    }
+
+    stbuf->st_uid = uid;
+    stbuf->st_gid = gid;
+
+    stbuf->st_blocks = !stbuf->st_size ? 0 :
+        (stbuf->st_size-1)/512+1; // # of 512B blocks
+
+    const Item::Date created { item->GetCreated(itemLock) };
+    const Item::Date modified { item->GetModified(itemLock) };
+    const Item::Date accessed { item->GetAccessed(itemLock) };
+
+#if WIN32
+    date_to_timespec(created, stbuf->st_birthtim);
+#endif // WIN32
+
+#ifdef APPLE
+    stbuf->st_ctime = static_cast<decltype(stbuf->st_ctime)>(created);
+    stbuf->st_mtime = static_cast<decltype(stbuf->st_mtime)>(modified);
+    stbuf->st_atime = static_cast<decltype(stbuf->st_atime)>(accessed);
+
+    if (!stbuf->st_mtime) stbuf->st_mtime = stbuf->st_ctime;
+    if (!stbuf->st_atime) stbuf->st_atime = stbuf->st_atime;
+#else // !APPLE
+    date_to_timespec(created, stbuf->st_ctim);
+    date_to_timespec(modified, stbuf->st_mtim);
+    date_to_timespec(accessed, stbuf->st_atim);
+    
+    if (modified == 0) stbuf->st_mtim = stbuf->st_ctim;
+    if (accessed == 0) stbuf->st_atim = stbuf->st_ctim;
+#endif // APPLE
+}
+
+} // namespace AndromedaFuse
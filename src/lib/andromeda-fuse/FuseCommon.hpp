@@ -0,0 +1,80 @@
+
+#ifndef A2FUSE_FUSECOMMON_H_
+#define A2FUSE_FUSECOMMON_H_
+
+#include <functional>
+#include <memory>
+
+#include "libfuse_Includes.h"
+
+#include "andromeda/SharedMutex.hpp"
+#include "andromeda/filesystem/Item.hpp"
+
+namespace Andromeda { namespace Filesystem { class File; } }
+
+namespace AndromedaFuse {
+
+struct FuseOptions;
+
+/** 
+ * Runs the given function and returns its value, mapping any exceptions to -errno
+ * Common to both the high-level and low-level FUSE frontends
+ * @param fname name of the calling function for debug
+ * @param func the function to run (returns FUSE_SUCCESS or -errno)
+ * @param path the path or name of the item for debug
+ */
+int CatchAsErrno(const char* fname, const std::function<int()>& func, const char* path);
+
+/** 
+ * Fills in the stat struct for the given item
+ * @param options FUSE options for the file/dir mode
+ * @param uid the user ID to use as the owner
+ * @param gid the group ID to use as the owner
+ */
+void item_stat(const Andromeda::Filesystem::Item::ScopeLocked& item, const Andromeda::SharedLockR& itemLock, 
+    const FuseOptions& options, uid_t uid, gid_t gid, struct stat* stbuf);
+
+/** Returns the item date for the given timespec */
+Andromeda::Filesystem::Item::Date timespec_to_date(const timespec& t);
+
+/** Returns the handle object stored in fi's fh */
+template<class Handle>
+inline Handle& GetHandle(const struct fuse_file_info* const fi)
+{
+    return *reinterpret_cast<Handle*>(fi->fh); // NOLINT(performance-no-int-to-ptr)
+}
+
+/** Stores the handle object in fi's fh, which owns it until TakeHandle */
+template<class Handle>
+inline void SetHandle(struct fuse_file_info* const fi, std::unique_ptr<Handle> handle)
+{
+    fi->fh = reinterpret_cast<decltype(fi->fh)>(handle.release());
+}
+
+/** Removes and returns the handle object stored in fi's fh */
+template<class Handle>
+inline std::unique_ptr<Handle> TakeHandle(struct fuse_file_info* const fi)
+{
+    std::unique_ptr<Handle> handle { &GetHandle<Handle>(fi) };
+    fi->fh = 0; return handle;
+}
+
+/** Enables the kernel writeback cache in conn if requested in options and supported */
+void want_writeback(const FuseOptions& options, struct fuse_conn_info* conn);
+
+/** Enables receiving write data spliced from the kernel in conn if supported */
+void want_splice(struct fuse_conn_info* conn);
+
+#if A2FUSE_SPLICE
+/** 
+ * Writes the data in bufv to the file, copying it straight into the file's pages
+ * bufv may be memory or a pipe the kernel spliced the data into, see fuse_buf_copy()
+ * @return the number of bytes written
+ */
+size_t write_bufvec(Andromeda::Filesystem::File& file, struct fuse_bufvec* bufv, 
+    uint64_t offset, const Andromeda::SharedLockW& fileLock);
+#endif // A2FUSE_SPLICE
+
+} // namespace AndromedaFuse
+
+#endif // A2FUSE_FUSECOMMON_H_
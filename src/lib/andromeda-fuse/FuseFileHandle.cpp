@@ -0,0 +1,31 @@
+
+#include <utility>
+
+#include "FuseFileHandle.hpp"
+
+#include "andromeda/filesystem/File.hpp"
+using Andromeda::Filesystem::File;
+#include "andromeda/filesystem/Item.hpp"
+using Andromeda::Filesystem::Item;
+
+namespace AndromedaFuse {
+
+/*****************************************************/
+FuseFileHandle::FuseFileHandle(File& file, const int flags) :
+    mFile(file.GetWeakRef()), mFlags(flags) { }
+
+/*****************************************************/
+File::ScopeLocked FuseFileHandle::TryLockFile() const
+{
+    Item::ScopeLocked item { Item::TryLockScope(mFile) };
+    if (!item) return File::ScopeLocked();
+    return File::ScopeLocked::FromBase(std::move(item));
+}
+
+/*****************************************************/
+bool FuseFileHandle::UpdateSequential(const uint64_t offset, const size_t size)
+{
+    return mNextRead.exchange(offset+size) == offset;
+}
+
+} // namespace AndromedaFuse
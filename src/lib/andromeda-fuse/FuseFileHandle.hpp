@@ -0,0 +1,56 @@
+#ifndef A2FUSE_FUSEFILEHANDLE_H_
+#define A2FUSE_FUSEFILEHANDLE_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "andromeda/common.hpp"
+#include "andromeda/filesystem/File.hpp"
+#include "andromeda/filesystem/Item.hpp"
+
+namespace AndromedaFuse {
+
+/** 
+ * State for a file opened through FUSE, stored in fuse_file_info's fh (see SetHandle)
+ * Ops on the open file use it to go straight to the file without a path lookup.
+ * Holds a weak reference to the file, so an open handle never blocks deleting it.
+ * The low-level unlink keeps open files until their last handle is released (see FuseInodes::SetUnlinked).
+ * THREAD SAFE (INTERNAL ATOMICS)
+ */
+class FuseFileHandle
+{
+public:
+
+    /** @param flags the open flags from fuse_file_info */
+    FuseFileHandle(Andromeda::Filesystem::File& file, int flags);
+
+    virtual ~FuseFileHandle() = default;
+    DELETE_COPY(FuseFileHandle)
+    DELETE_MOVE(FuseFileHandle)
+
+    /** Tries to lock the file's scope, returns a ref that is not locked if it was deleted */
+    Andromeda::Filesystem::File::ScopeLocked TryLockFile() const;
+
+    /** Returns the open flags */
+    [[nodiscard]] inline int GetFlags() const { return mFlags; }
+
+    /** 
+     * Records a read and returns true if it continues from the previous one
+     * The first read is considered sequential if it starts at the beginning
+     */
+    bool UpdateSequential(uint64_t offset, size_t size);
+
+private:
+
+    /** Weak reference to the file */
+    const Andromeda::Filesystem::Item::WeakRef mFile;
+    /** The open flags */
+    const int mFlags;
+
+    /** The offset the next sequential read would start at */
+    std::atomic<uint64_t> mNextRead { 0 };
+};
+
+} // namespace AndromedaFuse
+
+#endif // A2FUSE_FUSEFILEHANDLE_H_
@@ -0,0 +1,164 @@
+
+#include "FuseInodes.hpp"
+
+#if A2FUSE_LOWLEVEL
+
+#include "andromeda/filesystem/Item.hpp"
+using Andromeda::Filesystem::Item;
+
+namespace AndromedaFuse {
+
+/*****************************************************/
+FuseInodes::FuseInodes(Item& root) : 
+    mDebug(__func__,this)
+{
+    MDBG_INFO("()");
+
+    mInodes.emplace(FUSE_ROOT_ID, Inode{root.GetWeakRef(), &root, 1});
+    mItemInodes.emplace(&root, FUSE_ROOT_ID);
+}
+
+/*****************************************************/
+fuse_ino_t FuseInodes::Lookup(Item& item)
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mItemInodes)::iterator it { mItemInodes.find(&item) };
+    if (it != mItemInodes.end())
+    {
+        Inode& inode { mInodes.at(it->second) };
+        // the old item may have been deleted and a new one allocated at the same address
+        const std::shared_lock<std::shared_mutex> refLock(inode.ref->mMutex);
+        if (inode.ref->mItem == &item)
+        {
+            ++inode.nlookup;
+            return it->second;
+        }
+    }
+
+    const fuse_ino_t ino { mNextIno++ };
+    mInodes.emplace(ino, Inode{item.GetWeakRef(), &item, 1});
+    mItemInodes[&item] = ino;
+
+    MDBG_INFO("... new ino:" << ino << " inodes:" << mInodes.size());
+    return ino;
+}
+
+/*****************************************************/
+void FuseInodes::Forget(const fuse_ino_t ino, const uint64_t nlookup)
+{
+    if (ino == FUSE_ROOT_ID) return; // never forgotten
+
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mInodes)::iterator it { mInodes.find(ino) };
+    if (it == mInodes.end()) return;
+
+    if (it->second.nlookup > nlookup)
+    {
+        it->second.nlookup -= nlookup; return;
+    }
+
+    // the address may have been re-used by a newer inode
+    const decltype(mItemInodes)::iterator itemIt { mItemInodes.find(it->second.item) };
+    if (itemIt != mItemInodes.end() && itemIt->second == ino)
+        mItemInodes.erase(itemIt);
+
+    mInodes.erase(it);
+    MDBG_INFO("... forgot ino:" << ino << " inodes:" << mInodes.size());
+}
+
+/*****************************************************/
+fuse_ino_t FuseInodes::FindIno(const Item& item) const
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mItemInodes)::const_iterator it { mItemInodes.find(&item) };
+    if (it == mItemInodes.end()) return 0;
+
+    const Inode& inode { mInodes.at(it->second) };
+    const std::shared_lock<std::shared_mutex> refLock(inode.ref->mMutex);
+    return (inode.ref->mItem == &item) ? it->second : 0;
+}
+
+/*****************************************************/
+bool FuseInodes::CheckCached(const fuse_ino_t ino, const uint64_t size, const Item::Date modified)
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mInodes)::iterator it { mInodes.find(ino) };
+    if (it == mInodes.end()) return false;
+
+    Inode& inode { it->second };
+    const bool unchanged { inode.cached && inode.size == size && inode.modified == modified };
+    inode.cached = true; inode.size = size; inode.modified = modified;
+    return unchanged;
+}
+
+/*****************************************************/
+void FuseInodes::Open(const fuse_ino_t ino)
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mInodes)::iterator it { mInodes.find(ino) };
+    if (it != mInodes.end()) ++it->second.opens;
+}
+
+/*****************************************************/
+bool FuseInodes::isOpen(const fuse_ino_t ino) const
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mInodes)::const_iterator it { mInodes.find(ino) };
+    return it != mInodes.end() && it->second.opens > 0;
+}
+
+/*****************************************************/
+bool FuseInodes::SetUnlinked(const fuse_ino_t ino)
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mInodes)::iterator it { mInodes.find(ino) };
+    if (it == mInodes.end() || !it->second.opens) return false;
+
+    it->second.unlinked = true;
+    return true;
+}
+
+/*****************************************************/
+bool FuseInodes::Release(const fuse_ino_t ino)
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+
+    const decltype(mInodes)::iterator it { mInodes.find(ino) };
+    if (it == mInodes.end() || !it->second.opens) return false;
+
+    return !--it->second.opens && it->second.unlinked;
+}
+
+/*****************************************************/
+Item::ScopeLocked FuseInodes::GetItem(const fuse_ino_t ino) const
+{
+    Item::WeakRef ref; { // lock scope
+        const std::lock_guard<std::mutex> llock(mMutex);
+
+        const decltype(mInodes)::const_iterator it { mInodes.find(ino) };
+        if (it == mInodes.end()) throw StaleException();
+        ref = it->second.ref;
+    }
+
+    Item::ScopeLocked item { Item::TryLockScope(ref) };
+    if (!item) throw StaleException();
+    return item;
+}
+
+/*****************************************************/
+size_t FuseInodes::GetSize() const
+{
+    const std::lock_guard<std::mutex> llock(mMutex);
+    return mInodes.size();
+}
+
+} // namespace AndromedaFuse
+
+#endif // A2FUSE_LOWLEVEL
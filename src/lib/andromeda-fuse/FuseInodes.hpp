@@ -0,0 +1,128 @@
+
+#ifndef A2FUSE_FUSEINODES_H_
+#define A2FUSE_FUSEINODES_H_
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "libfuse_Includes.h"
+
+#if A2FUSE_LOWLEVEL
+
+#include "andromeda/BaseException.hpp"
+#include "andromeda/common.hpp"
+#include "andromeda/Debug.hpp"
+#include "andromeda/filesystem/Item.hpp"
+
+namespace AndromedaFuse {
+
+/** 
+ * Maps low-level FUSE inode numbers to items, with kernel lookup counts
+ * Inodes only hold weak references so the kernel remembering an inode never blocks deleting its item.
+ * An item keeps the same inode number for as long as the kernel remembers it, and numbers are never re-used.
+ * THREAD SAFE (INTERNAL LOCKS)
+ */
+class FuseInodes
+{
+public:
+
+    /** Exception indicating the inode is unknown or its item was deleted */
+    class StaleException : public Andromeda::BaseException { public:
+        StaleException() : Andromeda::BaseException("Stale Inode") {}; };
+
+    /** @param root the root folder, always FUSE_ROOT_ID (caller must hold a scope lock for our lifetime) */
+    explicit FuseInodes(Andromeda::Filesystem::Item& root);
+
+    virtual ~FuseInodes() = default;
+    DELETE_COPY(FuseInodes)
+    DELETE_MOVE(FuseInodes)
+
+    /** 
+     * Returns the inode number for the given item and increments its lookup count
+     * Must be called once for every successful entry reply to the kernel
+     * @param item the item to look up (caller must hold a scope lock)
+     */
+    fuse_ino_t Lookup(Andromeda::Filesystem::Item& item);
+
+    /** Decrements the lookup count of the given inode, forgetting it when zero */
+    void Forget(fuse_ino_t ino, uint64_t nlookup);
+
+    /** Returns the inode number for the given item without a lookup, or 0 if the kernel doesn't know it */
+    fuse_ino_t FindIno(const Andromeda::Filesystem::Item& item) const;
+
+    /** 
+     * Records the size and modified time of a file inode's contents as the kernel has cached them
+     * @return true iff they are unchanged since last recorded (the kernel's page cache is still valid)
+     */
+    bool CheckCached(fuse_ino_t ino, uint64_t size, Andromeda::Filesystem::Item::Date modified);
+
+    /** Records a new open file handle for the given inode (the kernel doesn't forget it while open) */
+    void Open(fuse_ino_t ino);
+
+    /** Returns true if the given inode has open file handles */
+    bool isOpen(fuse_ino_t ino) const;
+
+    /** 
+     * Marks an open inode's item to be deleted when its last handle is released
+     * @return false if it has no open handles (anymore), the caller must delete it
+     */
+    bool SetUnlinked(fuse_ino_t ino);
+
+    /** 
+     * Records that an open file handle for the given inode was released
+     * @return true iff it was the last one and the item was unlinked, the caller must delete it
+     */
+    bool Release(fuse_ino_t ino);
+
+    /** 
+     * Returns the scope-locked item for the given inode
+     * @throws StaleException if the inode is unknown or its item was deleted
+     */
+    Andromeda::Filesystem::Item::ScopeLocked GetItem(fuse_ino_t ino) const;
+
+    /** Returns the number of inodes the kernel remembers */
+    size_t GetSize() const;
+
+private:
+
+    /** An inode known to the kernel */
+    struct Inode
+    {
+        /** Weak reference to the item */
+        Andromeda::Filesystem::Item::WeakRef ref;
+        /** Address of the item as the mItemInodes key (do not dereference) */
+        const Andromeda::Filesystem::Item* item;
+        /** Number of lookups not yet forgotten */
+        uint64_t nlookup;
+        /** True if size and modified have been recorded */
+        bool cached { false };
+        /** Size of the file as last cached */
+        uint64_t size { 0 };
+        /** Modified time of the file as last cached */
+        Andromeda::Filesystem::Item::Date modified { 0 };
+        /** Number of open file handles */
+        size_t opens { 0 };
+        /** True if the item was unlinked while open */
+        bool unlinked { false };
+    };
+
+    mutable Andromeda::Debug mDebug;
+
+    /** Mutex that protects all members */
+    mutable std::mutex mMutex;
+
+    /** Map of inode numbers to inodes */
+    std::unordered_map<fuse_ino_t, Inode> mInodes;
+    /** Map of items to their inode numbers (items may be gone, check the inode's ref) */
+    std::unordered_map<const Andromeda::Filesystem::Item*, fuse_ino_t> mItemInodes;
+
+    /** The next inode number to assign */
+    fuse_ino_t mNextIno { FUSE_ROOT_ID+1 };
+};
+
+} // namespace AndromedaFuse
+
+#endif // A2FUSE_LOWLEVEL
+
+#endif // A2FUSE_FUSEINODES_H_
@@ -0,0 +1,718 @@
+
+#include "libfuse_Includes.h"
+
+#if A2FUSE_LOWLEVEL
+
+#include <cerrno>
+#include <sys/uio.h> // iovec
+
+#include <bitset>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FuseAdapter.hpp"
+#include "FuseCommon.hpp"
+#include "FuseFileHandle.hpp"
+#include "FuseInodes.hpp"
+#include "FuseLowLevel.hpp"
+#include "FuseOperations.hpp"
+
+#include "andromeda/Debug.hpp"
+using Andromeda::Debug;
+#include "andromeda/SharedMutex.hpp"
+using Andromeda::SharedLockR;
+using Andromeda::SharedLockW;
+#include "andromeda/filesystem/Item.hpp"
+using Andromeda::Filesystem::Item;
+#include "andromeda/filesystem/File.hpp"
+using Andromeda::Filesystem::File;
+#include "andromeda/filesystem/Folder.hpp"
+using Andromeda::Filesystem::Folder;
+
+namespace AndromedaFuse {
+
+namespace { // anonymous
+
+Debug sDebug("FuseLowLevel",nullptr); // NOLINT(cert-err58-cpp)
+
+// seconds the kernel may cache a not-found entry
+constexpr double NEGATIVE_TIMEOUT { 1.0 };
+
+// readdir entries don't carry an inode (it would need a lookup count), same as libfuse
+constexpr ino_t UNKNOWN_INO { 0xffffffff };
+
+/** Handle for an open directory, stored in fi->fh */
+struct OpenDir
+{
+    /** Snapshot of names and types, loaded at offset 0 or if missing */
+    std::vector<std::pair<std::string, mode_t>> mEntries;
+};
+
+/*****************************************************/
+inline FuseAdapter& GetFuseAdapter(fuse_req_t req)
+{
+    return *static_cast<FuseAdapter*>(fuse_req_userdata(req));
+}
+
+/*****************************************************/
+inline FuseInodes& GetInodes(fuse_req_t req)
+{
+    return GetFuseAdapter(req).GetInodes();
+}
+
+/*****************************************************/
+/** Returns the seconds the kernel may cache attributes */
+inline double GetAttrTimeout(fuse_req_t req)
+{
+    return static_cast<double>(GetFuseAdapter(req).GetOptions().attrTimeout.count());
+}
+
+/*****************************************************/
+/** Returns the seconds the kernel may cache entries */
+inline double GetEntryTimeout(fuse_req_t req)
+{
+    return static_cast<double>(GetFuseAdapter(req).GetOptions().entryTimeout.count());
+}
+
+/*****************************************************/
+inline Item::ScopeLocked GetItem(fuse_req_t req, const fuse_ino_t ino)
+{
+    return GetInodes(req).GetItem(ino);
+}
+
+/*****************************************************/
+File::ScopeLocked GetFile(fuse_req_t req, const fuse_ino_t ino)
+{
+    Item::ScopeLocked item { GetItem(req, ino) };
+    if (item->GetType() != Item::Type::FILE)
+        throw Folder::NotFileException();
+    return File::ScopeLocked::FromBase(std::move(item));
+}
+
+/*****************************************************/
+Folder::ScopeLocked GetFolder(fuse_req_t req, const fuse_ino_t ino)
+{
+    Item::ScopeLocked item { GetItem(req, ino) };
+    if (item->GetType() != Item::Type::FOLDER)
+        throw Folder::NotFolderException();
+    return Folder::ScopeLocked::FromBase(std::move(item));
+}
+
+/*****************************************************/
+File::ScopeLocked GetOpenFile(const FuseFileHandle& handle)
+{
+    File::ScopeLocked file { handle.TryLockFile() };
+    if (!file) throw FuseInodes::StaleException();
+    return file;
+}
+
+/*****************************************************/
+/** 
+ * Deletes the given file, or if it is open, renames it to a hidden name to be deleted when
+ * its last handle is released (like libfuse's high-level API) so open handles keep working
+ */
+void UnlinkFile(fuse_req_t req, File::ScopeLocked& file, SharedLockW& fileLock)
+{
+    FuseInodes& inodes { GetInodes(req) };
+    const fuse_ino_t ino { inodes.FindIno(*file) };
+    if (ino && inodes.isOpen(ino))
+    {
+        file->Rename(".fuse_hidden"+std::to_string(ino), fileLock, true);
+        if (inodes.SetUnlinked(ino)) return; // else released meanwhile
+    }
+
+    // need an Item lock to pass to delete, cast from File
+    Item::ScopeLocked item { Item::ScopeLocked::FromChild(std::move(file)) };
+    item->Delete(item, fileLock);
+}
+
+/*****************************************************/
+/** Unlinks the file with the given name in folder if it is open, before it is overwritten (see UnlinkFile) */
+void UnlinkOpenTarget(fuse_req_t req, Folder& folder, const std::string& name)
+{
+    Item::ScopeLocked item;
+    try { item = folder.GetItemByPath(name); }
+    catch (const Folder::NotFoundException&) { return; }
+    if (item->GetType() != Item::Type::FILE) return;
+
+    const FuseInodes& inodes { GetInodes(req) };
+    const fuse_ino_t ino { inodes.FindIno(*item) };
+    if (!ino || !inodes.isOpen(ino)) return;
+
+    File::ScopeLocked file { File::ScopeLocked::FromBase(std::move(item)) };
+    SharedLockW fileLock { file->GetWriteLock() };
+    UnlinkFile(req, file, fileLock);
+}
+
+/*****************************************************/
+void item_stat(fuse_req_t req, const Item::ScopeLocked& item, const SharedLockR& itemLock, const fuse_ino_t ino, struct stat* stbuf)
+{
+    const fuse_ctx* const ctx { fuse_req_ctx(req) };
+    AndromedaFuse::item_stat(item, itemLock, GetFuseAdapter(req).GetOptions(), ctx->uid, ctx->gid, stbuf);
+    stbuf->st_ino = ino;
+}
+
+/*****************************************************/
+/** Fills in entry for the given item and increments its lookup count - must be replied to! */
+void FillEntry(fuse_req_t req, Item::ScopeLocked& item, struct fuse_entry_param& entry)
+{
+    entry.ino = GetInodes(req).Lookup(*item);
+    entry.attr_timeout = GetAttrTimeout(req);
+    entry.entry_timeout = GetEntryTimeout(req);
+    item_stat(req, item, item->GetReadLock(), entry.ino, &entry.attr);
+}
+
+/*****************************************************/
+/** 
+ * Runs func (which must reply on success) with CatchAsErrno, replying with any error
+ * @param ino the inode being operated on for debug
+ * @param name the name being operated on for debug, if any
+ */
+void CatchAsReply(fuse_req_t req, const char* const fname, const std::function<int()>& func, const fuse_ino_t ino, const char* const name = nullptr)
+{
+    const std::string path { std::to_string(ino)+(name ? std::string("/")+name : "") };
+
+    const int retval { CatchAsErrno(fname, [&]()->int
+    {
+        try { return func(); }
+        catch (const FuseInodes::StaleException& e)
+        {
+            SDBG_INFO(": " << fname << "... " << path << ": " << e.what()); return -ESTALE;
+        }
+    }, path.c_str()) };
+
+    if (retval != FUSE_SUCCESS) fuse_reply_err(req, -retval);
+}
+
+} // anonymous namespace
+
+/*****************************************************/
+void FuseLowLevel::init(void* userdata, struct fuse_conn_info* conn)
+{
+    SDBG_INFO("()");
+
+    conn->time_gran = 1000; // PHP microseconds
+
+    SDBG_INFO("... conn->caps: " << std::bitset<32>(conn->capable));
+    SDBG_INFO("... conn->want: " << std::bitset<32>(conn->want));
+
+    conn->want &= ~static_cast<decltype(conn->want)>(FUSE_CAP_HANDLE_KILLPRIV); // don't support setuid and setgid flags
+
+    FuseAdapter& adapter { *static_cast<FuseAdapter*>(userdata) };
+    want_writeback(adapter.GetOptions(), conn);
+    want_splice(conn);
+
+    adapter.SignalInit();
+}
+
+/*****************************************************/
+void FuseLowLevel::lookup(fuse_req_t req, fuse_ino_t parent, const char* name)
+{
+    SDBG_INFO("(parent:" << parent << ", name:" << name << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        Folder::ScopeLocked folder { GetFolder(req, parent) };
+
+        struct fuse_entry_param entry { };
+        try
+        {
+            Item::ScopeLocked item { folder->GetItemByPath(name) };
+            FillEntry(req, item, entry);
+        }
+        catch (const Folder::NotFoundException& e)
+        {
+            entry.ino = 0; // negative entry, kernel caches not-found
+            entry.entry_timeout = NEGATIVE_TIMEOUT;
+        }
+
+        fuse_reply_entry(req, &entry); return FUSE_SUCCESS;
+    }, parent, name);
+}
+
+/*****************************************************/
+void FuseLowLevel::forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup)
+{
+    SDBG_INFO("(ino:" << ino << ", nlookup:" << nlookup << ")");
+
+    GetInodes(req).Forget(ino, nlookup);
+    fuse_reply_none(req);
+}
+
+/*****************************************************/
+void FuseLowLevel::forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data* forgets)
+{
+    SDBG_INFO("(count:" << count << ")");
+
+    FuseInodes& inodes { GetInodes(req) };
+    for (size_t i { 0 }; i < count; ++i)
+        inodes.Forget(forgets[i].ino, forgets[i].nlookup); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    fuse_reply_none(req);
+}
+
+/*****************************************************/
+void FuseLowLevel::getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        const Item::ScopeLocked item { GetItem(req, ino) };
+
+        struct stat stbuf { }; 
+        item_stat(req, item, item->GetReadLock(), ino, &stbuf);
+        fuse_reply_attr(req, &stbuf, GetAttrTimeout(req)); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int to_set, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ", to_set:" << to_set << ")");
+
+    const FuseOptions& options { GetFuseAdapter(req).GetOptions() };
+    if (to_set & FUSE_SET_ATTR_MODE && !options.fakeChmod) { // NOLINT(hicpp-signed-bitwise)
+        fuse_reply_err(req, ENOTSUP); return; }
+    if (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID) && !options.fakeChown) { // NOLINT(hicpp-signed-bitwise)
+        fuse_reply_err(req, ENOTSUP); return; }
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        Item::ScopeLocked item { GetItem(req, ino) };
+
+        if (to_set & FUSE_SET_ATTR_SIZE) // NOLINT(hicpp-signed-bitwise)
+        {
+            if (attr->st_size < 0) return -EINVAL;
+            if (item->GetType() != Item::Type::FILE) return -EISDIR;
+
+            File& file { dynamic_cast<File&>(*item) };
+            const SharedLockW fileLock { file.GetWriteLock() };
+            file.Truncate(static_cast<uint64_t>(attr->st_size), fileLock);
+        }
+
+        // the kernel sets mtime itself with the writeback cache
+        if (to_set & (FUSE_SET_ATTR_MTIME | FUSE_SET_ATTR_MTIME_NOW) && // NOLINT(hicpp-signed-bitwise)
+            item->GetType() == Item::Type::FILE)
+        {
+            File& file { dynamic_cast<File&>(*item) };
+            const SharedLockW fileLock { file.GetWriteLock() };
+            file.SetModified((to_set & FUSE_SET_ATTR_MTIME_NOW) // NOLINT(hicpp-signed-bitwise)
+                ? Item::GetNowDate() : timespec_to_date(attr->st_mtim), fileLock);
+        }
+
+        // mode and owner are no-ops like FuseOperations::chmod/chown
+        // atime is ignored as it is not stored locally or sent to the backend (like FuseOperations::utimens)
+
+        struct stat stbuf { }; 
+        item_stat(req, item, item->GetReadLock(), ino, &stbuf);
+        fuse_reply_attr(req, &stbuf, GetAttrTimeout(req)); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::mkdir(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode)
+{
+    SDBG_INFO("(parent:" << parent << ", name:" << name << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        Folder::ScopeLocked folder { GetFolder(req, parent) };
+        { const SharedLockW folderLock { folder->GetWriteLock() };
+            folder->CreateFolder(name, folderLock); }
+
+        Item::ScopeLocked item { folder->GetItemByPath(name) };
+        struct fuse_entry_param entry { };
+        FillEntry(req, item, entry);
+        fuse_reply_entry(req, &entry); return FUSE_SUCCESS;
+    }, parent, name);
+}
+
+/*****************************************************/
+void FuseLowLevel::unlink(fuse_req_t req, fuse_ino_t parent, const char* name)
+{
+    SDBG_INFO("(parent:" << parent << ", name:" << name << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        Folder::ScopeLocked folder { GetFolder(req, parent) };
+        File::ScopeLocked file { folder->GetFileByPath(name) };
+        SharedLockW fileLock { file->GetWriteLock() };
+
+        UnlinkFile(req, file, fileLock);
+        fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+    }, parent, name);
+}
+
+/*****************************************************/
+void FuseLowLevel::rmdir(fuse_req_t req, fuse_ino_t parent, const char* name)
+{
+    SDBG_INFO("(parent:" << parent << ", name:" << name << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        Folder::ScopeLocked folder { GetFolder(req, parent) };
+        Folder::ScopeLocked subfolder { folder->GetFolderByPath(name) };
+        SharedLockW subfolderLock { subfolder->GetWriteLock() };
+
+        if (subfolder->CountItems(subfolderLock)) return -ENOTEMPTY;
+
+        // need an Item lock to pass to delete, cast from Folder
+        Item::ScopeLocked item { Item::ScopeLocked::FromChild(std::move(subfolder)) };
+
+        item->Delete(item, subfolderLock);
+        fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+    }, parent, name);
+}
+
+/*****************************************************/
+void FuseLowLevel::rename(fuse_req_t req, fuse_ino_t parent, const char* name, fuse_ino_t newparent, const char* newname, unsigned int flags)
+{
+    SDBG_INFO("(parent:" << parent << ", name:" << name << ", newparent:" << newparent << ", newname:" << newname << ")");
+
+    if (flags) { fuse_reply_err(req, EINVAL); return; } // no RENAME_NOREPLACE/EXCHANGE
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        const std::string newName { newname };
+        if (parent != newparent && name != newName)
+        {
+            SDBG_ERROR("NOT SUPPORTED YET!"); // NOLINT(bugprone-lambda-function-name)
+            return -EIO; // TODO implement me (must be a single step)
+        }
+        else if (parent != newparent)
+        {
+            // the kernel already checks that a directory isn't moved into itself
+            // lock ordering is important here! parent first
+            Folder::ScopeLocked folder { GetFolder(req, newparent) };
+            UnlinkOpenTarget(req, *folder, name);
+            Item::ScopeLocked item { GetFolder(req, parent)->GetItemByPath(name) };
+            SharedLockW itemLock { item->GetWriteLock() };
+            item->Move(*folder, itemLock, true);
+        }
+        else if (name != newName)
+        {
+            Folder::ScopeLocked folder { GetFolder(req, parent) };
+            UnlinkOpenTarget(req, *folder, newName);
+            Item::ScopeLocked item { folder->GetItemByPath(name) };
+            SharedLockW itemLock { item->GetWriteLock() };
+            item->Rename(newName, itemLock, true);
+        }
+
+        fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+    }, parent, name);
+}
+
+/*****************************************************/
+void FuseLowLevel::create(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(parent:" << parent << ", name:" << name << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        Folder::ScopeLocked folder { GetFolder(req, parent) };
+        { const SharedLockW folderLock { folder->GetWriteLock() };
+            folder->CreateFile(name, folderLock); }
+
+        File::ScopeLocked file { folder->GetFileByPath(name) };
+        std::unique_ptr<FuseFileHandle> handle { std::make_unique<FuseFileHandle>(*file, fi->flags) };
+
+        Item::ScopeLocked item { Item::ScopeLocked::FromChild(std::move(file)) };
+        struct fuse_entry_param entry { };
+        FillEntry(req, item, entry);
+
+        SetHandle(fi, std::move(handle));
+        GetInodes(req).Open(entry.ino);
+        if (fuse_reply_create(req, &entry, fi) != FUSE_SUCCESS)
+        {
+            // interrupted, the kernel won't forget or release
+            GetInodes(req).Release(entry.ino);
+            GetInodes(req).Forget(entry.ino, 1);
+            TakeHandle<FuseFileHandle>(fi);
+        }
+        return FUSE_SUCCESS;
+    }, parent, name);
+}
+
+/*****************************************************/
+void FuseLowLevel::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ", flags:" << fi->flags << ")");
+
+    const char* const fname { __func__ };
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        File::ScopeLocked file { GetFile(req, ino) };
+        const SharedLockW fileLock { file->GetWriteLock() };
+
+        if ((fi->flags & O_WRONLY || fi->flags & O_RDWR) && file->isReadOnlyFS()) // NOLINT(hicpp-signed-bitwise)
+        {
+            sDebug.Info([&](std::ostream& str){ 
+                str << fname << "... read-only FS!"; });
+            return -EROFS;
+        }
+
+        std::unique_ptr<FuseFileHandle> handle { std::make_unique<FuseFileHandle>(*file, fi->flags) };
+
+        if (fi->flags & O_TRUNC) // NOLINT(hicpp-signed-bitwise)
+        {
+            sDebug.Info([&](std::ostream& str){ 
+                str << fname << "... truncating!"; });
+            file->Truncate(0, fileLock);
+        }
+
+        // keep the kernel's page cache if the file didn't change since it was cached
+        fi->keep_cache = GetInodes(req).CheckCached(ino, 
+            file->GetSize(fileLock), file->GetModified(fileLock));
+
+        SetHandle(fi, std::move(handle));
+        GetInodes(req).Open(ino);
+        if (fuse_reply_open(req, fi) != FUSE_SUCCESS)
+        {
+            // interrupted, won't be released
+            GetInodes(req).Release(ino);
+            TakeHandle<FuseFileHandle>(fi);
+        }
+        return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ", offset:" << off << ", size:" << size << ")");
+
+    if (off < 0) { fuse_reply_err(req, EINVAL); return; }
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        FuseFileHandle& handle { GetHandle<FuseFileHandle>(fi) };
+        File::ScopeLocked file { GetOpenFile(handle) };
+        const SharedLockR fileLock { file->GetReadLock() };
+
+        if (!handle.UpdateSequential(static_cast<uint64_t>(off), size))
+        {
+            // copy random reads into a reply buffer - pages are still cached, but a whole 
+            // uncached page is received straight into the buffer too (see PageManager::ReadPage)
+            std::vector<char> buf(size);
+            const size_t read { file->ReadBytesMax(buf.data(), static_cast<uint64_t>(off), size, fileLock) };
+            fuse_reply_buf(req, buf.data(), read); return FUSE_SUCCESS;
+        }
+
+        // reference the resident pages, the reply is written straight from them
+        std::vector<struct iovec> iov;
+        file->ReadBytesRefMax([&](const char* data, const size_t length){
+            iov.push_back({const_cast<char*>(data), length}); }, // NOLINT(cppcoreguidelines-pro-type-const-cast)
+            static_cast<uint64_t>(off), size, fileLock);
+
+        if (iov.empty()) fuse_reply_buf(req, nullptr, 0); // EOF
+        else fuse_reply_iov(req, iov.data(), static_cast<int>(iov.size())); // while still locked
+        return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::write_buf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec* bufv, off_t off, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ", offset:" << off << ", size:" << fuse_buf_size(bufv) << ")");
+
+    if (off < 0) { fuse_reply_err(req, EINVAL); return; }
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        FuseFileHandle& handle { GetHandle<FuseFileHandle>(fi) };
+        File::ScopeLocked file { GetOpenFile(handle) };
+        const SharedLockW fileLock { file->GetWriteLock() };
+
+        const size_t written { write_bufvec(*file, bufv, static_cast<uint64_t>(off), fileLock) };
+        fuse_reply_write(req, written); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        File::ScopeLocked file { GetOpenFile(GetHandle<FuseFileHandle>(fi)) };
+        // the dirty state is kept on the file, the writeback cache or mmap may write through another handle
+        { const SharedLockR fileLock { file->GetReadLock() };
+            if (!file->isDirty(fileLock)) { // nothing to flush
+                fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS; } }
+
+        const SharedLockW fileLock { file->GetWriteLock() };
+        file->FlushCache(fileLock);
+        // the kernel's page cache includes our own writes
+        GetInodes(req).CheckCached(ino, file->GetSize(fileLock), file->GetModified(fileLock));
+        fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ", flags:" << fi->flags << ")");
+
+    const std::unique_ptr<FuseFileHandle> handle { TakeHandle<FuseFileHandle>(fi) };
+    const bool unlinked { GetInodes(req).Release(ino) };
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        File::ScopeLocked file { handle->TryLockFile() };
+        if (!file) { fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS; } // already deleted
+
+        if (!unlinked) // nothing to flush (see flush)
+        { const SharedLockR fileLock { file->GetReadLock() };
+            if (!file->isDirty(fileLock)) { fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS; } }
+
+        SharedLockW fileLock { file->GetWriteLock() };
+
+        if (unlinked) // last handle of a hidden file, no need to flush
+        {
+            Item::ScopeLocked item { Item::ScopeLocked::FromChild(std::move(file)) };
+            item->Delete(item, fileLock);
+            fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+        }
+
+        file->FlushCache(fileLock);
+        // the kernel's page cache includes our own writes
+        GetInodes(req).CheckCached(ino, file->GetSize(fileLock), file->GetModified(fileLock));
+        fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        FuseFileHandle& handle { GetHandle<FuseFileHandle>(fi) };
+        File::ScopeLocked file { GetOpenFile(handle) };
+        const SharedLockW fileLock { file->GetWriteLock() };
+
+        file->FlushCache(fileLock);
+        fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ", flags:" << fi->flags << ")");
+
+    const char* const fname { __func__ };
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        const Folder::ScopeLocked folder { GetFolder(req, ino) };
+
+        if ((fi->flags & O_WRONLY || fi->flags & O_RDWR) && folder->isReadOnlyFS()) // NOLINT(hicpp-signed-bitwise)
+        {
+            sDebug.Info([&](std::ostream& str){ 
+                str << fname << "... read-only FS!"; });
+            return -EROFS;
+        }
+
+        SetHandle(fi, std::make_unique<OpenDir>());
+        if (fuse_reply_open(req, fi) != FUSE_SUCCESS)
+            TakeHandle<OpenDir>(fi); // interrupted, won't be released
+        return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ", offset:" << off << ", size:" << size << ")");
+
+    if (off < 0) { fuse_reply_err(req, EINVAL); return; }
+
+    const char* const fname { __func__ };
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        OpenDir& handle { GetHandle<OpenDir>(fi) };
+        if (off == 0 || handle.mEntries.empty()) // (re)load, later offsets continue the snapshot
+        {
+            Folder::LockedItemMap items; { // lock scope
+                Folder::ScopeLocked folder { GetFolder(req, ino) };
+                items = folder->GetItems(folder->GetWriteLock());
+            }
+
+            sDebug.Info([&](std::ostream& str){ 
+                str << fname << "... #items:" << items.size(); });
+
+            handle.mEntries.clear();
+            handle.mEntries.reserve(items.size()+2);
+            handle.mEntries.emplace_back(".", S_IFDIR);
+            handle.mEntries.emplace_back("..", S_IFDIR);
+
+            for (const Folder::LockedItemMap::value_type& pair : items)
+            {
+                const Item::ScopeLocked& item { pair.second };
+                handle.mEntries.emplace_back(pair.first, 
+                    item->GetType() == Item::Type::FOLDER ? S_IFDIR : S_IFREG);
+            }
+        }
+
+        std::vector<char> buf(size);
+        size_t bufSize { 0 };
+        for (size_t idx { static_cast<size_t>(off) }; idx < handle.mEntries.size(); ++idx)
+        {
+            struct stat stbuf { };
+            stbuf.st_ino = UNKNOWN_INO;
+            stbuf.st_mode = handle.mEntries[idx].second;
+
+            // the offset of an entry is the offset of the next one
+            const size_t entSize { fuse_add_direntry(req, buf.data()+bufSize, size-bufSize, 
+                handle.mEntries[idx].first.c_str(), &stbuf, static_cast<off_t>(idx+1)) };
+            if (entSize > size-bufSize) break; // buffer full
+
+            bufSize += entSize;
+        }
+
+        fuse_reply_buf(req, buf.data(), bufSize); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ")");
+
+    TakeHandle<OpenDir>(fi);
+    fuse_reply_err(req, FUSE_SUCCESS);
+}
+
+/*****************************************************/
+void FuseLowLevel::fsyncdir(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info* fi)
+{
+    SDBG_INFO("(ino:" << ino << ")");
+
+    CatchAsReply(req, __func__, [&]()->int
+    {
+        Folder::ScopeLocked folder { GetFolder(req, ino) };
+        const SharedLockW folderLock { folder->GetWriteLock() };
+
+        folder->FlushCache(folderLock);
+        fuse_reply_err(req, FUSE_SUCCESS); return FUSE_SUCCESS;
+    }, ino);
+}
+
+/*****************************************************/
+void FuseLowLevel::statfs(fuse_req_t req, fuse_ino_t ino)
+{
+    SDBG_INFO("(ino:" << ino << ")");
+
+    struct statvfs buf { };
+    FuseOperations::statfs("/", &buf); // no path needed
+    fuse_reply_statfs(req, &buf);
+}
+
+} // namespace AndromedaFuse
+
+#endif // A2FUSE_LOWLEVEL
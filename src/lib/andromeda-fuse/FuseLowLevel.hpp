@@ -0,0 +1,76 @@
+
+#ifndef A2FUSE_FUSELOWLEVEL_H_
+#define A2FUSE_FUSELOWLEVEL_H_
+
+#include "libfuse_Includes.h"
+
+#if A2FUSE_LOWLEVEL
+
+namespace AndromedaFuse {
+
+/** 
+ * Static low-level (inode-based) FUSE functions
+ * Inodes map directly to items via FuseInodes and open files/dirs keep a handle in fi->fh,
+ * so unlike FuseOperations no operation needs to resolve a full path from the root
+ */
+struct FuseLowLevel
+{
+    static void init(void* userdata, struct fuse_conn_info* conn);
+    static void lookup(fuse_req_t req, fuse_ino_t parent, const char* name);
+    static void forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup);
+    static void forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data* forgets);
+    static void getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
+    static void setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int to_set, struct fuse_file_info* fi);
+    static void mkdir(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode);
+    static void unlink(fuse_req_t req, fuse_ino_t parent, const char* name);
+    static void rmdir(fuse_req_t req, fuse_ino_t parent, const char* name);
+    static void rename(fuse_req_t req, fuse_ino_t parent, const char* name, fuse_ino_t newparent, const char* newname, unsigned int flags);
+    static void create(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode, struct fuse_file_info* fi);
+    static void open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
+    static void read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi);
+    static void write_buf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec* bufv, off_t off, struct fuse_file_info* fi);
+    static void flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
+    static void release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
+    static void fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info* fi);
+    static void opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
+    static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi);
+    static void releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
+    static void fsyncdir(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info* fi);
+    static void statfs(fuse_req_t req, fuse_ino_t ino);
+};
+
+} // namespace AndromedaFuse
+
+/** fuse_lowlevel_ops mapped to Andromeda functions */
+struct a2fuse_lowlevel_ops : public fuse_lowlevel_ops
+{
+    a2fuse_lowlevel_ops() : fuse_lowlevel_ops() // zero-init base
+    {
+        init = AndromedaFuse::FuseLowLevel::init;
+        lookup = AndromedaFuse::FuseLowLevel::lookup;
+        forget = AndromedaFuse::FuseLowLevel::forget;
+        forget_multi = AndromedaFuse::FuseLowLevel::forget_multi;
+        getattr = AndromedaFuse::FuseLowLevel::getattr;
+        setattr = AndromedaFuse::FuseLowLevel::setattr;
+        mkdir = AndromedaFuse::FuseLowLevel::mkdir;
+        unlink = AndromedaFuse::FuseLowLevel::unlink;
+        rmdir = AndromedaFuse::FuseLowLevel::rmdir;
+        rename = AndromedaFuse::FuseLowLevel::rename;
+        create = AndromedaFuse::FuseLowLevel::create;
+        open = AndromedaFuse::FuseLowLevel::open;
+        read = AndromedaFuse::FuseLowLevel::read;
+        write_buf = AndromedaFuse::FuseLowLevel::write_buf;
+        flush = AndromedaFuse::FuseLowLevel::flush;
+        release = AndromedaFuse::FuseLowLevel::release;
+        fsync = AndromedaFuse::FuseLowLevel::fsync;
+        opendir = AndromedaFuse::FuseLowLevel::opendir;
+        readdir = AndromedaFuse::FuseLowLevel::readdir;
+        releasedir = AndromedaFuse::FuseLowLevel::releasedir;
+        fsyncdir = AndromedaFuse::FuseLowLevel::fsyncdir;
+        statfs = AndromedaFuse::FuseLowLevel::statfs;
+    }
+};
+
+#endif // A2FUSE_LOWLEVEL
+
+#endif // A2FUSE_FUSELOWLEVEL_H_
@@ -1,17 +1,13 @@
 
 #include <cerrno>
-#if WIN32
-#define EHOSTDOWN EIO
-#endif // WIN32
 
 #include <bitset>
-#include <functional>
 
 #include "FuseAdapter.hpp"
+#include "FuseCommon.hpp"
+#include "FuseFileHandle.hpp"
 #include "FuseOperations.hpp"
 
-#include "andromeda/BaseException.hpp"
-using Andromeda::BaseException;
 #include "andromeda/Debug.hpp"
 using Andromeda::Debug;
 #include "andromeda/SharedMutex.hpp"
@@ -19,18 +15,12 @@ using Andromeda::SharedLockR;
 using Andromeda::SharedLockW;
 #include "andromeda/StringUtil.hpp"
 using Andromeda::StringUtil;
-#include "andromeda/backend/BackendImpl.hpp"
-using Andromeda::Backend::BackendImpl;
-#include "andromeda/backend/HTTPRunner.hpp"
-using Andromeda::Backend::HTTPRunner;
 #include "andromeda/filesystem/Item.hpp"
 using Andromeda::Filesystem::Item;
 #include "andromeda/filesystem/File.hpp"
 using Andromeda::Filesystem::File;
 #include "andromeda/filesystem/Folder.hpp"
 using Andromeda::Filesystem::Folder;
-#include "andromeda/filesystem/filedata/CacheManager.hpp"
-using Andromeda::Filesystem::Filedata::CacheManager;
 
 namespace AndromedaFuse {
 
@@ -63,81 +53,23 @@ inline Folder::ScopeLocked GetFolderByPath(const std::string& path)
 }
 
 /*****************************************************/
-int CatchAsErrno(const char* const fname, const std::function<int()>& func, const char* const path)
+/** Returns the file for fi's open handle without a path lookup, or by path if none or deleted */
+File::ScopeLocked GetFileByHandle(const std::string& path, const struct fuse_file_info* const fi)
 {
-    try { return func(); }
-
-    #define SDBG_INFO_EXC(e) SDBG_INFO(": " << fname << "... " << path << ": " << e.what());
-    #define SDBG_ERROR_EXC(e) SDBG_ERROR(": " << fname << "... " << path << ": " << e.what());
-
-    // Item exceptions
-    catch (const Folder::NotFileException& e)
-    {
-        SDBG_INFO_EXC(e); return -EISDIR;
-    }
-    catch (const Folder::NotFolderException& e)
-    {
-        SDBG_INFO_EXC(e); return -ENOTDIR;
-    }
-    catch (const Folder::NotFoundException& e)
-    {
-        SDBG_INFO_EXC(e); return -ENOENT;
-    }
-    catch (const Folder::DuplicateItemException& e)
-    {
-        SDBG_INFO_EXC(e); return -EEXIST;
-    }
-    catch (const Folder::ModifyException& e)
-    {
-        SDBG_ERROR_EXC(e); return -ENOTSUP;
-    }
-    catch (const File::WriteTypeException& e)
-    {
-        SDBG_ERROR_EXC(e); return -ENOTSUP;
-    }
-    catch (const Item::ReadOnlyFSException& e)
-    {
-        SDBG_INFO_EXC(e); return -EROFS;
-    }
-    catch (const Item::NullParentException& e)
-    {
-        SDBG_ERROR_EXC(e); return -ENOTSUP;
-    }
-    catch (const CacheManager::MemoryException& e)
-    {
-        SDBG_ERROR_EXC(e); return -ENOMEM;
-    }
-
-    // Backend exceptions
-    catch (const BackendImpl::UnsupportedException& e)
-    {
-        SDBG_ERROR_EXC(e); return -ENOTSUP;
-    }
-    catch (const BackendImpl::ReadOnlyFSException& e)
-    {
-        SDBG_INFO_EXC(e); return -EROFS;
-    }
-    catch (const BackendImpl::DeniedException& e)
-    {
-        SDBG_INFO_EXC(e); return -EACCES;
-    }
-    catch (const BackendImpl::NotFoundException& e)  
-    {
-        SDBG_INFO_EXC(e); return -ENOENT;
-    }
-    catch (const BackendImpl::WriteSizeException& e)
-    {
-        SDBG_ERROR_EXC(e); return -ENOTSUP;
-    }
-    catch (const HTTPRunner::ConnectionException& e)
+    if (fi != nullptr && fi->fh != 0)
     {
-        SDBG_ERROR_EXC(e); return -EHOSTDOWN;
+        File::ScopeLocked file { GetHandle<FuseFileHandle>(fi).TryLockFile() };
+        if (file) return file;
     }
+    return GetFileByPath(path);
+}
 
-    catch (const BaseException& e) // anything else
-    {
-        SDBG_ERROR_EXC(e); return -EIO;
-    }
+/*****************************************************/
+inline void item_stat(const Item::ScopeLocked& item, const SharedLockR& itemLock, struct stat* stbuf)
+{
+    const fuse_context* fuse_context { fuse_get_context() };
+    AndromedaFuse::item_stat(item, itemLock, GetFuseAdapter().GetOptions(), 
+        fuse_context->uid, fuse_context->gid, stbuf);
 }
 
 } // anonymous namespace
@@ -154,17 +86,24 @@ void* FuseOperations::init(struct fuse_conn_info* conn, struct fuse_config* cfg)
 #if !LIBFUSE2
     conn->time_gran = 1000; // PHP microseconds
     cfg->negative_timeout = 1;
+
+    const FuseOptions& options { GetFuseAdapter().GetOptions() };
+    cfg->attr_timeout = static_cast<double>(options.attrTimeout.count());
+    cfg->entry_timeout = static_cast<double>(options.entryTimeout.count());
+    cfg->auto_cache = 1; // keep the page cache on open if mtime/size are unchanged
 #endif // !LIBFUSE2
 
     SDBG_INFO("... conn->caps: " << std::bitset<32>(conn->capable));
     SDBG_INFO("... conn->want: " << std::bitset<32>(conn->want));
 
+    FuseAdapter& adapter { GetFuseAdapter() };
+
 #if !LIBFUSE2
     conn->want &= ~static_cast<decltype(conn->want)>(FUSE_CAP_HANDLE_KILLPRIV); // don't support setuid and setgid flags
+    want_writeback(adapter.GetOptions(), conn);
+    want_splice(conn);
 #endif // !LIBFUSE2
 
-    FuseAdapter& adapter { GetFuseAdapter() };
-
     adapter.SignalInit();
     return static_cast<void*>(&adapter);
 }
@@ -210,80 +149,6 @@ int FuseOperations::statfs(const char *path, struct statvfs* buf)
     return FUSE_SUCCESS;
 }
 
-// TODO if Windows calls utimens then the conversion of timespec->double->timespec will not match
-// maybe the server will need to actually store timespec sec/nsec...? may be important for syncing
-
-namespace { // anonymous
-
-/*****************************************************/
-constexpr Item::Date timespec_to_date(const timespec& t)
-{ 
-    return static_cast<Item::Date>(t.tv_sec) + static_cast<Item::Date>(t.tv_nsec)/1e9; 
-}
-
-/*****************************************************/
-constexpr void date_to_timespec(const Item::Date time, timespec& spec)
-{
-    spec.tv_sec = static_cast<decltype(spec.tv_sec)>(time); // truncate to int
-    spec.tv_nsec = static_cast<decltype(spec.tv_nsec)>((time-static_cast<Item::Date>(spec.tv_sec))*1e9);
-}
-
-} // anonymous namespace
-
-/*****************************************************/
-namespace { void item_stat(const Item::ScopeLocked& item, const SharedLockR& itemLock, struct stat* stbuf)
-{    
-    const Item::Type itemType { item->GetType() };
-    if (itemType == Item::Type::FILE)
-    {
-        stbuf->st_mode = S_IFREG | static_cast<decltype(stbuf->st_mode)>(
-            GetFuseAdapter().GetOptions().fileMode); 
-
-        const File& file { dynamic_cast<const File&>(*item) };
-        stbuf->st_size = static_cast<decltype(stbuf->st_size)>(file.GetSize(itemLock));
-        stbuf->st_blksize = static_cast<decltype(stbuf->st_blksize)>(file.GetPageSize());
-    }
-    else if (itemType == Item::Type::FOLDER)
-    {
-        stbuf->st_mode = S_IFDIR | static_cast<decltype(stbuf->st_mode)>(
-            GetFuseAdapter().GetOptions().dirMode);
-
-        stbuf->st_size = 0;
-        stbuf->st_blksize = 4096; // meaningless?
-    }
-
-    const fuse_context* fuse_context { fuse_get_context() };
-    stbuf->st_uid = fuse_context->uid;
-    stbuf->st_gid = fuse_context->gid;
-
-    stbuf->st_blocks = !stbuf->st_size ? 0 :
-        (stbuf->st_size-1)/512+1; // # of 512B blocks
-
-    const Item::Date created { item->GetCreated(itemLock) };
-    const Item::Date modified { item->GetModified(itemLock) };
-    const Item::Date accessed { item->GetAccessed(itemLock) };
-
-#if WIN32
-    date_to_timespec(created, stbuf->st_birthtim);
-#endif // WIN32
-
-#ifdef APPLE
-    stbuf->st_ctime = static_cast<decltype(stbuf->st_ctime)>(created);
-    stbuf->st_mtime = static_cast<decltype(stbuf->st_mtime)>(modified);
-    stbuf->st_atime = static_cast<decltype(stbuf->st_atime)>(accessed);
-
-    if (!stbuf->st_mtime) stbuf->st_mtime = stbuf->st_ctime;
-    if (!stbuf->st_atime) stbuf->st_atime = stbuf->st_atime;
-#else // !APPLE
-    date_to_timespec(created, stbuf->st_ctim);
-    date_to_timespec(modified, stbuf->st_mtim);
-    date_to_timespec(accessed, stbuf->st_atim);
-    
-    if (modified == 0) stbuf->st_mtim = stbuf->st_ctim;
-    if (accessed == 0) stbuf->st_atim = stbuf->st_ctim;
-#endif // APPLE
-} } // anonymous namespace
-
 /*****************************************************/
 int FuseOperations::open(const char* const path, struct fuse_file_info* const fi)
 {
@@ -305,6 +170,8 @@ int FuseOperations::open(const char* const path, struct fuse_file_info* const fi
             return -EROFS;
         }
 
+        std::unique_ptr<FuseFileHandle> handle { std::make_unique<FuseFileHandle>(*file, fi->flags) };
+
         if (fi->flags & O_TRUNC) // NOLINT(hicpp-signed-bitwise)
         {
             sDebug.Info([&](std::ostream& str){ 
@@ -312,7 +179,7 @@ int FuseOperations::open(const char* const path, struct fuse_file_info* const fi
             file->Truncate(0, fileLock);
         }
 
-        return FUSE_SUCCESS;
+        SetHandle(fi, std::move(handle)); return FUSE_SUCCESS;
     }, path);
 }
 
@@ -350,7 +217,12 @@ int FuseOperations::getattr(const char* const path, struct stat* stbuf, struct f
 
     return CatchAsErrno(__func__,[&]()->int
     {
+    #if !LIBFUSE2
+        Item::ScopeLocked item { (fi != nullptr && fi->fh != 0) ? // fstat
+            Item::ScopeLocked::FromChild(GetFileByHandle(path, fi)) : GetItemByPath(path) };
+    #else // LIBFUSE2
         Item::ScopeLocked item { GetItemByPath(path) };
+    #endif // LIBFUSE2
         item_stat(item, item->GetReadLock(), stbuf); return FUSE_SUCCESS;
     }, path);
 }
@@ -426,9 +298,13 @@ int FuseOperations::create(const char* fullpath, mode_t mode, struct fuse_file_i
     return CatchAsErrno(__func__,[&]()->int
     {
         Folder::ScopeLocked parent { GetFolderByPath(path) };
-        const SharedLockW parentLock { parent->GetWriteLock() };
+        { const SharedLockW parentLock { parent->GetWriteLock() };
+            parent->CreateFile(name, parentLock); }
+
+        File::ScopeLocked file { parent->GetFileByPath(name) };
+        std::unique_ptr<FuseFileHandle> handle { std::make_unique<FuseFileHandle>(*file, fi->flags) };
 
-        parent->CreateFile(name, parentLock); return FUSE_SUCCESS;
+        SetHandle(fi, std::move(handle)); return FUSE_SUCCESS;
     }, fullpath);
 }
 
@@ -548,7 +424,7 @@ int FuseOperations::read(const char* const path, char* buf, size_t size, off_t o
 
     return CatchAsErrno(__func__,[&]()->int
     {
-        File::ScopeLocked file { GetFileByPath(path) };
+        File::ScopeLocked file { GetFileByHandle(path, fi) };
         const SharedLockR fileLock { file->GetReadLock() };
 
         return static_cast<int>(file->ReadBytesMax(buf, static_cast<uint64_t>(off), size, fileLock));
@@ -565,7 +441,7 @@ int FuseOperations::write(const char* const path, const char* buf, size_t size,
 
     return CatchAsErrno(__func__,[&]()->int
     {
-        File::ScopeLocked file { GetFileByPath(path) };
+        File::ScopeLocked file { GetFileByHandle(path, fi) };
         const SharedLockW fileLock { file->GetWriteLock() };
 
         file->WriteBytes(buf, static_cast<uint64_t>(off), size, fileLock); 
@@ -574,6 +450,26 @@ int FuseOperations::write(const char* const path, const char* buf, size_t size,
     }, path);
 }
 
+#if A2FUSE_SPLICE
+/*****************************************************/
+int FuseOperations::write_buf(const char* const path, struct fuse_bufvec* buf, off_t off, struct fuse_file_info* const fi)
+{
+    if (path == nullptr) return -EINVAL;
+    SDBG_INFO("(path:" << path << ", offset:" << off << ", size:" << fuse_buf_size(buf) << ")");
+
+    if (off < 0) return -EINVAL;
+
+    return CatchAsErrno(__func__,[&]()->int
+    {
+        File::ScopeLocked file { GetFileByHandle(path, fi) };
+        const SharedLockW fileLock { file->GetWriteLock() };
+
+        const size_t written { write_bufvec(*file, buf, static_cast<uint64_t>(off), fileLock) };
+        return static_cast<int>(written);
+    }, path);
+}
+#endif // A2FUSE_SPLICE
+
 // TODO maybe should only FlushCache() on fsync, not flush? seems to be flush
 // is only for applications->OS and has nothing to do with the storage "media"
 
@@ -585,10 +481,14 @@ int FuseOperations::flush(const char* const path, struct fuse_file_info* const f
 
     return CatchAsErrno(__func__,[&]()->int
     {
-        File::ScopeLocked file { GetFileByPath(path) };
-        const SharedLockW fileLock { file->GetWriteLock() };
+        File::ScopeLocked file { GetFileByHandle(path, fi) };
+        // the dirty state is kept on the file, the writeback cache or mmap may write through another handle
+        { const SharedLockR fileLock { file->GetReadLock() };
+            if (!file->isDirty(fileLock)) return FUSE_SUCCESS; } // nothing to flush
 
-        file->FlushCache(fileLock); return FUSE_SUCCESS;
+        const SharedLockW fileLock { file->GetWriteLock() };
+        file->FlushCache(fileLock);
+        return FUSE_SUCCESS;
     }, path);
 }
 
@@ -600,10 +500,11 @@ int FuseOperations::fsync(const char* const path, int datasync, struct fuse_file
 
     return CatchAsErrno(__func__,[&]()->int
     {
-        File::ScopeLocked file { GetFileByPath(path) };
+        File::ScopeLocked file { GetFileByHandle(path, fi) };
         const SharedLockW fileLock { file->GetWriteLock() };
 
-        file->FlushCache(fileLock); return FUSE_SUCCESS;
+        file->FlushCache(fileLock);
+        return FUSE_SUCCESS;
     }, path);
 }
 
@@ -626,16 +527,22 @@ int FuseOperations::fsyncdir(const char* const path, int datasync, struct fuse_f
 int FuseOperations::release(const char* const path, struct fuse_file_info* const fi) // cppcheck-suppress constParameterCallback
 {
     if (path == nullptr) return -EINVAL;
-    SDBG_INFO("(path:" << path << ", flags:" << fi->flags << ", flush:" << fi->flush << ")");
+    if (fi != nullptr) { SDBG_INFO("(path:" << path << ", flags:" << fi->flags << ", flush:" << fi->flush << ")"); }
+    else { SDBG_INFO("(path:" << path << ")"); }
 
     // TODO this does not seem right.  At least check fi->flush? maybe lowlevel only
     // if you keep it, add matching releasedir
 
+    const std::unique_ptr<FuseFileHandle> handle { (fi != nullptr && fi->fh != 0) ? TakeHandle<FuseFileHandle>(fi) : nullptr };
+
     return CatchAsErrno(__func__,[&]()->int
     {
-        File::ScopeLocked file { GetFileByPath(path) };
-        const SharedLockW fileLock { file->GetWriteLock() };
+        File::ScopeLocked file { handle ? handle->TryLockFile() : File::ScopeLocked() };
+        if (!file) file = GetFileByPath(path);
+        { const SharedLockR fileLock { file->GetReadLock() };
+            if (!file->isDirty(fileLock)) return FUSE_SUCCESS; } // nothing to flush (see flush)
 
+        const SharedLockW fileLock { file->GetWriteLock() };
         file->FlushCache(fileLock); return FUSE_SUCCESS;
     }, path);
 }
@@ -654,10 +561,15 @@ int FuseOperations::truncate(const char* const path, off_t size, struct fuse_fil
 
     return CatchAsErrno(__func__,[&]()->int
     {
+    #if LIBFUSE2
         File::ScopeLocked file { GetFileByPath(path) };
+    #else // !LIBFUSE2
+        File::ScopeLocked file { GetFileByHandle(path, fi) };
+    #endif // LIBFUSE2
         const SharedLockW fileLock { file->GetWriteLock() };
 
-        file->Truncate(static_cast<uint64_t>(size), fileLock); return FUSE_SUCCESS;
+        file->Truncate(static_cast<uint64_t>(size), fileLock);
+        return FUSE_SUCCESS;
     }, path);
 }
 
@@ -701,4 +613,32 @@ int FuseOperations::chown(const char* const path, uid_t uid, gid_t gid, struct f
     }, path);
 }
 
+/*****************************************************/
+#if LIBFUSE2
+int FuseOperations::utimens(const char* const path, const struct timespec tv[2])
+#else
+int FuseOperations::utimens(const char* const path, const struct timespec tv[2], struct fuse_file_info* const fi)
+#endif // LIBFUSE2
+{
+    if (path == nullptr) return -EINVAL;
+    SDBG_INFO("(path:" << path << ")");
+
+    return CatchAsErrno(__func__,[&]()->int
+    {
+        Item::ScopeLocked item { GetItemByPath(path) };
+        // only a file's modified time is supported (the kernel sets it with the writeback cache)
+        if (item->GetType() != Item::Type::FILE) return FUSE_SUCCESS; // no-op
+
+        Item::Date modified { (tv == nullptr) ? Item::GetNowDate() : timespec_to_date(tv[1]) };
+    #ifdef UTIME_NOW
+        if (tv != nullptr && tv[1].tv_nsec == UTIME_OMIT) return FUSE_SUCCESS;
+        if (tv != nullptr && tv[1].tv_nsec == UTIME_NOW) modified = Item::GetNowDate();
+    #endif // UTIME_NOW
+
+        File& file { dynamic_cast<File&>(*item) };
+        const SharedLockW fileLock { file.GetWriteLock() };
+        file.SetModified(modified, fileLock); return FUSE_SUCCESS;
+    }, path);
+}
+
 } // namespace AndromedaFuse
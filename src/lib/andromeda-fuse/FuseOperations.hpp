@@ -19,6 +19,9 @@ struct FuseOperations
     static int rmdir(const char* path);
     static int read(const char* path, char* buf, size_t size, off_t off, struct fuse_file_info* fi);
     static int write(const char* path, const char* buf, size_t size, off_t off, struct fuse_file_info* fi);
+    #if A2FUSE_SPLICE
+    static int write_buf(const char* path, struct fuse_bufvec* buf, off_t off, struct fuse_file_info* fi);
+    #endif // A2FUSE_SPLICE
     static int flush(const char* path, struct fuse_file_info* fi);
     static int fsync(const char* path, int datasync, struct fuse_file_info* fi);
     static int fsyncdir(const char* path, int datasync, struct fuse_file_info* fi);
@@ -32,6 +35,7 @@ struct FuseOperations
     static int truncate(const char* path, off_t size);
     static int chmod(const char* path, mode_t mode);
     static int chown(const char* path, uid_t uid, gid_t gid);
+    static int utimens(const char* path, const struct timespec tv[2]);
     #else // !LIBFUSE2
     static void* init(struct fuse_conn_info* conn, struct fuse_config* cfg);
     static int getattr(const char* path, struct stat* stbuf, struct fuse_file_info* fi);
@@ -40,6 +44,7 @@ struct FuseOperations
     static int truncate(const char* path, off_t size, struct fuse_file_info* fi);
     static int chmod(const char* path, mode_t mode, struct fuse_file_info* fi);
     static int chown(const char* path, uid_t uid, gid_t gid, struct fuse_file_info* fi);
+    static int utimens(const char* path, const struct timespec tv[2], struct fuse_file_info* fi);
     #endif // LIBFUSE2
 };
 
@@ -58,9 +63,13 @@ struct a2fuse_operations : public fuse_operations
         chmod = AndromedaFuse::FuseOperations::chmod;
         chown = AndromedaFuse::FuseOperations::chown;
         truncate = AndromedaFuse::FuseOperations::truncate;
+        utimens = AndromedaFuse::FuseOperations::utimens;
         open = AndromedaFuse::FuseOperations::open;
         read = AndromedaFuse::FuseOperations::read;
         write = AndromedaFuse::FuseOperations::write;
+    #if A2FUSE_SPLICE
+        write_buf = AndromedaFuse::FuseOperations::write_buf;
+    #endif // A2FUSE_SPLICE
         statfs = AndromedaFuse::FuseOperations::statfs;
         flush = AndromedaFuse::FuseOperations::flush;
         release = AndromedaFuse::FuseOperations::release;
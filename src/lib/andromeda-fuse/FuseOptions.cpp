@@ -19,12 +19,20 @@ std::string FuseOptions::HelpText()
     using std::endl;
 
     output << "FUSE Advanced:    [--no-chmod] [--no-chown]"
+        << " [--fuse-attr-timeout secs(" << optDefault.attrTimeout.count() << ")]"
+        << " [--fuse-entry-timeout secs(" << optDefault.entryTimeout.count() << ")]"
     #ifndef OPENBSD
         << " [--no-fuse-threading]"
     #endif // !OPENBSD
     #if !LIBFUSE2
         << " [--fuse-max-idle-threads uint32(" << optDefault.maxIdleThreads << ")]"
     #endif // !LIBFUSE2
+    #if A2FUSE_LOWLEVEL
+        << " [--fuse-lowlevel]"
+    #endif // A2FUSE_LOWLEVEL
+    #if A2FUSE_WRITEBACK
+        << " [--fuse-writeback-cache]"
+    #endif // A2FUSE_WRITEBACK
         << " [-o fuseoption]+"; 
     
 #if !LIBFUSE2
@@ -59,6 +67,14 @@ bool FuseOptions::AddFlag(const std::string& flag)
     else if (flag == "no-fuse-threading")
         enableThreading = false;
 #endif // !OPENBSD
+#if A2FUSE_LOWLEVEL
+    else if (flag == "fuse-lowlevel")
+        lowLevel = true;
+#endif // A2FUSE_LOWLEVEL
+#if A2FUSE_WRITEBACK
+    else if (flag == "fuse-writeback-cache")
+        writebackCache = true;
+#endif // A2FUSE_WRITEBACK
 #if !LIBFUSE2
     else if (flag == "dump-fuse-options")
     {
@@ -92,6 +108,18 @@ bool FuseOptions::AddOption(const std::string& option, const std::string& value)
         catch (const std::logic_error& e) { 
             throw BaseOptions::BadValueException(option); }
     }
+    else if (option == "fuse-attr-timeout")
+    {
+        try { attrTimeout = decltype(attrTimeout)(stoul(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+    }
+    else if (option == "fuse-entry-timeout")
+    {
+        try { entryTimeout = decltype(entryTimeout)(stoul(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+    }
 #if !LIBFUSE2
     else if (option == "fuse-max-idle-threads")
     {
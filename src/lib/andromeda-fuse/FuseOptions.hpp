@@ -1,6 +1,7 @@
 #ifndef LIBA2FUSE_FUSEOPTIONS_H_
 #define LIBA2FUSE_FUSEOPTIONS_H_
 
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <string>
@@ -45,6 +46,12 @@ struct FuseOptions
     /** Whether fake chown (no-op) is allowed */
     bool fakeChown { true };
 
+    /** Time the kernel may cache item attributes */
+    std::chrono::seconds attrTimeout { 1 }; // FUSE's default
+
+    /** Time the kernel may cache name lookups */
+    std::chrono::seconds entryTimeout { 1 }; // FUSE's default
+
 #ifndef OPENBSD
     /** True if multi-threading is enabled */
     bool enableThreading { true };
@@ -53,6 +60,15 @@ struct FuseOptions
 #if !LIBFUSE2
     /** Maximum number of FUSE idle threads */
     uint32_t maxIdleThreads { 10 }; // FUSE's default
+
+    /** True to use the low-level (inode-based) FUSE API, not on Windows/OpenBSD */
+    bool lowLevel { false };
+
+    /** 
+     * True to let the kernel cache and batch writes, which also owns the file size/mtime while open
+     * Disabled (with a warning) unless the mounted folder's filesystem supports random writes
+     */
+    bool writebackCache { false };
 #endif // !LIBFUSE2
 };
 
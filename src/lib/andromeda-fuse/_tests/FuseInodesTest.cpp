@@ -0,0 +1,210 @@
+
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "FuseInodes.hpp"
+
+#if A2FUSE_LOWLEVEL
+
+#include "filesystem/testBackend.hpp"
+#include "andromeda/SharedMutex.hpp"
+#include "andromeda/filesystem/File.hpp"
+#include "andromeda/filesystem/Folder.hpp"
+#include "andromeda/filesystem/Item.hpp"
+
+namespace AndromedaFuse {
+namespace { // anonymous
+
+using Andromeda::SharedLockW;
+using Andromeda::Filesystem::File;
+using Andromeda::Filesystem::Folder;
+using Andromeda::Filesystem::Item;
+using Andromeda::Filesystem::TestBackend;
+
+/*****************************************************/
+TEST_CASE("Lookup", "[FuseInodes]")
+{
+    TestBackend backend;
+    backend.GetServer().AddFile("a", "");
+    backend.GetServer().AddFile("b", "");
+
+    Folder& root { backend.GetRoot() };
+    FuseInodes inodes(root);
+    REQUIRE(inodes.GetSize() == 1);
+    REQUIRE(inodes.FindIno(root) == FUSE_ROOT_ID);
+    REQUIRE(inodes.Lookup(root) == FUSE_ROOT_ID);
+
+    File::ScopeLocked fileA { root.GetFileByPath("a") };
+    File::ScopeLocked fileB { root.GetFileByPath("b") };
+    REQUIRE(inodes.FindIno(*fileA) == 0);
+
+    // repeated lookups return the same inode
+    const fuse_ino_t inoA { inodes.Lookup(*fileA) };
+    REQUIRE(inoA != FUSE_ROOT_ID);
+    REQUIRE(inodes.Lookup(*fileA) == inoA);
+    REQUIRE(inodes.FindIno(*fileA) == inoA);
+
+    const fuse_ino_t inoB { inodes.Lookup(*fileB) };
+    REQUIRE(inoB != inoA);
+    REQUIRE(inodes.GetSize() == 3);
+
+    REQUIRE(&*inodes.GetItem(inoA) == &*fileA);
+    REQUIRE(&*inodes.GetItem(FUSE_ROOT_ID) == &root);
+    REQUIRE_THROWS_AS(inodes.GetItem(inoB+1), FuseInodes::StaleException);
+}
+
+/*****************************************************/
+TEST_CASE("Forget", "[FuseInodes]")
+{
+    TestBackend backend;
+    backend.GetServer().AddFile("a", "");
+
+    Folder& root { backend.GetRoot() };
+    FuseInodes inodes(root);
+    File::ScopeLocked file { root.GetFileByPath("a") };
+
+    const fuse_ino_t ino { inodes.Lookup(*file) };
+    inodes.Lookup(*file); inodes.Lookup(*file);
+
+    // remembered until all lookups are forgotten
+    inodes.Forget(ino, 2);
+    REQUIRE(inodes.FindIno(*file) == ino);
+    REQUIRE(inodes.GetSize() == 2);
+
+    inodes.Forget(ino, 1);
+    REQUIRE(inodes.FindIno(*file) == 0);
+    REQUIRE(inodes.GetSize() == 1);
+    REQUIRE_THROWS_AS(inodes.GetItem(ino), FuseInodes::StaleException);
+
+    // unknown inodes are ignored, numbers are never re-used
+    inodes.Forget(ino, 1);
+    REQUIRE(inodes.Lookup(*file) > ino);
+
+    // the root is never forgotten
+    inodes.Forget(FUSE_ROOT_ID, 1);
+    REQUIRE(inodes.FindIno(root) == FUSE_ROOT_ID);
+    REQUIRE(&*inodes.GetItem(FUSE_ROOT_ID) == &root);
+}
+
+/*****************************************************/
+TEST_CASE("ForgetMulti", "[FuseInodes]")
+{
+    TestBackend backend;
+    backend.GetServer().AddFile("a", "");
+    backend.GetServer().AddFile("b", "");
+    backend.GetServer().AddFile("c", "");
+
+    Folder& root { backend.GetRoot() };
+    FuseInodes inodes(root);
+    File::ScopeLocked fileA { root.GetFileByPath("a") };
+    File::ScopeLocked fileB { root.GetFileByPath("b") };
+    File::ScopeLocked fileC { root.GetFileByPath("c") };
+
+    const fuse_ino_t inoA { inodes.Lookup(*fileA) };
+    const fuse_ino_t inoB { inodes.Lookup(*fileB) }; inodes.Lookup(*fileB);
+    const fuse_ino_t inoC { inodes.Lookup(*fileC) };
+    REQUIRE(inodes.GetSize() == 4);
+
+    // a batch as from forget_multi, with the root and an unknown inode
+    const fuse_forget_data forgets[] { {inoA,1}, {inoB,1}, {FUSE_ROOT_ID,1}, {inoC+1,1}, {inoC,5} };
+    for (const fuse_forget_data& forget : forgets)
+        inodes.Forget(forget.ino, forget.nlookup);
+
+    REQUIRE(inodes.GetSize() == 2);
+    REQUIRE(inodes.FindIno(*fileA) == 0);
+    REQUIRE(inodes.FindIno(*fileB) == inoB);
+    REQUIRE(inodes.FindIno(*fileC) == 0);
+    REQUIRE(inodes.FindIno(root) == FUSE_ROOT_ID);
+}
+
+/*****************************************************/
+TEST_CASE("Deleted", "[FuseInodes]")
+{
+    TestBackend backend;
+    backend.GetServer().AddFile("a", "");
+
+    Folder& root { backend.GetRoot() };
+    FuseInodes inodes(root);
+    Item::ScopeLocked item { root.GetItemByPath("a") };
+    const fuse_ino_t ino { inodes.Lookup(*item) };
+
+    // the inode doesn't keep the item alive
+    SharedLockW itemLock { item->GetWriteLock() };
+    item->Delete(item, itemLock);
+    REQUIRE_THROWS_AS(inodes.GetItem(ino), FuseInodes::StaleException);
+    REQUIRE(inodes.GetSize() == 2); // until forgotten
+
+    inodes.Forget(ino, 1);
+    REQUIRE(inodes.GetSize() == 1);
+}
+
+/*****************************************************/
+TEST_CASE("Unlinked", "[FuseInodes]")
+{
+    TestBackend backend;
+    backend.GetServer().AddFile("a", "");
+
+    Folder& root { backend.GetRoot() };
+    FuseInodes inodes(root);
+    File::ScopeLocked file { root.GetFileByPath("a") };
+    const fuse_ino_t ino { inodes.Lookup(*file) };
+
+    // not open, must be deleted now
+    REQUIRE(!inodes.isOpen(ino));
+    REQUIRE(!inodes.SetUnlinked(ino));
+
+    inodes.Open(ino); inodes.Open(ino);
+    REQUIRE(inodes.isOpen(ino));
+    REQUIRE(!inodes.Release(ino)); // not unlinked
+
+    // deleted when the last handle is released
+    REQUIRE(inodes.SetUnlinked(ino));
+    inodes.Open(ino);
+    REQUIRE(!inodes.Release(ino));
+    REQUIRE(inodes.Release(ino));
+    REQUIRE(!inodes.isOpen(ino));
+    REQUIRE(!inodes.Release(ino));
+}
+
+/*****************************************************/
+TEST_CASE("CheckCached", "[FuseInodes]")
+{
+    TestBackend backend;
+    backend.GetServer().AddFile("a", "");
+
+    Folder& root { backend.GetRoot() };
+    FuseInodes inodes(root);
+    File::ScopeLocked file { root.GetFileByPath("a") };
+    const fuse_ino_t ino { inodes.Lookup(*file) };
+
+    // unknown inodes are never cached
+    REQUIRE(!inodes.CheckCached(ino+1, 10, 1.0));
+    REQUIRE(!inodes.CheckCached(ino+1, 10, 1.0));
+
+    // the first open has nothing recorded
+    REQUIRE(!inodes.CheckCached(ino, 10, 1.0));
+    REQUIRE(inodes.CheckCached(ino, 10, 1.0));
+    REQUIRE(inodes.CheckCached(ino, 10, 1.0));
+
+    // a changed size or modified time is recorded for next time
+    REQUIRE(!inodes.CheckCached(ino, 20, 1.0));
+    REQUIRE(inodes.CheckCached(ino, 20, 1.0));
+
+    REQUIRE(!inodes.CheckCached(ino, 20, 2.0));
+    REQUIRE(inodes.CheckCached(ino, 20, 2.0));
+
+    REQUIRE(!inodes.CheckCached(ino, 30, 3.0));
+    REQUIRE(inodes.CheckCached(ino, 30, 3.0));
+
+    // a forgotten inode starts over
+    inodes.Forget(ino, 1);
+    const fuse_ino_t ino2 { inodes.Lookup(*file) };
+    REQUIRE(!inodes.CheckCached(ino2, 30, 3.0));
+    REQUIRE(inodes.CheckCached(ino2, 30, 3.0));
+}
+
+} // namespace
+} // namespace AndromedaFuse
+
+#endif // A2FUSE_LOWLEVEL
@@ -0,0 +1,11 @@
+#ifndef A2FUSE_FUSECONFIG_H_
+#define A2FUSE_FUSECONFIG_H_
+
+// features of the libfuse version in use (see libfuse_Includes.h), safe to include without libfuse headers
+#if !WIN32 && !OPENBSD && !LIBFUSE2
+    #define A2FUSE_LOWLEVEL 1 // low-level frontend available
+    #define A2FUSE_WRITEBACK 1 // kernel writeback cache available
+    #define A2FUSE_SPLICE 1 // fuse_bufvec write_buf and splice available
+#endif // !WIN32 && !OPENBSD && !LIBFUSE2
+
+#endif // A2FUSE_FUSECONFIG_H_
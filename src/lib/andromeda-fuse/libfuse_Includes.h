@@ -1,6 +1,8 @@
 #ifndef A2FUSE_FUSEINCLUDES_H_
 #define A2FUSE_FUSEINCLUDES_H_
 
+#include "libfuse_Config.h"
+
 #if WIN32
     #define FUSE_USE_VERSION 35
     #pragma warning(push)
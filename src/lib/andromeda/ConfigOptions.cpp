@@ -14,13 +14,19 @@ std::string ConfigOptions::HelpText()
     const ConfigOptions optDefault;
 
     const auto defRefresh(optDefault.refreshTime.count());
+    const auto defStale(optDefault.refreshStaleTime.count());
     const auto defReadAhead(optDefault.readAheadTime.count());
+    const auto defRunnerIdle(optDefault.runnerIdleTime.count());
     const size_t stBits { sizeof(size_t)*8 };
 
     using std::endl; output 
-        << "Advanced:        [-q|--quiet] [-r|--read-only] [--dir-refresh secs(" << defRefresh << ")] [--cachemode none|memory|normal] [--backend-runners uint"<<stBits<<"(" << optDefault.runnerPoolSize << ")]" << endl
+        << "Advanced:        [-q|--quiet] [-r|--read-only] [--dir-refresh secs(" << defRefresh << ")] [--dir-stale secs(" << defStale << ")] [--cachemode none|memory|normal] [--backend-runners uint"<<stBits<<"(" << optDefault.runnerPoolSize << ")]"
+            << " [--backend-runners-min uint"<<stBits<<"(" << optDefault.runnerPoolMin << ")] [--backend-runner-idle secs(" << defRunnerIdle << ")]" << endl
         << "Data Advanced:   [--pagesize bytes"<<stBits<<"(" << StringUtil::bytesToString(optDefault.pageSize) << ")] [--read-ahead ms(" << defReadAhead << ")]"
-            << " [--read-max-cache-frac uint32(" << optDefault.readMaxCacheFrac << ")] [--read-ahead-buffer pages(" << optDefault.readAheadBuffer << ")]";
+            << " [--read-max-cache-frac uint32(" << optDefault.readMaxCacheFrac << ")] [--read-ahead-buffer pages(" << optDefault.readAheadBuffer << ")]"
+            << " [--fetch-threads uint"<<stBits<<"(" << optDefault.fetchThreads << ")]"
+            << " [--read-split-size bytes"<<stBits<<"(" << StringUtil::bytesToString(optDefault.readSplitSize) << ")]"
+            << " [--flush-threads uint"<<stBits<<"(" << optDefault.flushThreads << ")]";
 
     return output.str();
 }
@@ -53,6 +59,12 @@ bool ConfigOptions::AddOption(const std::string& option, const std::string& valu
         catch (const std::logic_error& e) { 
             throw BaseOptions::BadValueException(option); }
     }
+    else if (option == "dir-stale")
+    {
+        try { refreshStaleTime = static_cast<decltype(refreshStaleTime)>(stoul(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+    }
     else if (option == "backend-runners")
     {
         try { runnerPoolSize = static_cast<decltype(runnerPoolSize)>(stoul(value)); }
@@ -61,6 +73,20 @@ bool ConfigOptions::AddOption(const std::string& option, const std::string& valu
 
         if (!runnerPoolSize) throw BaseOptions::BadValueException(option);
     }
+    else if (option == "backend-runners-min")
+    {
+        try { runnerPoolMin = static_cast<decltype(runnerPoolMin)>(stoul(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+
+        if (!runnerPoolMin) throw BaseOptions::BadValueException(option);
+    }
+    else if (option == "backend-runner-idle")
+    {
+        try { runnerIdleTime = static_cast<decltype(runnerIdleTime)>(stoul(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+    }
     else if (option == "pagesize")
     {
         try { pageSize = static_cast<decltype(pageSize)>(StringUtil::stringToBytes(value)); }
@@ -89,6 +115,28 @@ bool ConfigOptions::AddOption(const std::string& option, const std::string& valu
         catch (const std::logic_error& e) { 
             throw BaseOptions::BadValueException(option); }
     }
+    else if (option == "fetch-threads")
+    {
+        try { fetchThreads = static_cast<decltype(fetchThreads)>(stoul(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+
+        if (!fetchThreads) throw BaseOptions::BadValueException(option);
+    }
+    else if (option == "read-split-size")
+    {
+        try { readSplitSize = static_cast<decltype(readSplitSize)>(StringUtil::stringToBytes(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+    }
+    else if (option == "flush-threads")
+    {
+        try { flushThreads = static_cast<decltype(flushThreads)>(stoul(value)); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+
+        if (!flushThreads) throw BaseOptions::BadValueException(option);
+    }
     else return false; // not used
 
     return true; 
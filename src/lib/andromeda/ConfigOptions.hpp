@@ -45,6 +45,12 @@ struct ConfigOptions
      */
     std::chrono::seconds refreshTime { 15 };
 
+    /** 
+     * The time past refreshTime that folder data can still be used while it is refreshed in the background
+     * Folder data older than refreshTime+refreshStaleTime is refreshed synchronously (0 to always do so)
+     */
+    std::chrono::seconds refreshStaleTime { 15 };
+
     /** 
      * The default file data page size 
      * The minimum of a file's size and its pageSize is the smallest unit of data that can be read from or 
@@ -77,8 +83,36 @@ struct ConfigOptions
      */
     size_t readAheadBuffer { 2 };
 
-    /** The maximum number of concurrent backend runners, never zero! */
+    /** 
+     * The maximum number of background threads running read-ahead fetches and folder refreshes (shared by all files), never zero!
+     * Fetches that a reader is waiting on are not limited by this, and take priority over read-ahead
+     */
+    size_t fetchThreads { 8 };
+
+    /** 
+     * The minimum size of each range when splitting a large fetch into concurrent requests (0 to disable)
+     * A fetch is split into at most runnerPoolSize ranges, so each can use a separate connection.
+     * Smaller values increase parallelism for medium-sized reads at the cost of more requests.
+     */
+    size_t readSplitSize { static_cast<size_t>(1024)*1024 }; // 1M
+
+    /** 
+     * The maximum number of non-consecutive dirty runs of a file to write back concurrently, never zero!
+     * Only applies to files with RANDOM write mode, and is also limited by runnerPoolSize
+     */
+    size_t flushThreads { 4 };
+
+    /** 
+     * The maximum number of concurrent backend runners, never zero!
+     * The pool adapts its size between runnerPoolMin and this based on demand and server load
+     */
     size_t runnerPoolSize { 1 }; // TODO server has threading issues
+
+    /** The minimum number of backend runners to keep around, never zero and <= runnerPoolSize */
+    size_t runnerPoolMin { 1 };
+
+    /** The time a backend runner above runnerPoolMin can be idle before it is closed */
+    std::chrono::seconds runnerIdleTime { 30 };
 };
 
 } // namespace Andromeda
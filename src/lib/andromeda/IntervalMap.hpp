@@ -0,0 +1,155 @@
+
+#ifndef LIBA2_INTERVALMAP_H_
+#define LIBA2_INTERVALMAP_H_
+
+#include <iterator>
+#include <map>
+#include <utility>
+
+namespace Andromeda {
+
+/**
+ * An ordered map of non-overlapping half-open key ranges [start,end) to values
+ * Adjacent ranges with equal values are merged, so a run of keys is always one entry.
+ * Point and range queries, inserts and erases are all O(log n) in the number of ranges
+ * (plus the number of ranges removed by an overwrite/erase)
+ * @tparam Key the ordered integer-like key type
+ * @tparam Value the value mapped to each range, must be equality-comparable
+ */
+template<typename Key, typename Value = bool>
+class IntervalMap
+{
+public:
+    /** Map of range start to <range end, value> */
+    using RangeMap = std::map<Key, std::pair<Key, Value>>;
+    using value_type = typename RangeMap::value_type;
+    using iterator = typename RangeMap::iterator;
+    using const_iterator = typename RangeMap::const_iterator;
+
+    /** Returns an iterator pointing to the first range */
+    [[nodiscard]] inline iterator begin() noexcept { return mRanges.begin(); }
+    /** Returns an iterator pointing to the past-the-end range */
+    [[nodiscard]] inline iterator end() noexcept { return mRanges.end(); }
+    /** Returns a const iterator pointing to the first range */
+    [[nodiscard]] inline const_iterator cbegin() const noexcept { return mRanges.cbegin(); }
+    /** Returns a const iterator pointing to the past-the-end range */
+    [[nodiscard]] inline const_iterator cend() const noexcept { return mRanges.cend(); }
+
+    /** Returns the number of (merged) ranges (O(1)) */
+    [[nodiscard]] inline size_t size() const noexcept { return mRanges.size(); }
+    /** Returns true iff there are no ranges (O(1)) */
+    [[nodiscard]] inline bool empty() const noexcept { return mRanges.empty(); }
+    /** Removes all ranges */
+    inline void clear() noexcept { mRanges.clear(); }
+
+    /** Returns an iterator to the first range that ends after key (might start after key), else end() */
+    [[nodiscard]] inline iterator first_after(const Key& key)
+    {
+        const iterator it { mRanges.upper_bound(key) }; // first start > key
+        if (it != mRanges.begin())
+        {
+            const iterator prev { std::prev(it) };
+            if (key < prev->second.first) return prev;
+        }
+        return it;
+    }
+
+    /** Returns a const iterator to the first range that ends after key (might start after key), else cend() */
+    [[nodiscard]] inline const_iterator first_after(const Key& key) const
+    {
+        const const_iterator it { mRanges.upper_bound(key) }; // first start > key
+        if (it != mRanges.cbegin())
+        {
+            const const_iterator prev { std::prev(it) };
+            if (key < prev->second.first) return prev;
+        }
+        return it;
+    }
+
+    /** Returns an iterator to the range containing key, else end() */
+    [[nodiscard]] inline iterator find(const Key& key)
+    {
+        const iterator it { first_after(key) };
+        return (it != mRanges.end() && !(key < it->first)) ? it : mRanges.end();
+    }
+
+    /** Returns a const iterator to the range containing key, else cend() */
+    [[nodiscard]] inline const_iterator find(const Key& key) const
+    {
+        const const_iterator it { first_after(key) };
+        return (it != mRanges.cend() && !(key < it->first)) ? it : mRanges.cend();
+    }
+
+    /** Returns true iff the key is in any range */
+    [[nodiscard]] inline bool contains(const Key& key) const { return find(key) != mRanges.cend(); }
+
+    /** Returns true iff any key in [start,end) is in any range */
+    [[nodiscard]] inline bool overlaps(const Key& start, const Key& end) const
+    {
+        const const_iterator it { first_after(start) };
+        return it != mRanges.cend() && it->first < end;
+    }
+
+    /**
+     * Sets the value of the range [start,end), replacing any overlapping ranges
+     * and merging with adjacent ranges that have the same value
+     */
+    inline void insert(const Key& start, const Key& end, const Value& value)
+    {
+        if (!(start < end)) return;
+        erase(start, end);
+
+        iterator it { mRanges.emplace(start, std::make_pair(end, value)).first };
+
+        const iterator next { std::next(it) };
+        if (next != mRanges.end() && !(end < next->first) && next->second.second == value)
+        {
+            it->second.first = next->second.first;
+            mRanges.erase(next);
+        }
+
+        if (it != mRanges.begin())
+        {
+            const iterator prev { std::prev(it) };
+            if (!(prev->second.first < start) && prev->second.second == value)
+            {
+                prev->second.first = it->second.first;
+                mRanges.erase(it);
+            }
+        }
+    }
+
+    /** Removes the range [start,end) from all ranges, splitting any that extend beyond it */
+    inline void erase(const Key& start, const Key& end)
+    {
+        if (!(start < end)) return;
+
+        iterator it { first_after(start) };
+        while (it != mRanges.end() && it->first < end)
+        {
+            const Key itStart { it->first };
+            const Key itEnd { it->second.first };
+            Value value { std::move(it->second.second) };
+            it = mRanges.erase(it);
+
+            if (itStart < start) // keep the part before
+                mRanges.emplace_hint(it, itStart, std::make_pair(start, value));
+
+            if (end < itEnd) // keep the part after, no more overlaps
+            {
+                mRanges.emplace_hint(it, end, std::make_pair(itEnd, std::move(value)));
+                break;
+            }
+        }
+    }
+
+    [[nodiscard]] inline bool operator==(const IntervalMap& rhs) const { return mRanges == rhs.mRanges; }
+    [[nodiscard]] inline bool operator!=(const IntervalMap& rhs) const { return mRanges != rhs.mRanges; }
+
+private:
+    RangeMap mRanges;
+};
+
+} // namespace Andromeda
+
+#endif // LIBA2_INTERVALMAP_H_
@@ -220,6 +220,28 @@ public:
         return v; // non-const for move
     }
 
+    /**
+     * Moves the element pointed to by the given iterator to the front of the list
+     * Complexity: O(1), does not invalidate any iterators
+     */
+    void move_front(const lookup_iterator& it) noexcept
+    {
+        mQueue.splice(mQueue.begin(), mQueue, it->second); // O(1)
+    }
+
+    /**
+     * Looks up and moves the element with the given key to the front of the list
+     * @return true iff an element was found and moved
+     * Complexity: O(1) average, O(N) worst
+     */
+    bool move_front(const Key& key) noexcept
+    {
+        const lookup_iterator itLookup { mLookup.find(key) }; // O(1)-O(n)
+        if (itLookup == mLookup.end()) return false;
+
+        move_front(itLookup); return true;
+    }
+
     /**
      * Emplaces a new element on the front of the list (KEY MUST NOT EXIST)
      * Complexity: O(1) average, O(N) worst
@@ -2,7 +2,9 @@
 #ifndef LIBA2_SHAREDMUTEX_H_
 #define LIBA2_SHAREDMUTEX_H_
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <mutex>
 #include <utility> // pair
@@ -13,94 +15,152 @@ namespace Andromeda {
  * A shared mutex solving the R/W lock problem, satisfies SharedMutex
  * This class specifically implements both a readers-priority and fair queued lock,
  * unlike std::shared_mutex which does not define the priority type (up to the OS)
+ * 
+ * The lock state is a single atomic word, so uncontended lock/unlock (no waiters) is a
+ * single atomic operation. Otherwise, waiters are queued in order under mMutex and each
+ * sleeps on its own CV. Unlocking hands the lock directly to the waiter(s) at the front
+ * of the queue - a writer, or all consecutive readers - and wakes only those.
  */
 class SharedMutex
 {
 public:
     inline bool try_lock() noexcept
     {
-        const std::lock_guard<std::mutex> llock(mMutex);
-
-        if (!mLocked && mQueue.empty())
-        {
-            mLocked = true;
-            return true;
-        }
-        else return false; 
+        uint64_t state { 0 }; // only if unlocked with no waiters
+        return mState.compare_exchange_strong(state, WRITER, std::memory_order_acquire);
     }
 
     inline void lock() noexcept
     {
-        std::unique_lock<std::mutex> llock(mMutex);
-
-        const size_t waitIdx { mIndex++ };
-        mQueue.emplace_back(waitIdx);
-
-        while (mLocked || mQueue.front() != waitIdx)
-            mWaitCV.wait(llock);
-
-        mQueue.pop_front();
-        mLocked = true;
+        if (!try_lock()) LockSlow(Waiter::Type::WRITE);
     }
 
     inline void unlock() noexcept
     {
-        const std::lock_guard<std::mutex> llock(mMutex);
-
-        mLocked = false;
-        if (!mQueue.empty())
-            mWaitCV.notify_all();
+        uint64_t state { WRITER }; // only if there are no waiters
+        if (!mState.compare_exchange_strong(state, 0, std::memory_order_release))
+        {
+            const UniqueLock llock(mMutex);
+            mState.fetch_and(~WRITER, std::memory_order_release);
+            GrantWaiters(llock);
+        }
     }
 
     /** @param priority if true, skip to the front of the queue */
     inline void lock_shared(bool priority = false) noexcept
     {
-        std::unique_lock<std::mutex> llock(mMutex);
+        if (!TryLockShared(priority)) 
+            LockSlow(priority ? Waiter::Type::READP : Waiter::Type::READ);
+    }
 
-        if (priority && mReaders){
-            ++mReaders; return; }
+    inline void unlock_shared() noexcept
+    {
+        const uint64_t state { mState.fetch_sub(READER, std::memory_order_release) - READER };
+        if (state == WAITERS) // last reader, someone is waiting
+        {
+            const UniqueLock llock(mMutex);
+            GrantWaiters(llock);
+        }
+    }
 
-        const size_t waitIdx { mIndex++ };
-        if (priority)
-            mQueue.emplace_front(waitIdx);
-        else mQueue.emplace_back(waitIdx);
+private:
 
-        while ((!mReaders && mLocked) || mQueue.front() != waitIdx)
-            mWaitCV.wait(llock);
+    using UniqueLock = std::unique_lock<std::mutex>;
 
-        mQueue.pop_front();
-        if (!(mReaders++)) // 0->1
-            mLocked = true;
+    /** A thread waiting in the queue */
+    struct Waiter
+    {
+        enum class Type : uint8_t { WRITE, READ, READP };
+        /** @param type the type of lock being waited for */
+        explicit Waiter(Type type) : mType(type) { }
+
+        /** The type of lock being waited for */
+        const Type mType;
+        /** Set true when the lock has been handed to this waiter */
+        bool mGranted { false };
+        /** CV to wake just this waiter */
+        std::condition_variable mCV;
+    };
+
+    /** 
+     * Tries to get a read lock without waiting, returns true if successful
+     * Readers can join when there is no writer and no waiter, or if priority and other readers
+     */
+    inline bool TryLockShared(bool priority) noexcept
+    {
+        uint64_t state { mState.load(std::memory_order_relaxed) };
+        while (!(state & WRITER) && (!(state & WAITERS) || (priority && state >= READER)))
+        {
+            if (mState.compare_exchange_weak(state, state + READER, std::memory_order_acquire))
+                return true;
+        }
+        return false;
+    }
+
+    /** Queues the calling thread and waits for the lock to be granted */
+    inline void LockSlow(const Waiter::Type type) noexcept
+    {
+        UniqueLock llock(mMutex);
+
+        // the state may have changed, but nothing can be granted without mMutex
+        if (type == Waiter::Type::WRITE ? try_lock() : TryLockShared(type == Waiter::Type::READP)) return;
+
+        Waiter waiter(type);
+        if (type == Waiter::Type::READP)
+            mQueue.emplace_front(&waiter);
+        else mQueue.emplace_back(&waiter);
+
+        // stop new lockers from taking the fast path, then check if the
+        // lock was released before we set WAITERS (no one else would wake us)
+        mState.fetch_or(WAITERS, std::memory_order_relaxed);
+        GrantWaiters(llock);
 
-        if (!mQueue.empty())
-            mWaitCV.notify_all();
+        while (!waiter.mGranted) waiter.mCV.wait(llock);
     }
 
-    inline void unlock_shared() noexcept
+    /** If the lock is not held, hands it to the front writer or all front readers and wakes them */
+    inline void GrantWaiters(const UniqueLock& llock) noexcept
     {
-        const std::lock_guard<std::mutex> llock(mMutex);
+        // with WAITERS set and the lock not held, no fast path can change mState
+        const uint64_t state { mState.load(std::memory_order_relaxed) };
+        if ((state & WRITER) || state >= READER || mQueue.empty()) return;
 
-        if (!(--mReaders)) // 1->0
-            mLocked = false;
-        if (!mQueue.empty())
-            mWaitCV.notify_all();
+        uint64_t newState { 0 };
+        if (mQueue.front()->mType == Waiter::Type::WRITE)
+        {
+            Waiter& waiter { *mQueue.front() };
+            mQueue.pop_front();
+            newState = WRITER;
+            waiter.mGranted = true;
+            waiter.mCV.notify_one();
+        }
+        else while (!mQueue.empty() && mQueue.front()->mType != Waiter::Type::WRITE)
+        {
+            Waiter& waiter { *mQueue.front() };
+            mQueue.pop_front();
+            newState += READER;
+            waiter.mGranted = true;
+            waiter.mCV.notify_one();
+        }
+
+        if (!mQueue.empty()) newState |= WAITERS;
+        mState.store(newState, std::memory_order_release);
     }
 
-private:
+    /** State bit set when a writer holds the lock */
+    static constexpr uint64_t WRITER { 1 };
+    /** State bit set when mQueue is not empty (only changed with mMutex) */
+    static constexpr uint64_t WAITERS { 2 };
+    /** State increment for each reader holding the lock */
+    static constexpr uint64_t READER { 4 };
 
-    /** Mutex to protect member vars */
+    /** The lock state - WRITER | WAITERS | readers*READER */
+    std::atomic<uint64_t> mState { 0 };
+
+    /** Mutex to protect the queue and waiters */
     std::mutex mMutex;
-    /** CV used to sleep/wake waiters */
-    std::condition_variable mWaitCV;
-    /** Queue used to order locks */
-    std::deque<size_t> mQueue;
-    /** Next thread ID to use */
-    size_t mIndex { 0 };
-
-    /** Current number readers */
-    size_t mReaders { 0 };
-    /** True when the mutex is held */
-    bool mLocked { false };
+    /** Queue used to order waiters */
+    std::deque<Waiter*> mQueue;
 };
 
 /** Scope-managed shared lock of any type */
@@ -0,0 +1,114 @@
+
+#include <initializer_list>
+#include <string>
+#include <tuple>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "IntervalMap.hpp"
+
+namespace Andromeda {
+namespace { // anonymous
+
+using TestI = IntervalMap<int, std::string>;
+using TestS = IntervalMap<int>;
+
+/** Returns a map with the given <start,end,value> ranges inserted in order */
+TestI MakeMap(std::initializer_list<std::tuple<int,int,std::string>> ranges)
+{
+    TestI ret; for (const std::tuple<int,int,std::string>& range : ranges)
+        ret.insert(std::get<0>(range), std::get<1>(range), std::get<2>(range));
+    return ret;
+}
+
+/*****************************************************/
+TEST_CASE("TestFind", "[IntervalMap]")
+{
+    const TestI testI { MakeMap({{2,5,"a"}, {8,10,"b"}}) };
+    REQUIRE(testI.size() == 2);
+
+    REQUIRE(testI.find(1) == testI.cend());
+    REQUIRE(testI.find(2)->second.second == "a");
+    REQUIRE(testI.find(4)->second.second == "a");
+    REQUIRE(testI.find(5) == testI.cend());
+    REQUIRE(testI.find(9)->second.second == "b");
+    REQUIRE(testI.find(10) == testI.cend());
+
+    REQUIRE(!testI.contains(7)); REQUIRE(testI.contains(8));
+
+    REQUIRE(testI.first_after(0)->first == 2);
+    REQUIRE(testI.first_after(3)->first == 2);
+    REQUIRE(testI.first_after(5)->first == 8);
+    REQUIRE(testI.first_after(10) == testI.cend());
+
+    REQUIRE(!testI.overlaps(0, 2)); REQUIRE(testI.overlaps(0, 3));
+    REQUIRE(!testI.overlaps(5, 8)); REQUIRE(testI.overlaps(5, 9));
+    REQUIRE(testI.overlaps(3, 4)); REQUIRE(!testI.overlaps(10, 20));
+}
+
+/*****************************************************/
+TEST_CASE("TestMerge", "[IntervalMap]")
+{
+    TestS testS;
+    testS.insert(0, 2, true);
+    testS.insert(4, 6, true);
+    REQUIRE(testS.size() == 2);
+
+    testS.insert(2, 4, true); // fills the gap
+    REQUIRE(testS.size() == 1);
+    REQUIRE(testS.cbegin()->first == 0);
+    REQUIRE(testS.cbegin()->second.first == 6);
+
+    testS.insert(1, 3, true); // already contained
+    REQUIRE(testS.size() == 1);
+
+    TestI testI { MakeMap({{0,2,"a"}, {2,4,"b"}, {4,6,"a"}}) };
+    REQUIRE(testI.size() == 3); // different values don't merge
+
+    testI.insert(2, 4, "a");
+    REQUIRE(testI == MakeMap({{0,6,"a"}}));
+    REQUIRE(testI.size() == 1);
+}
+
+/*****************************************************/
+TEST_CASE("TestOverwrite", "[IntervalMap]")
+{
+    TestI testI { MakeMap({{0,10,"a"}}) };
+
+    testI.insert(3, 5, "b"); // splits the range
+    REQUIRE(testI.size() == 3);
+    REQUIRE(testI.find(2)->second.second == "a");
+    REQUIRE(testI.find(3)->second.second == "b");
+    REQUIRE(testI.find(5)->second.second == "a");
+
+    testI.insert(4, 12, "c"); // overlaps multiple
+    REQUIRE(testI.size() == 3);
+    REQUIRE(testI.find(3)->second.second == "b");
+    REQUIRE(testI.find(4)->second.second == "c");
+    REQUIRE(testI.find(11)->second.second == "c");
+    REQUIRE(testI.find(12) == testI.cend());
+}
+
+/*****************************************************/
+TEST_CASE("TestErase", "[IntervalMap]")
+{
+    TestI testI { MakeMap({{0,4,"a"}, {6,10,"b"}}) };
+
+    testI.erase(0, 1); // front
+    REQUIRE(testI.cbegin()->first == 1);
+    REQUIRE(!testI.contains(0));
+
+    testI.erase(7, 8); // middle
+    REQUIRE(testI.size() == 3);
+    REQUIRE(testI.contains(6)); REQUIRE(!testI.contains(7)); REQUIRE(testI.contains(8));
+
+    testI.erase(3, 9); // across ranges
+    REQUIRE(testI == MakeMap({{1,3,"a"}, {9,10,"b"}}));
+
+    testI.erase(5, 5); // empty range
+    testI.erase(0, 100);
+    REQUIRE(testI.empty());
+}
+
+} // namespace
+} // namespace Andromeda
@@ -104,5 +104,26 @@ TEST_CASE("TestPop", "[OrderedMap]")
     REQUIRE(testM == TestM{{9,"myval3"}}); REQUIRE(testQ == TestQ{9});
 }
 
+/*****************************************************/
+TEST_CASE("TestMoveFront", "[OrderedMap]")
+{
+    TestM testM; TestQ testQ;
+    testM.enqueue_front(5, "myval"); testQ.enqueue_front(5);
+    testM.enqueue_front(7, "myval2"); testQ.enqueue_front(7);
+    testM.enqueue_front(9, "myval3"); testQ.enqueue_front(9);
+
+    REQUIRE(testM.move_front(5)); REQUIRE(testQ.move_front(5));
+    REQUIRE(!testM.move_front(15)); REQUIRE(!testQ.move_front(15));
+    REQUIRE(testM == TestM{{5,"myval"},{9,"myval3"},{7,"myval2"}}); REQUIRE(testQ == TestQ{5,9,7});
+
+    testM.move_front(testM.lookup(7)); testQ.move_front(testQ.lookup(7));
+    REQUIRE(testM == TestM{{7,"myval2"},{5,"myval"},{9,"myval3"}}); REQUIRE(testQ == TestQ{7,5,9});
+
+    // lookup iterators remain valid after moving
+    REQUIRE(testM.erase(9)); REQUIRE(testQ.erase(9));
+    REQUIRE(testM.pop_back() == TestMV{5, "myval"}); REQUIRE(testQ.pop_back() == 5);
+    REQUIRE(testM == TestM{{7,"myval2"}}); REQUIRE(testQ == TestQ{7});
+}
+
 } // namespace
 } // namespace Andromeda
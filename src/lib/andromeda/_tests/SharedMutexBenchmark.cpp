@@ -0,0 +1,111 @@
+#include <array>
+#include <numeric>
+#include <shared_mutex>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "testThreads.hpp"
+#include "SharedMutex.hpp"
+
+// These are hidden, run with "[.benchmark]" to compare against std::shared_mutex
+
+namespace Andromeda {
+namespace { // anonymous
+
+constexpr size_t THREADS { TEST_THREADS };
+constexpr size_t THREAD_LOCKS { 20000 };
+/** One in WRITE_EVERY locks is a write lock for the mixed benchmarks */
+constexpr size_t WRITE_EVERY { 16 };
+
+/** Takes THREAD_LOCKS read locks on each thread, returns the sum of values read */
+template<typename Mutex>
+size_t RunReaders(Mutex& mut, const size_t& value)
+{
+    std::array<size_t, THREADS> sums { };
+    RunThreads([&](const size_t thread)
+    {
+        for (size_t i { 0 }; i < THREAD_LOCKS; ++i)
+        {
+            mut.lock_shared();
+            sums[thread] += value;
+            mut.unlock_shared();
+        }
+    });
+    return std::accumulate(sums.begin(), sums.end(), size_t{0});
+}
+
+/** Takes THREAD_LOCKS locks on each thread, one in WRITE_EVERY for writing */
+template<typename Mutex>
+void RunMixed(Mutex& mut, size_t& value)
+{
+    RunThreads([&](const size_t thread)
+    {
+        for (size_t i { 0 }; i < THREAD_LOCKS; ++i)
+        {
+            if ((i+thread) % WRITE_EVERY == 0)
+            {
+                mut.lock(); ++value; mut.unlock();
+            }
+            else
+            {
+                mut.lock_shared();
+                const size_t read { value }; (void)read;
+                mut.unlock_shared();
+            }
+        }
+    });
+}
+
+/*****************************************************/
+TEST_CASE("UncontendedRead", "[.benchmark][SharedMutex]")
+{
+    SharedMutex mut; std::shared_mutex stdMut;
+    size_t value { 0 };
+
+    BENCHMARK("std::shared_mutex lock_shared")
+    {
+        stdMut.lock_shared(); ++value;
+        stdMut.unlock_shared(); return value;
+    };
+
+    BENCHMARK("SharedMutex lock_shared")
+    {
+        mut.lock_shared(); ++value;
+        mut.unlock_shared(); return value;
+    };
+
+    BENCHMARK("SharedMutex lock")
+    {
+        mut.lock(); ++value;
+        mut.unlock(); return value;
+    };
+}
+
+/*****************************************************/
+TEST_CASE("ContendedRead", "[.benchmark][SharedMutex]")
+{
+    SharedMutex mut; std::shared_mutex stdMut;
+    const size_t value { 1 };
+
+    BENCHMARK("std::shared_mutex readers") { return RunReaders(stdMut, value); };
+    BENCHMARK("SharedMutex readers") { return RunReaders(mut, value); };
+}
+
+/*****************************************************/
+TEST_CASE("ContendedMixed", "[.benchmark][SharedMutex]")
+{
+    SharedMutex mut; std::shared_mutex stdMut;
+    size_t value { 0 };
+
+    BENCHMARK("std::shared_mutex readers+writers") { RunMixed(stdMut, value); };
+
+    value = 0; size_t runs { 0 };
+    BENCHMARK("SharedMutex readers+writers") { RunMixed(mut, value); ++runs; };
+
+    // every write must have been exclusive
+    REQUIRE(value == runs*THREADS*THREAD_LOCKS/WRITE_EVERY);
+}
+
+} // namespace
+} // namespace Andromeda
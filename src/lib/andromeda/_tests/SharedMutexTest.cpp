@@ -173,7 +173,7 @@ TEST_CASE("TestTryLock", "[SharedMutex]")
 
     mut.lock_shared();
     REQUIRE(mut.try_lock() == false);
-    mut.unlock();
+    mut.unlock_shared();
 
     REQUIRE(mut.try_lock() == true);
     REQUIRE(mut.try_lock() == false);
@@ -0,0 +1,200 @@
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+#include "catch2/catch_test_macros.hpp"
+#include "nlohmann/json.hpp"
+
+#include "../filesystem/testBackend.hpp"
+#include "andromeda/ConfigOptions.hpp"
+#include "andromeda/backend/BackendImpl.hpp"
+
+namespace Andromeda {
+namespace Backend {
+namespace { // anonymous
+
+using Filesystem::MockServer;
+using Filesystem::TestBackend;
+
+/** Returns options with enough runners for concurrent requests */
+ConfigOptions GetOptions()
+{
+    ConfigOptions options;
+    options.runnerPoolSize = 4;
+    options.runnerPoolMin = 4;
+    return options;
+}
+
+/** Waits until the given function returns true or a timeout */
+template <typename Func>
+bool WaitFor(Func func)
+{
+    for (size_t i { 0 }; i < 1000 && !func(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return func();
+}
+
+/** Makes the first getfolder request block until the returned promise is set */
+std::promise<void> BlockFirstRead(MockServer& server, std::atomic<size_t>& started)
+{
+    std::promise<void> gate; std::shared_future<void> gateF { gate.get_future() };
+    server.SetHook([&started,gateF](const RunnerInput& input)
+    {
+        if (input.action == "getfolder" && ++started == 1) gateF.wait();
+    });
+    return gate;
+}
+
+} // namespace
+
+/*****************************************************/
+TEST_CASE("CoalesceReads", "[BackendImpl]")
+{
+    TestBackend backend(GetOptions());
+    MockServer& server { backend.GetServer() };
+    BackendImpl& impl { backend.GetBackend() };
+    server.AddFile("file", "data");
+
+    std::atomic<size_t> started { 0 };
+    std::promise<void> gate { BlockFirstRead(server, started) };
+
+    std::future<nlohmann::json> read1 { std::async(std::launch::async, [&](){ return impl.GetFolder("root"); }) };
+    REQUIRE(WaitFor([&](){ return started == 1; }));
+
+    // an identical read joins the one in flight
+    std::future<nlohmann::json> read2 { std::async(std::launch::async, [&](){ return impl.GetFolder("root"); }) };
+    REQUIRE(WaitFor([&](){ return impl.GetCoalescedCount() == 1; }));
+
+    gate.set_value();
+    const nlohmann::json folder1(read1.get());
+    REQUIRE(read2.get() == folder1);
+    REQUIRE(folder1.at("files").size() == 1);
+    REQUIRE(server.GetCount("getfolder") == 1);
+
+    // once finished, the same read is sent again
+    REQUIRE(impl.GetFolder("root") == folder1);
+    REQUIRE(server.GetCount("getfolder") == 2);
+    REQUIRE(impl.GetCoalescedCount() == 1);
+}
+
+/*****************************************************/
+TEST_CASE("CoalesceAfterWrite", "[BackendImpl]")
+{
+    TestBackend backend(GetOptions());
+    MockServer& server { backend.GetServer() };
+    BackendImpl& impl { backend.GetBackend() };
+
+    std::atomic<size_t> started { 0 };
+    std::promise<void> gate { BlockFirstRead(server, started) };
+
+    std::future<nlohmann::json> read1 { std::async(std::launch::async, [&](){ return impl.GetFolder("root"); }) };
+    REQUIRE(WaitFor([&](){ return started == 1; }));
+
+    // a read started after a write must see it, not join the older read
+    impl.CreateFolder("root", "new");
+    std::future<nlohmann::json> read2 { std::async(std::launch::async, [&](){ return impl.GetFolder("root"); }) };
+    const bool joined { read2.wait_for(std::chrono::seconds(5)) != std::future_status::ready };
+
+    gate.set_value();
+    static_cast<void>(read1.get());
+    REQUIRE(!joined);
+    REQUIRE(impl.GetCoalescedCount() == 0);
+
+    const nlohmann::json folder2(read2.get());
+    REQUIRE(folder2.at("folders").size() == 1);
+    REQUIRE(server.GetCount("getfolder") == 2);
+
+    // the older read finishing doesn't remove the newer one's entry
+    REQUIRE(impl.GetFolder("root") == folder2);
+    REQUIRE(server.GetCount("getfolder") == 3);
+}
+
+/*****************************************************/
+TEST_CASE("AsyncRequests", "[BackendImpl]")
+{
+    TestBackend backend(GetOptions());
+    MockServer& server { backend.GetServer() };
+    BackendImpl& impl { backend.GetBackend() };
+    const std::string id { server.AddFile("file", "0123456789") };
+    const BackendImpl::AsyncPriority sync { BackendImpl::AsyncPriority::SYNC };
+
+    const nlohmann::json folder(impl.GetFolderAsync(&impl, "root", sync).get());
+    REQUIRE(folder.at("files").size() == 1);
+
+    std::string read(4, '\0');
+    impl.ReadFileAsync(&impl, id, 3, read.size(), [&](const size_t offset, const char* buf, const size_t buflen)
+        { read.replace(offset, buflen, buf, buflen); }, sync).get();
+    REQUIRE(read == "3456");
+
+    const std::string data { "abc" };
+    impl.WriteFileAsync(&impl, id, 2, [&](const size_t offset, const size_t buflen, const char*& buf, size_t& written)
+    {
+        buf = data.data()+offset; written = std::min(buflen, data.size()-offset);
+        return offset+written < data.size();
+    }, sync).get();
+    REQUIRE(server.GetData(id) == "01abc56789");
+
+    // backend errors are returned through the future
+    server.SetHook([](const RunnerInput& input){ 
+        if (input.action == "download") throw BackendException("test"); });
+    std::future<void> failed { impl.ReadFileAsync(&impl, id, 0, 1, [](const size_t, const char*, const size_t){ }, sync) };
+    REQUIRE_THROWS_AS(failed.get(), BackendException);
+}
+
+/*****************************************************/
+TEST_CASE("AsyncConcurrent", "[BackendImpl]")
+{
+    TestBackend backend(GetOptions());
+    MockServer& server { backend.GetServer() };
+    BackendImpl& impl { backend.GetBackend() };
+    const std::string sub { impl.CreateFolder("root", "sub").at("id").get<std::string>() };
+
+    std::atomic<size_t> started { 0 };
+    std::promise<void> gate { BlockFirstRead(server, started) };
+    const BackendImpl::AsyncPriority readAhead { BackendImpl::AsyncPriority::READAHEAD };
+
+    // each request runs on its own runner, the second is not stuck behind the first
+    std::future<nlohmann::json> read1 { impl.GetFolderAsync(&impl, "root", readAhead) };
+    REQUIRE(WaitFor([&](){ return started == 1; }));
+    std::future<nlohmann::json> read2 { impl.GetFolderAsync(&impl, sub, readAhead) };
+    REQUIRE(read2.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    REQUIRE(read2.get().at("id") == sub);
+    REQUIRE(read1.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+
+    gate.set_value();
+    REQUIRE(read1.get().at("folders").size() == 1);
+}
+
+/*****************************************************/
+TEST_CASE("AsyncCancel", "[BackendImpl]")
+{
+    ConfigOptions options { GetOptions() };
+    options.fetchThreads = 1;
+    TestBackend backend(options);
+    MockServer& server { backend.GetServer() };
+    BackendImpl& impl { backend.GetBackend() };
+
+    std::atomic<size_t> started { 0 };
+    std::promise<void> gate { BlockFirstRead(server, started) };
+    const BackendImpl::AsyncPriority readAhead { BackendImpl::AsyncPriority::READAHEAD };
+
+    const int owner1 { 0 }; const int owner2 { 0 };
+    std::future<nlohmann::json> read1 { impl.GetFolderAsync(&owner1, "root", readAhead) };
+    REQUIRE(WaitFor([&](){ return started == 1; }));
+
+    // the only read-ahead worker is busy so this stays queued until cancelled
+    std::future<nlohmann::json> read2 { impl.GetFolderAsync(&owner2, "root", readAhead) };
+    impl.CancelAsync(&owner2);
+    REQUIRE_THROWS_AS(read2.get(), std::future_error);
+
+    gate.set_value();
+    REQUIRE(read1.get().at("id") == "root");
+    REQUIRE(server.GetCount("getfolder") == 1);
+}
+
+} // namespace Backend
+} // namespace Andromeda
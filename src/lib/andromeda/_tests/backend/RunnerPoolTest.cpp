@@ -0,0 +1,212 @@
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <thread>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "andromeda/ConfigOptions.hpp"
+#include "andromeda/backend/BaseRunner.hpp"
+#include "andromeda/backend/RunnerPool.hpp"
+
+namespace Andromeda {
+namespace Backend {
+namespace { // anonymous
+
+/** Runner that does nothing, counts the number of clones */
+class MockRunner : public BaseRunner
+{
+public:
+    explicit MockRunner(std::atomic<size_t>& clones) : mClones(clones) { }
+
+    [[nodiscard]] std::unique_ptr<BaseRunner> Clone() const override {
+        ++mClones; return std::make_unique<MockRunner>(mClones); }
+
+    [[nodiscard]] std::string GetHostname() const override { return "mock"; }
+
+    std::string RunAction_Read(const RunnerInput& input) override { return ""; }
+    std::string RunAction_Write(const RunnerInput& input) override { return ""; }
+    std::string RunAction_FilesIn(const RunnerInput_FilesIn& input) override { return ""; }
+    std::string RunAction_StreamIn(const RunnerInput_StreamIn& input) override { return ""; }
+    void RunAction_StreamOut(const RunnerInput_StreamOut& input) override { }
+
+    [[nodiscard]] bool RequiresSession() const override { return false; }
+
+    /** Simulates the server reporting overload */
+    void Overload() { SetOverloaded(); }
+
+private:
+    std::atomic<size_t>& mClones;
+};
+
+/** Returns ConfigOptions with the given max pool size and min pool size (default fixed size) */
+ConfigOptions GetOptions(const size_t poolSize, const size_t minSize = 0)
+{
+    ConfigOptions options;
+    options.runnerPoolSize = poolSize;
+    options.runnerPoolMin = minSize ? minSize : poolSize;
+    return options;
+}
+
+/** Runs many concurrent requests on the pool, returns the max number of runners in use at once */
+size_t RunConcurrent(RunnerPool& pool)
+{
+    std::atomic<size_t> inUse { 0 };
+    std::atomic<size_t> maxInUse { 0 };
+
+    std::list<std::thread> threads;
+    for (size_t thread { 0 }; thread < 8; ++thread)
+        threads.emplace_back([&]()
+    {
+        for (size_t i { 0 }; i < 100; ++i)
+        {
+            const RunnerPool::LockedRunner runner { pool.GetRunner() };
+            const size_t cur { ++inUse };
+            size_t max { maxInUse.load() };
+            while (cur > max && !maxInUse.compare_exchange_weak(max, cur)) { }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            --inUse;
+        }
+    });
+    for (std::thread& thread : threads) thread.join();
+
+    return maxInUse;
+}
+
+/*****************************************************/
+TEST_CASE("TestSingle", "[RunnerPool]")
+{
+    std::atomic<size_t> clones { 0 };
+    MockRunner first(clones);
+    RunnerPool pool(first, GetOptions(1));
+
+    std::atomic<bool> waiting { false };
+    std::atomic<bool> gotRunner { false };
+    std::thread thread;
+
+    { RunnerPool::LockedRunner runner { pool.GetRunner() };
+        REQUIRE(&*runner == &first);
+
+        thread = std::thread([&](){ waiting = true;
+            RunnerPool::LockedRunner runner2 { pool.GetRunner() }; gotRunner = true; });
+
+        while (!waiting) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE(!gotRunner); // must wait for us
+    }
+
+    thread.join();
+    REQUIRE(gotRunner);
+    REQUIRE(clones == 0);
+}
+
+/*****************************************************/
+TEST_CASE("TestReuse", "[RunnerPool]")
+{
+    std::atomic<size_t> clones { 0 };
+    MockRunner first(clones);
+    RunnerPool pool(first, GetOptions(3));
+
+    { // idle runners are re-used before cloning
+        RunnerPool::LockedRunner runner1 { pool.GetRunner() };
+        REQUIRE(&*runner1 == &first);
+    }
+    { RunnerPool::LockedRunner runner1 { pool.GetRunner() };
+        REQUIRE(&*runner1 == &first);
+    }
+    REQUIRE(clones == 0);
+
+    const BaseRunner* last { nullptr };
+    { // clones only as needed
+        RunnerPool::LockedRunner runner1 { pool.GetRunner() };
+        RunnerPool::LockedRunner runner2 { pool.GetRunner() };
+        REQUIRE(clones == 1);
+        REQUIRE(&*runner1 != &*runner2);
+        last = &*runner1;
+    } // runner1 returned last
+
+    { // most recently used first
+        RunnerPool::LockedRunner runner1 { pool.GetRunner() };
+        REQUIRE(&*runner1 == last);
+    }
+    REQUIRE(clones == 1);
+}
+
+/*****************************************************/
+TEST_CASE("TestConcurrent", "[RunnerPool]")
+{
+    constexpr size_t POOL_SIZE { 3 };
+    std::atomic<size_t> clones { 0 };
+    MockRunner first(clones);
+    RunnerPool pool(first, GetOptions(POOL_SIZE));
+
+    std::atomic<size_t> inUse { 0 };
+    std::atomic<size_t> maxInUse { 0 };
+
+    std::list<std::thread> threads;
+    for (size_t thread { 0 }; thread < 8; ++thread)
+        threads.emplace_back([&]()
+    {
+        for (size_t i { 0 }; i < 1000; ++i)
+        {
+            const RunnerPool::LockedRunner runner { pool.GetRunner() };
+            const size_t cur { ++inUse };
+            size_t max { maxInUse.load() };
+            while (cur > max && !maxInUse.compare_exchange_weak(max, cur)) { }
+            --inUse;
+        }
+    });
+    for (std::thread& thread : threads) thread.join();
+
+    REQUIRE(maxInUse <= POOL_SIZE);
+    REQUIRE(clones <= POOL_SIZE-1);
+}
+
+/*****************************************************/
+TEST_CASE("TestAdaptive", "[RunnerPool]")
+{
+    constexpr size_t POOL_SIZE { 4 };
+    std::atomic<size_t> clones { 0 };
+    MockRunner first(clones);
+    RunnerPool pool(first, GetOptions(POOL_SIZE, 1));
+    REQUIRE(pool.GetTargetSize() == 1);
+
+    // grows when callers have to wait
+    REQUIRE(RunConcurrent(pool) <= POOL_SIZE);
+    const size_t target { pool.GetTargetSize() };
+    REQUIRE(target > 1);
+    REQUIRE(target <= POOL_SIZE);
+    REQUIRE(pool.GetSize() <= target);
+
+    { // halves when the server is overloaded
+        RunnerPool::LockedRunner runner { pool.GetRunner() };
+        dynamic_cast<MockRunner&>(*runner).Overload();
+    }
+    REQUIRE(pool.GetTargetSize() == std::max(target/2, static_cast<size_t>(1)));
+}
+
+/*****************************************************/
+TEST_CASE("TestReapIdle", "[RunnerPool]")
+{
+    std::atomic<size_t> clones { 0 };
+    MockRunner first(clones);
+    ConfigOptions options { GetOptions(4, 1) };
+    options.runnerIdleTime = std::chrono::seconds(0);
+    RunnerPool pool(first, options);
+
+    RunConcurrent(pool);
+    REQUIRE(clones > 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    { // idle runners above the min are closed
+        const RunnerPool::LockedRunner runner { pool.GetRunner() };
+        REQUIRE(pool.GetSize() == 1);
+    }
+    REQUIRE(pool.GetSize() == 1);
+}
+
+} // namespace
+} // namespace Backend
+} // namespace Andromeda
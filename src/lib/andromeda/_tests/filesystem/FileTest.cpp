@@ -0,0 +1,127 @@
+
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+#include "nlohmann/json.hpp"
+
+#include "testBackend.hpp"
+#include "andromeda/common.hpp"
+#include "andromeda/filesystem/File.hpp"
+#include "andromeda/filesystem/Folder.hpp"
+#include "andromeda/filesystem/Item.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace { // anonymous
+
+/** Returns backend JSON for a refresh of the given file */
+nlohmann::json GetFileJ(const std::string& id, const size_t size, const Item::Date modified)
+{
+    nlohmann::json data {{"id",id},{"name","a"},{"size",size}};
+    data["dates"] = {{"created",0},{"modified",modified},{"accessed",nullptr}};
+    return data;
+}
+
+/** Counts remote change notifications while in scope */
+class NotifyCounter
+{
+public:
+    NotifyCounter() { Item::SetRemoteChangeFunc([this](const Item&, const std::string&){ ++mCount; }); }
+    ~NotifyCounter() { Item::SetRemoteChangeFunc(nullptr); }
+    DELETE_COPY(NotifyCounter)
+    DELETE_MOVE(NotifyCounter)
+
+    [[nodiscard]] size_t GetCount() const { return mCount; }
+
+private:
+    size_t mCount { 0 };
+};
+
+} // namespace
+
+/*****************************************************/
+TEST_CASE("DirtyState", "[File]")
+{
+    TestBackend backend;
+    MockServer& server { backend.GetServer() };
+    const std::string id { server.AddFile("a", "0123") };
+    File::ScopeLocked file { backend.GetRoot().GetFileByPath("a") };
+
+    { const SharedLockR fileLock { file->GetReadLock() };
+        REQUIRE(!file->isDirty(fileLock)); } // flush can be skipped
+
+    { const SharedLockW fileLock { file->GetWriteLock() };
+        // a write through any handle (or the kernel's writeback cache) makes the file dirty
+        file->WriteBytes("xy", 1, 2, fileLock);
+        REQUIRE(file->isDirty(fileLock));
+        file->FlushCache(fileLock);
+        REQUIRE(!file->isDirty(fileLock)); }
+    REQUIRE(server.GetData(id) == "0xy3");
+
+    { const SharedLockW fileLock { file->GetWriteLock() };
+        file->Truncate(2, fileLock);
+        REQUIRE(file->isDirty(fileLock));
+        file->FlushCache(fileLock);
+        REQUIRE(!file->isDirty(fileLock)); }
+    REQUIRE(server.GetData(id) == "0x");
+}
+
+/*****************************************************/
+TEST_CASE("DirtyCreated", "[File]")
+{
+    TestBackend backend;
+    MockServer& server { backend.GetServer() };
+    Folder& root { backend.GetRoot() };
+
+    { const SharedLockW rootLock { root.GetWriteLock() };
+        root.CreateFile("new", rootLock); }
+    File::ScopeLocked file { root.GetFileByPath("new") };
+
+    // not written yet, but the flush must still create it on the backend
+    const SharedLockW fileLock { file->GetWriteLock() };
+    REQUIRE(file->isDirty(fileLock));
+    file->FlushCache(fileLock);
+    REQUIRE(!file->isDirty(fileLock));
+    REQUIRE(server.GetCount("upload") == 1);
+}
+
+/*****************************************************/
+TEST_CASE("RefreshModified", "[File]")
+{
+    TestBackend backend;
+    MockServer& server { backend.GetServer() };
+    const std::string id { server.AddFile("a", "0123") };
+    File::ScopeLocked file { backend.GetRoot().GetFileByPath("a") };
+    const NotifyCounter notify;
+
+    const SharedLockW fileLock { file->GetWriteLock() };
+    file->Refresh(GetFileJ(id, 4, 10), fileLock);
+    REQUIRE(notify.GetCount() == 1); // a real remote change
+    REQUIRE(file->GetModified(fileLock) == 10);
+    REQUIRE(file->GetBackendModified(fileLock) == 10);
+
+    file->Refresh(GetFileJ(id, 4, 10), fileLock);
+    REQUIRE(notify.GetCount() == 1); // unchanged
+
+    // while dirty, a refresh (e.g. from the folder) keeps our own modified time
+    file->WriteBytes("x", 0, 1, fileLock);
+    const Item::Date localModified { file->GetModified(fileLock) };
+    REQUIRE(localModified > 10);
+    file->Refresh(GetFileJ(id, 4, 11), fileLock);
+    REQUIRE(notify.GetCount() == 1);
+    REQUIRE(file->GetModified(fileLock) == localModified);
+    REQUIRE(file->GetBackendModified(fileLock) == 11);
+
+    // the refresh after our own flush sees our own change
+    file->FlushCache(fileLock);
+    file->Refresh(GetFileJ(id, 4, 12), fileLock);
+    REQUIRE(notify.GetCount() == 1);
+    REQUIRE(file->GetModified(fileLock) == 12);
+
+    // later changes are remote again
+    file->Refresh(GetFileJ(id, 4, 13), fileLock);
+    REQUIRE(notify.GetCount() == 2);
+}
+
+} // namespace Filesystem
+} // namespace Andromeda
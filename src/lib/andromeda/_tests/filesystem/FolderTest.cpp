@@ -0,0 +1,226 @@
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "testBackend.hpp"
+#include "../testThreads.hpp"
+#include "andromeda/ConfigOptions.hpp"
+#include "andromeda/backend/BackendException.hpp"
+#include "andromeda/filesystem/Folder.hpp"
+#include "andromeda/filesystem/Item.hpp"
+#include "andromeda/filesystem/filedata/FetchPool.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace { // anonymous
+
+using Filedata::FetchPool;
+
+/** Returns options where folder items always need a refresh, usable while stale if staleTime */
+ConfigOptions GetOptions(const std::chrono::seconds& staleTime)
+{
+    ConfigOptions options;
+    options.refreshTime = std::chrono::seconds(0);
+    options.refreshStaleTime = staleTime;
+    return options;
+}
+
+/** Waits until the given function returns true or a timeout */
+template <typename Func>
+bool WaitFor(Func func)
+{
+    for (size_t i { 0 }; i < 1000 && !func(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return func();
+}
+
+/** Returns true if looking up the path is cached, i.e. doesn't wait for a lock on folder */
+bool IsCached(Folder& root, Folder& folder, const std::string& path)
+{
+    std::future<Item::ScopeLocked> lookup;
+    bool cached { false };
+    { // lock scope
+        const SharedLockW folderLock { folder.GetWriteLock() };
+        lookup = std::async(std::launch::async, [&](){ return root.GetItemByPath(path); });
+        cached = (lookup.wait_for(std::chrono::milliseconds(500)) == std::future_status::ready);
+    }
+    static_cast<void>(lookup.get());
+    return cached;
+}
+
+/** Returns the number of items in the folder, loading them as needed */
+size_t CountItems(Folder& folder)
+{
+    const SharedLockW folderLock { folder.GetWriteLock() };
+    return folder.GetItems(folderLock).size();
+}
+
+} // namespace
+
+/*****************************************************/
+TEST_CASE("RefreshStale", "[Folder]")
+{
+    TestBackend backend(GetOptions(std::chrono::hours(1)));
+    MockServer& server { backend.GetServer() };
+    const FetchPool& pool { backend.GetBackend().GetFetchPool() };
+    server.AddFile("a", "");
+
+    Folder& root { backend.GetRoot() };
+    REQUIRE(CountItems(root) == 1); // initial load is synchronous
+    const size_t loads { server.GetCount("getfolder") };
+
+    std::atomic<size_t> started { 0 };
+    std::promise<void> gate; std::shared_future<void> gateF { gate.get_future() };
+    server.SetHook([&started,gateF](const Backend::RunnerInput& input) {
+        if (input.action == "getfolder" && ++started == 1) gateF.wait(); });
+    server.AddFile("b", "");
+
+    // the stale items are used without waiting for the refresh
+    REQUIRE(CountItems(root) == 1);
+    REQUIRE(WaitFor([&](){ return started == 1; }));
+    REQUIRE(CountItems(root) == 1); // still in progress
+
+    gate.set_value();
+    REQUIRE(WaitFor([&](){ return pool.GetStats().completedJobs == 1; }));
+    REQUIRE(server.GetCount("getfolder") == loads+1);
+
+    // the finished refresh is applied on the next load
+    REQUIRE(CountItems(root) == 2);
+}
+
+/*****************************************************/
+TEST_CASE("RefreshStaleFailure", "[Folder]")
+{
+    TestBackend backend(GetOptions(std::chrono::hours(1)));
+    MockServer& server { backend.GetServer() };
+    const FetchPool& pool { backend.GetBackend().GetFetchPool() };
+    server.AddFile("a", "");
+
+    Folder& root { backend.GetRoot() };
+    REQUIRE(CountItems(root) == 1);
+
+    std::atomic<bool> failing { true };
+    server.SetHook([&failing](const Backend::RunnerInput& input) {
+        if (input.action == "getfolder" && failing) throw Backend::BackendException("test"); });
+    server.AddFile("b", "");
+
+    // a failed background refresh keeps the stale items
+    REQUIRE(CountItems(root) == 1);
+    REQUIRE(WaitFor([&](){ return pool.GetStats().completedJobs == 1; }));
+    failing = false;
+    REQUIRE(CountItems(root) == 1); // starts another refresh
+
+    REQUIRE(WaitFor([&](){ return pool.GetStats().completedJobs == 2; }));
+    REQUIRE(CountItems(root) == 2);
+}
+
+/*****************************************************/
+TEST_CASE("RefreshSync", "[Folder]")
+{
+    TestBackend backend(GetOptions(std::chrono::seconds(0)));
+    MockServer& server { backend.GetServer() };
+    const FetchPool& pool { backend.GetBackend().GetFetchPool() };
+    server.AddFile("a", "");
+
+    Folder& root { backend.GetRoot() };
+    REQUIRE(CountItems(root) == 1);
+    const size_t loads { server.GetCount("getfolder") };
+
+    // with no stale time, expired items are reloaded before returning
+    server.AddFile("b", "");
+    REQUIRE(CountItems(root) == 2);
+    REQUIRE(server.GetCount("getfolder") == loads+1);
+    REQUIRE(pool.GetStats().completedJobs == 0);
+}
+
+/*****************************************************/
+TEST_CASE("PathCacheInvalidate", "[Folder]")
+{
+    TestBackend backend;
+    MockServer& server { backend.GetServer() };
+    const std::string folderA { server.AddFolder("a") };
+    server.AddFile("x", "", folderA); server.AddFile("z", "", folderA);
+    server.AddFile("y", "", server.AddFolder("b"));
+
+    Folder& root { backend.GetRoot() };
+    Folder::ScopeLocked a { root.GetFolderByPath("a") };
+    Folder::ScopeLocked b { root.GetFolderByPath("b") };
+    for (const char* path : { "a/x", "a/z", "b/y" })
+        static_cast<void>(root.GetItemByPath(path));
+    REQUIRE(IsCached(root, *b, "b/y"));
+
+    { // removing an item only invalidates paths through it
+        Item::ScopeLocked x { root.GetItemByPath("a/x") };
+        SharedLockW xLock { x->GetWriteLock() };
+        x->Delete(x, xLock);
+    }
+    REQUIRE_THROWS_AS(root.GetItemByPath("a/x"), Folder::NotFoundException);
+    REQUIRE(IsCached(root, *a, "a/z"));
+    REQUIRE(IsCached(root, *b, "b/y"));
+
+    { // renaming a folder invalidates everything under it
+        SharedLockW aLock { a->GetWriteLock() };
+        a->Rename("c", aLock);
+    }
+    REQUIRE_THROWS_AS(root.GetItemByPath("a/z"), Folder::NotFoundException);
+    REQUIRE(!IsCached(root, *a, "c/z"));
+    REQUIRE(IsCached(root, *a, "c/z"));
+    REQUIRE(IsCached(root, *b, "b/y"));
+}
+
+/*****************************************************/
+TEST_CASE("PathCacheConcurrent", "[Folder]")
+{
+    constexpr size_t FOLDERS { 4 };
+    constexpr size_t RENAMES { 50 };
+    constexpr size_t LOOKUPS { 2000 };
+
+    TestBackend backend;
+    MockServer& server { backend.GetServer() };
+    for (size_t folder { 0 }; folder < FOLDERS; ++folder)
+        server.AddFile("file", "", server.AddFolder("f"+std::to_string(folder)));
+    Folder& root { backend.GetRoot() };
+
+    // thread 0 keeps renaming f0/file while the others look up all the files
+    std::atomic<bool> wrongItem { false };
+    std::atomic<size_t> found { 0 };
+    RunThreads([&](size_t thread)
+    {
+        if (thread == 0)
+        {
+            Item::ScopeLocked file { root.GetItemByPath("f0/file") };
+            for (size_t rename { 0 }; rename < RENAMES*2; ++rename)
+            {
+                SharedLockW fileLock { file->GetWriteLock() };
+                file->Rename((rename % 2 == 0) ? "moved" : "file", fileLock);
+            }
+            return;
+        }
+
+        for (size_t lookup { 0 }; lookup < LOOKUPS; ++lookup)
+        {
+            const std::string name { (lookup % 3 == 0) ? "moved" : "file" };
+            const std::string path { "f"+std::to_string(lookup % FOLDERS)+"/"+name };
+            try
+            {
+                const Item::ScopeLocked item { root.GetItemByPath(path) };
+                if (item->GetName(item->GetReadLock()) != name) wrongItem = true;
+                ++found;
+            }
+            catch (const Folder::NotFoundException& ex) { }
+        }
+    });
+
+    REQUIRE(!wrongItem);
+    REQUIRE(found > 0);
+    REQUIRE(root.GetItemByPath("f0/file")->GetName(root.GetReadLock()) == "file");
+}
+
+} // namespace Filesystem
+} // namespace Andromeda
@@ -0,0 +1,215 @@
+
+#include <array>
+#include <list>
+#include <mutex>
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "../testBackend.hpp"
+#include "../../testThreads.hpp"
+#include "andromeda/OrderedMap.hpp"
+#include "andromeda/filesystem/File.hpp"
+#include "andromeda/filesystem/filedata/CacheManager.hpp"
+#include "andromeda/filesystem/filedata/CacheOptions.hpp"
+#include "andromeda/filesystem/filedata/Page.hpp"
+#include "andromeda/filesystem/filedata/PageBackend.hpp"
+#include "andromeda/filesystem/filedata/PageManager.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+namespace { // anonymous
+
+constexpr size_t PAGE_SIZE { 4096 };
+constexpr size_t THREADS { TEST_THREADS };
+constexpr size_t THREAD_PAGES { 32 };
+constexpr size_t THREAD_HITS { 20000 };
+
+/** 
+ * An empty PageManager for a file on a mock backend - the CacheManager only calls 
+ * into it to evict/flush, which never happens as the memory limit is not reached
+ */
+class TestPageManager
+{
+public:
+    TestPageManager() : 
+        mFileID(mBackend.GetServer().AddFile("file", "")),
+        mFile(mBackend.GetRoot().GetFileByPath("file")),
+        mPageBackend(*mFile, mFileID, 0, PAGE_SIZE),
+        mPageMgr(*mFile, 0, PAGE_SIZE, mPageBackend) { }
+
+    PageManager& get() { return mPageMgr; }
+
+private:
+    TestBackend mBackend;
+    const std::string mFileID;
+    File::ScopeLocked mFile;
+    PageBackend mPageBackend;
+    PageManager mPageMgr;
+};
+
+/*****************************************************/
+TEST_CASE("HitAccounting", "[CacheManager]")
+{
+    const CacheOptions options;
+    CacheManager cacheMgr(options, false); // no threads
+    TestPageManager pageMgr;
+
+    std::list<Page> pages;
+    for (size_t i { 0 }; i < 4; ++i)
+    {
+        pages.emplace_back(PAGE_SIZE, cacheMgr.GetPageAllocator());
+        cacheMgr.InformPage(pageMgr.get(), i, pages.back(), i % 2 == 0);
+    }
+
+    const size_t pageCap { pages.front().capacity() };
+    CacheManager::Stats stats { cacheMgr.GetStats() };
+    REQUIRE(stats.totalPages == 4); REQUIRE(stats.currentTotal == 4*pageCap);
+    REQUIRE(stats.dirtyPages == 2); REQUIRE(stats.currentDirty == 2*pageCap);
+
+    // repeated hits (fast path) don't change the accounting
+    for (size_t hit { 0 }; hit < 1000; ++hit)
+    {
+        size_t i { 0 }; for (const Page& page : pages)
+            { cacheMgr.InformPage(pageMgr.get(), i, page, i % 2 == 0); ++i; }
+    }
+
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.totalPages == 4); REQUIRE(stats.currentTotal == 4*pageCap);
+    REQUIRE(stats.dirtyPages == 2); REQUIRE(stats.currentDirty == 2*pageCap);
+
+    // a hit that changes dirtiness takes the full path
+    cacheMgr.InformPage(pageMgr.get(), 1, *std::next(pages.begin()), true);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.dirtyPages == 3); REQUIRE(stats.currentDirty == 3*pageCap);
+
+    cacheMgr.RemoveDirty(pages.front());
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.dirtyPages == 2); REQUIRE(stats.currentDirty == 2*pageCap);
+
+    for (const Page& page : pages) cacheMgr.RemovePage(page);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.totalPages == 0); REQUIRE(stats.currentTotal == 0);
+    REQUIRE(stats.dirtyPages == 0); REQUIRE(stats.currentDirty == 0);
+}
+
+/*****************************************************/
+TEST_CASE("TwoQueuePolicy", "[CacheManager]")
+{
+    CacheOptions options; options.evictPolicy = CacheOptions::EvictPolicy::TWOQ;
+    CacheManager cacheMgr(options, false); // no threads
+    TestPageManager pageMgr;
+
+    std::list<Page> pages;
+    for (size_t i { 0 }; i < 2; ++i)
+    {
+        pages.emplace_back(PAGE_SIZE, cacheMgr.GetPageAllocator());
+        cacheMgr.InformPage(pageMgr.get(), i, pages.back(), false);
+    }
+
+    // new pages stay on probation, even if accessed again
+    for (size_t hit { 0 }; hit < 100; ++hit)
+        cacheMgr.InformPage(pageMgr.get(), 0, pages.front(), false);
+    CacheManager::Stats stats { cacheMgr.GetStats() };
+    REQUIRE(stats.totalPages == 2); REQUIRE(stats.probationPages == 2);
+
+    // a changed page on probation stays there with its accounting updated
+    cacheMgr.InformPage(pageMgr.get(), 0, pages.front(), true);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.probationPages == 2); REQUIRE(stats.currentTotal == 2*pages.front().capacity());
+    REQUIRE(stats.dirtyPages == 1); REQUIRE(stats.currentDirty == pages.front().capacity());
+    cacheMgr.RemoveDirty(pages.front());
+
+    // deleted (not evicted) then re-fetched, stays on probation when accessed
+    cacheMgr.RemovePage(pages.back()); pages.pop_back();
+    pages.emplace_back(PAGE_SIZE, cacheMgr.GetPageAllocator());
+    for (size_t hit { 0 }; hit < 100; ++hit)
+        cacheMgr.InformPage(pageMgr.get(), 1, pages.back(), false);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.totalPages == 2); REQUIRE(stats.probationPages == 2);
+
+    // evicted from probation then re-fetched, still on probation until accessed
+    cacheMgr.RemovePage(pages.front(), true); pages.pop_front();
+    pages.emplace_front(PAGE_SIZE, cacheMgr.GetPageAllocator());
+    cacheMgr.InformPage(pageMgr.get(), 0, pages.front(), false);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.totalPages == 2); REQUIRE(stats.probationPages == 2);
+
+    // accessed again after re-fetch, moves to the main queue (hits are batched)
+    for (size_t hit { 0 }; hit < 100; ++hit)
+        cacheMgr.InformPage(pageMgr.get(), 0, pages.front(), false);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.totalPages == 2); REQUIRE(stats.probationPages == 1);
+    REQUIRE(stats.currentTotal == 2*pages.front().capacity());
+
+    for (const Page& page : pages) cacheMgr.RemovePage(page);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.totalPages == 0); REQUIRE(stats.currentTotal == 0);
+
+    cacheMgr.CountRead(true); cacheMgr.CountRead(true); cacheMgr.CountRead(false);
+    stats = cacheMgr.GetStats();
+    REQUIRE(stats.readHits == 2); REQUIRE(stats.readMisses == 1);
+}
+
+/*****************************************************/
+TEST_CASE("HitContention", "[CacheManager][.benchmark]")
+{
+    const CacheOptions options;
+    CacheManager cacheMgr(options, false); // no threads
+    TestPageManager pageMgr;
+
+    std::array<std::list<Page>, THREADS> pages;
+    for (size_t thread { 0 }; thread < THREADS; ++thread)
+        for (size_t i { 0 }; i < THREAD_PAGES; ++i)
+        {
+            pages[thread].emplace_back(PAGE_SIZE, cacheMgr.GetPageAllocator());
+            cacheMgr.InformPage(pageMgr.get(), thread*THREAD_PAGES+i, pages[thread].back(), false);
+        }
+
+    // baseline - every hit promotes the page under one global mutex
+    std::mutex globalMutex;
+    OrderedMap<const Page*, size_t> globalQueue;
+    for (const std::list<Page>& threadPages : pages)
+        for (const Page& page : threadPages)
+            globalQueue.enqueue_front(&page, page.capacity());
+
+    BENCHMARK("global mutex LRU hits")
+    {
+        RunThreads([&](const size_t thread)
+        {
+            for (size_t hit { 0 }; hit < THREAD_HITS; )
+                for (const Page& page : pages[thread])
+                {
+                    const std::lock_guard<std::mutex> lock(globalMutex);
+                    globalQueue.move_front(&page); ++hit;
+                }
+        });
+    };
+
+    BENCHMARK("CacheManager::InformPage hits")
+    {
+        RunThreads([&](const size_t thread)
+        {
+            for (size_t hit { 0 }; hit < THREAD_HITS; )
+            {
+                uint64_t index { thread*THREAD_PAGES };
+                for (const Page& page : pages[thread])
+                    { cacheMgr.InformPage(pageMgr.get(), index++, page, false); ++hit; }
+            }
+        });
+    };
+
+    const CacheManager::Stats stats { cacheMgr.GetStats() };
+    REQUIRE(stats.totalPages == THREADS*THREAD_PAGES);
+
+    for (const std::list<Page>& threadPages : pages)
+        for (const Page& page : threadPages)
+            cacheMgr.RemovePage(page);
+}
+
+} // namespace
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
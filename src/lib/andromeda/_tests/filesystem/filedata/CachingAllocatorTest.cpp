@@ -0,0 +1,134 @@
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "../../testThreads.hpp"
+#include "andromeda/filesystem/filedata/CachingAllocator.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+namespace { // anonymous
+
+constexpr size_t PAGES { 4 }; // per allocation
+constexpr size_t THREADS { TEST_THREADS };
+constexpr size_t THREAD_ALLOCS { 10000 };
+
+/*****************************************************/
+TEST_CASE("TestRecycle", "[CachingAllocator]")
+{
+    CachingAllocator alloc(0); // never cleans
+    const size_t bytes { PAGES*alloc.getPageSize() };
+
+    void* const ptr1 { alloc.alloc(PAGES) };
+    alloc.free(ptr1, PAGES);
+    REQUIRE(alloc.GetStats().curFree == bytes);
+
+    void* const ptr2 { alloc.alloc(PAGES) };
+    REQUIRE(ptr2 == ptr1); // same thread, recycled
+
+    CachingAllocator::Stats stats { alloc.GetStats() };
+    REQUIRE(stats.curAlloc == bytes);
+    REQUIRE(stats.curFree == 0);
+    REQUIRE(stats.allocs == 2);
+    REQUIRE(stats.recycles == 1);
+
+    // an empty magazine takes on a new size
+    void* const ptr3 { alloc.alloc(2*PAGES) };
+    alloc.free(ptr3, 2*PAGES);
+    REQUIRE(alloc.alloc(2*PAGES) == ptr3);
+
+    // other sizes go to the depot
+    alloc.free(ptr3, 2*PAGES); // magazine
+    alloc.free(ptr2, PAGES); // depot
+    void* const ptr4 { alloc.alloc(PAGES) };
+    REQUIRE(ptr4 == ptr2);
+    REQUIRE(alloc.GetStats().curFree == 2*bytes);
+
+    alloc.free(ptr4, PAGES);
+}
+
+/*****************************************************/
+TEST_CASE("TestFreeLimit", "[CachingAllocator]")
+{
+    constexpr size_t ALLOCS { 40 }; // more than a magazine
+    constexpr size_t KEEP { 2 }; // max allocs in the free pool
+
+    const size_t bytes { PAGES*CachingAllocator(0).getPageSize() };
+    CachingAllocator alloc((ALLOCS-KEEP)*bytes); // baseline
+
+    std::vector<void*> ptrs;
+    for (size_t i { 0 }; i < ALLOCS; ++i)
+        ptrs.push_back(alloc.alloc(PAGES));
+    REQUIRE(alloc.GetStats().maxAlloc == ALLOCS*bytes);
+
+    for (void* const ptr : ptrs)
+    {
+        alloc.free(ptr, PAGES);
+        REQUIRE(alloc.GetStats().curFree <= KEEP*bytes);
+    }
+    REQUIRE(alloc.GetStats().curFree == KEEP*bytes);
+    REQUIRE(alloc.GetStats().curAlloc == 0);
+}
+
+/*****************************************************/
+TEST_CASE("TestConcurrent", "[CachingAllocator]")
+{
+    CachingAllocator alloc(0);
+    const size_t pageSize { alloc.getPageSize() };
+    std::atomic<bool> valid { true };
+
+    RunThreads([&](const size_t thread)
+    {
+        std::array<char*, 4> ptrs { };
+        for (size_t i { 0 }; i < THREAD_ALLOCS/10; ++i)
+        {
+            for (char*& ptr : ptrs)
+            {
+                ptr = static_cast<char*>(alloc.alloc(PAGES));
+                ptr[0] = static_cast<char>(thread); ptr[PAGES*pageSize-1] = static_cast<char>(thread);
+            }
+            for (char* const ptr : ptrs)
+            {
+                if (ptr[0] != static_cast<char>(thread) || ptr[PAGES*pageSize-1] != static_cast<char>(thread))
+                    valid = false; // given to two threads at once
+                alloc.free(ptr, PAGES);
+            }
+        }
+    });
+    REQUIRE(valid);
+
+    const CachingAllocator::Stats stats { alloc.GetStats() };
+    REQUIRE(stats.curAlloc == 0);
+    REQUIRE(stats.allocs == THREADS*THREAD_ALLOCS/10*4);
+}
+
+/*****************************************************/
+TEST_CASE("AllocContention", "[.benchmark][CachingAllocator]")
+{
+    CachingAllocator alloc(0);
+
+    BENCHMARK("alloc/free 1 thread")
+    {
+        for (size_t i { 0 }; i < THREADS*THREAD_ALLOCS; ++i)
+            alloc.free(alloc.alloc(PAGES), PAGES);
+    };
+
+    BENCHMARK("alloc/free all threads")
+    {
+        RunThreads([&](const size_t thread)
+        {
+            for (size_t i { 0 }; i < THREAD_ALLOCS; ++i)
+                alloc.free(alloc.alloc(PAGES), PAGES);
+        });
+    };
+}
+
+} // namespace
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
@@ -0,0 +1,206 @@
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "andromeda/common.hpp"
+#include "andromeda/filesystem/filedata/CacheOptions.hpp"
+#include "andromeda/filesystem/filedata/CachingAllocator.hpp"
+#include "andromeda/filesystem/filedata/DiskCache.hpp"
+#include "andromeda/filesystem/filedata/Page.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+namespace { // anonymous
+
+constexpr size_t PAGE_SIZE { 4096 };
+constexpr size_t HEADER_SIZE { 32 };
+
+/** Returns cache options using a new temporary directory, removed when destructed */
+class TestOptions : public CacheOptions
+{
+public:
+    TestOptions()
+    {
+        diskCachePath = (fs::temp_directory_path() / ("a2_DiskCacheTest_"+
+            std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()))).string();
+    }
+    ~TestOptions() { std::error_code ec; fs::remove_all(diskCachePath, ec); }
+    DELETE_COPY(TestOptions)
+    DELETE_MOVE(TestOptions)
+};
+
+/** Waits until the given function returns true or a timeout */
+template <typename Func>
+bool WaitFor(Func func)
+{
+    for (size_t i { 0 }; i < 1000 && !func(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return func();
+}
+
+/** Returns true once all stores have finished and the cache has the given number of pages */
+bool WaitStored(const DiskCache& cache, const size_t pages)
+{
+    return WaitFor([&](){ const DiskCache::Stats stats { cache.GetStats() };
+        return stats.pendingStores == 0 && stats.totalPages == pages; });
+}
+
+/** Returns a page filled with the given byte */
+Page MakePage(CachingAllocator& alloc, const char fill)
+{
+    Page page(PAGE_SIZE, alloc);
+    std::memset(page.data(), fill, page.size());
+    return page;
+}
+
+/*****************************************************/
+TEST_CASE("StoreRead", "[DiskCache]")
+{
+    const TestOptions options;
+    DiskCache cache(options);
+    CachingAllocator alloc(0);
+
+    const DiskCache::Version version { 3*PAGE_SIZE, 12.5, PAGE_SIZE };
+    cache.StorePage("backend1", "file", 1, version, MakePage(alloc, 'a'));
+    REQUIRE(WaitStored(cache, 1));
+    REQUIRE(cache.GetStats().currentTotal == HEADER_SIZE+PAGE_SIZE);
+
+    Page page(PAGE_SIZE, alloc);
+    REQUIRE(cache.ReadPage("backend1", "file", 1, version, page));
+    REQUIRE(std::string(page.data(), page.size()) == std::string(PAGE_SIZE, 'a'));
+
+    // file IDs are only unique per backend
+    REQUIRE(!cache.ReadPage("backend2", "file", 1, version, page));
+    REQUIRE(!cache.ReadPage("backend1", "file", 0, version, page));
+
+    DiskCache::Stats stats { cache.GetStats() };
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.misses == 2);
+
+    // a different version is a miss and removes the page
+    const DiskCache::Version version2 { 3*PAGE_SIZE, 13.5, PAGE_SIZE };
+    REQUIRE(!cache.ReadPage("backend1", "file", 1, version2, page));
+    stats = cache.GetStats();
+    REQUIRE(stats.totalPages == 0);
+    REQUIRE(stats.currentTotal == 0);
+}
+
+/*****************************************************/
+TEST_CASE("HeaderFormat", "[DiskCache]")
+{
+    const TestOptions options;
+    CachingAllocator alloc(0);
+
+    const DiskCache::Version version { 0x0102030405060708, 1.0, PAGE_SIZE };
+    { DiskCache cache(options);
+        cache.StorePage("backend", "file", 0, version, MakePage(alloc, 'b'));
+        REQUIRE(WaitStored(cache, 1)); }
+
+    // fixed little-endian layout regardless of the host
+    std::array<unsigned char, HEADER_SIZE> header { };
+    { std::ifstream file(fs::path(options.diskCachePath) / "backend" / "file" / "0.page", std::ios::binary);
+        file.read(reinterpret_cast<char*>(header.data()), header.size()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        REQUIRE(file.good()); }
+
+    const std::array<unsigned char, HEADER_SIZE> expected { 
+        'C','P','2','A', 1,0,0,0, // magic, format
+        8,7,6,5,4,3,2,1, // backendSize
+        0,0,0,0,0,0,0xF0,0x3F, // modified 1.0
+        0,0x10,0,0,0,0,0,0 }; // pageSize
+    REQUIRE(header == expected);
+
+    // persists across restarts
+    DiskCache cache(options);
+    REQUIRE(cache.GetStats().totalPages == 1);
+    Page page(PAGE_SIZE, alloc);
+    REQUIRE(cache.ReadPage("backend", "file", 0, version, page));
+    REQUIRE(std::string(page.data(), page.size()) == std::string(PAGE_SIZE, 'b'));
+}
+
+/*****************************************************/
+TEST_CASE("RemoveCancels", "[DiskCache]")
+{
+    const TestOptions options;
+    DiskCache cache(options);
+    CachingAllocator alloc(0);
+
+    // whether or not the store started, it must not be readable after removing
+    const DiskCache::Version version { PAGE_SIZE*4, 0, PAGE_SIZE };
+    for (uint64_t i { 0 }; i < 4; ++i)
+        cache.StorePage("backend", "file", i, version, MakePage(alloc, 'c'));
+    cache.RemovePages("backend", "file", 1, 2);
+    REQUIRE(WaitFor([&](){ return cache.GetStats().pendingStores == 0; }));
+
+    Page page(PAGE_SIZE, alloc);
+    REQUIRE(!cache.ReadPage("backend", "file", 1, version, page));
+    REQUIRE(!cache.ReadPage("backend", "file", 2, version, page));
+    REQUIRE(cache.ReadPage("backend", "file", 0, version, page));
+    REQUIRE(cache.ReadPage("backend", "file", 3, version, page));
+    REQUIRE(cache.GetStats().totalPages == 2);
+}
+
+/*****************************************************/
+TEST_CASE("Evict", "[DiskCache]")
+{
+    TestOptions options;
+    options.diskCacheLimit = 2*(HEADER_SIZE+PAGE_SIZE);
+    DiskCache cache(options);
+    CachingAllocator alloc(0);
+
+    const DiskCache::Version version { PAGE_SIZE*3, 0, PAGE_SIZE };
+    for (uint64_t i { 0 }; i < 3; ++i)
+    {
+        cache.StorePage("backend", "file", i, version, MakePage(alloc, 'd'));
+        REQUIRE(WaitStored(cache, std::min(i+1, uint64_t{2})));
+    }
+
+    // the least recently used page was evicted
+    Page page(PAGE_SIZE, alloc);
+    REQUIRE(!cache.ReadPage("backend", "file", 0, version, page));
+    REQUIRE(cache.ReadPage("backend", "file", 1, version, page));
+    REQUIRE(cache.ReadPage("backend", "file", 2, version, page));
+    REQUIRE(cache.GetStats().currentTotal <= options.diskCacheLimit);
+}
+
+/*****************************************************/
+TEST_CASE("PendingLimit", "[DiskCache]")
+{
+    constexpr size_t STORES { 1000 };
+
+    TestOptions options;
+    options.memoryLimit = 0; // only one store may wait at a time
+    DiskCache cache(options);
+    CachingAllocator alloc(0);
+
+    // stores faster than the disk are dropped rather than queued in memory
+    const DiskCache::Version version { PAGE_SIZE*STORES, 0, PAGE_SIZE };
+    size_t maxPending { 0 };
+    for (uint64_t i { 0 }; i < STORES; ++i)
+    {
+        cache.StorePage("backend", "file", i, version, MakePage(alloc, 'e'));
+        maxPending = std::max(maxPending, cache.GetStats().pendingStores);
+    }
+    REQUIRE(maxPending <= 1);
+    REQUIRE(WaitFor([&](){ return cache.GetStats().pendingStores == 0; }));
+
+    // every store was either written or dropped
+    const DiskCache::Stats stats { cache.GetStats() };
+    REQUIRE(stats.droppedStores > 0);
+    REQUIRE(stats.totalPages + stats.droppedStores == STORES);
+}
+
+} // namespace
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
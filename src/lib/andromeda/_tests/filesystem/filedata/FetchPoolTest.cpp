@@ -0,0 +1,156 @@
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "andromeda/filesystem/filedata/FetchPool.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+
+namespace { // anonymous
+
+/** Waits until the given function returns true or a timeout */
+template <typename Func>
+bool WaitFor(Func func)
+{
+    for (size_t i { 0 }; i < 1000 && !func(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return func();
+}
+
+} // namespace
+
+/*****************************************************/
+TEST_CASE("TestPriority", "[FetchPool]")
+{
+    FetchPool pool(1);
+    const int owner { 0 };
+
+    std::promise<void> gate; std::shared_future<void> gateF { gate.get_future() };
+    pool.AddJob(&owner, FetchPool::Priority::READAHEAD, [gateF](){ gateF.wait(); });
+    REQUIRE(WaitFor([&](){ return pool.GetStats().activeJobs == 1; }));
+
+    // the single worker is busy, later jobs queue up and SYNC runs first
+    std::string order; std::mutex orderMutex;
+    pool.AddJob(&owner, FetchPool::Priority::READAHEAD, [&](){
+        const std::lock_guard<std::mutex> lock(orderMutex); order += "R"; });
+
+    std::promise<void> syncDone;
+    pool.AddJob(&owner, FetchPool::Priority::SYNC, [&](){
+        { const std::lock_guard<std::mutex> lock(orderMutex); order += "S"; } syncDone.set_value(); });
+
+    // the SYNC job doesn't wait for the busy worker
+    syncDone.get_future().wait();
+    REQUIRE(order == "S");
+
+    gate.set_value();
+    REQUIRE(WaitFor([&](){ return pool.GetStats().completedJobs == 3; }));
+    REQUIRE(order == "SR");
+}
+
+/*****************************************************/
+TEST_CASE("TestExtraWorkers", "[FetchPool]")
+{
+    constexpr size_t MAX_THREADS { 2 };
+    FetchPool pool(MAX_THREADS);
+    const int owner { 0 };
+
+    std::atomic<size_t> running { 0 };
+    std::atomic<size_t> maxRunning { 0 };
+
+    std::promise<void> gate; std::shared_future<void> gateF { gate.get_future() };
+    const FetchPool::Job readJob { [&,gateF]()
+    {
+        const size_t cur { ++running };
+        size_t max { maxRunning.load() };
+        while (cur > max && !maxRunning.compare_exchange_weak(max, cur)) { }
+        gateF.wait(); --running;
+    } };
+
+    for (size_t i { 0 }; i < MAX_THREADS*3; ++i)
+        pool.AddJob(&owner, FetchPool::Priority::READAHEAD, readJob);
+    REQUIRE(WaitFor([&](){ return running == MAX_THREADS; }));
+
+    FetchPool::Stats stats { pool.GetStats() };
+    REQUIRE(stats.workers == MAX_THREADS);
+    REQUIRE(stats.readAheadJobs == MAX_THREADS*2);
+
+    // SYNC runs on an extra worker that must not pick up the queued READAHEAD jobs
+    std::promise<void> syncDone;
+    pool.AddJob(&owner, FetchPool::Priority::SYNC, [&](){ syncDone.set_value(); });
+    syncDone.get_future().wait();
+
+    REQUIRE(WaitFor([&](){ return pool.GetStats().extraWorkers == 0; }));
+    stats = pool.GetStats();
+    REQUIRE(stats.readAheadJobs == MAX_THREADS*2);
+    REQUIRE(stats.syncJobs == 0);
+    REQUIRE(maxRunning == MAX_THREADS);
+
+    gate.set_value();
+    REQUIRE(WaitFor([&](){ return pool.GetStats().completedJobs == MAX_THREADS*3+1; }));
+    REQUIRE(maxRunning == MAX_THREADS);
+}
+
+/*****************************************************/
+TEST_CASE("TestPromoteJobs", "[FetchPool]")
+{
+    FetchPool pool(1);
+    const int owner1 { 0 }, owner2 { 0 };
+
+    std::promise<void> gate; std::shared_future<void> gateF { gate.get_future() };
+    pool.AddJob(&owner1, FetchPool::Priority::READAHEAD, [gateF](){ gateF.wait(); });
+    REQUIRE(WaitFor([&](){ return pool.GetStats().activeJobs == 1; }));
+
+    std::atomic<size_t> count { 0 };
+    pool.AddJob(&owner1, FetchPool::Priority::READAHEAD, [&](){ ++count; });
+    pool.AddJob(&owner2, FetchPool::Priority::READAHEAD, [&](){ ++count; });
+    REQUIRE(pool.GetStats().readAheadJobs == 2);
+
+    // promoted jobs run on an extra worker even though the pool is full
+    pool.PromoteJobs(&owner1);
+    REQUIRE(WaitFor([&](){ return count == 1; }));
+
+    FetchPool::Stats stats { pool.GetStats() };
+    REQUIRE(stats.syncJobs == 0);
+    REQUIRE(stats.readAheadJobs == 1);
+
+    gate.set_value();
+    REQUIRE(WaitFor([&](){ return count == 2; }));
+}
+
+/*****************************************************/
+TEST_CASE("TestRemoveJobs", "[FetchPool]")
+{
+    FetchPool pool(1);
+    const int owner1 { 0 }, owner2 { 0 };
+
+    std::promise<void> gate; std::shared_future<void> gateF { gate.get_future() };
+    std::atomic<bool> finished { false };
+    pool.AddJob(&owner1, FetchPool::Priority::READAHEAD, [&,gateF](){ gateF.wait(); finished = true; });
+    REQUIRE(WaitFor([&](){ return pool.GetStats().activeJobs == 1; }));
+
+    std::atomic<size_t> count { 0 };
+    pool.AddJob(&owner1, FetchPool::Priority::READAHEAD, [&](){ ++count; });
+    pool.AddJob(&owner2, FetchPool::Priority::READAHEAD, [&](){ ++count; });
+
+    // removing waits for owner1's running job but discards its queued one
+    std::thread releaser([&](){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10)); gate.set_value(); });
+    pool.RemoveJobs(&owner1);
+    REQUIRE(finished);
+    releaser.join();
+
+    REQUIRE(WaitFor([&](){ return pool.GetStats().completedJobs == 2; }));
+    REQUIRE(count == 1);
+}
+
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
@@ -0,0 +1,96 @@
+
+#include <cstring>
+#include <initializer_list>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "andromeda/filesystem/filedata/MemoryAllocator.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+namespace { // anonymous
+
+constexpr size_t ARENA_BYTES { static_cast<size_t>(2)*1024*1024 };
+
+/*****************************************************/
+TEST_CASE("TestDirect", "[MemoryAllocator]")
+{
+    MemoryAllocator alloc; // direct
+
+    char* const ptr { static_cast<char*>(alloc.alloc(4)) };
+    std::memset(ptr, 1, 4*alloc.getPageSize());
+
+    REQUIRE(alloc.GetOSStats().arenas == 0);
+    alloc.free(ptr, 4);
+}
+
+/*****************************************************/
+TEST_CASE("TestArena", "[MemoryAllocator]")
+{
+    MemoryAllocator alloc(true); // arenas
+#if WIN32
+    REQUIRE(alloc.GetOSStats().arenas == 0); // not supported
+#else // !WIN32
+    const size_t pageSize { alloc.getPageSize() };
+    if (pageSize > ARENA_BYTES) return; // not supported
+    const size_t arenaPages { ARENA_BYTES/pageSize };
+
+    char* const ptr1 { static_cast<char*>(alloc.alloc(4)) };
+    char* const ptr2 { static_cast<char*>(alloc.alloc(4)) };
+    std::memset(ptr1, 1, 4*pageSize);
+    std::memset(ptr2, 2, 4*pageSize);
+
+    // both are carved from the same aligned arena
+    REQUIRE(reinterpret_cast<uintptr_t>(ptr1) % ARENA_BYTES == 0); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    REQUIRE(ptr2 == ptr1 + 4*pageSize);
+
+    MemoryAllocator::OSStats stats { alloc.GetOSStats() };
+    REQUIRE(stats.arenas == 1);
+    REQUIRE(stats.arenaBytes == ARENA_BYTES);
+    REQUIRE(stats.arenaFree == ARENA_BYTES - 8*pageSize);
+
+    // partial free leaves a hole that is re-used first
+    alloc.free(ptr1+pageSize, 2);
+    REQUIRE(alloc.GetOSStats().arenaFree == ARENA_BYTES - 6*pageSize);
+    char* const ptr3 { static_cast<char*>(alloc.alloc(2)) };
+    REQUIRE(ptr3 == ptr1+pageSize);
+
+    // allocations larger than an arena are mapped directly
+    char* const big { static_cast<char*>(alloc.alloc(arenaPages+1)) };
+    REQUIRE(alloc.GetOSStats().arenas == 1);
+    alloc.free(big, arenaPages+1);
+
+    // a full arena means a new one is mapped
+    char* const full { static_cast<char*>(alloc.alloc(arenaPages)) };
+    REQUIRE(alloc.GetOSStats().arenas == 2);
+    alloc.free(full, arenaPages);
+    REQUIRE(alloc.GetOSStats().arenas == 1);
+
+    // the arena is unmapped once empty
+    alloc.free(ptr1, 1); alloc.free(ptr3, 2);
+    alloc.free(ptr1+3*pageSize, 1); alloc.free(ptr2, 4);
+    stats = alloc.GetOSStats();
+    REQUIRE(stats.arenas == 0);
+    REQUIRE(stats.arenaFree == 0);
+#endif // WIN32
+}
+
+/*****************************************************/
+TEST_CASE("TestHugePages", "[MemoryAllocator]")
+{
+    // huge pages are only a hint, falls back if not available
+    for (const bool hugeTLB : { false, true })
+    {
+        MemoryAllocator alloc(true, true, hugeTLB);
+        char* const ptr { static_cast<char*>(alloc.alloc(1)) };
+        std::memset(ptr, 1, alloc.getPageSize());
+        alloc.free(ptr, 1);
+        REQUIRE(alloc.GetOSStats().arenas == 0);
+    }
+}
+
+} // namespace
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
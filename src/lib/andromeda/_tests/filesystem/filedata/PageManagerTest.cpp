@@ -0,0 +1,464 @@
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "../testBackend.hpp"
+#include "../../testThreads.hpp"
+#include "andromeda/ConfigOptions.hpp"
+#include "andromeda/backend/BackendException.hpp"
+#include "andromeda/filesystem/File.hpp"
+#include "andromeda/filesystem/filedata/Page.hpp"
+#include "andromeda/filesystem/filedata/PageBackend.hpp"
+#include "andromeda/filesystem/filedata/PageManager.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+
+/** Access to PageManager internals for testing */
+class PageManagerTest
+{
+public:
+    static constexpr size_t HINT_SLOTS { PageManager::HINT_SLOTS };
+
+    static const Page* GetPageHint(const PageManager& pageMgr, const uint64_t index) { 
+        return pageMgr.GetPageHint(index); }
+
+    static const Page* TryGetPageFast(const PageManager& pageMgr, const uint64_t index, const SharedLock& thisLock) { 
+        return pageMgr.TryGetPageFast(index, thisLock); }
+
+    static std::mutex& GetPagesMutex(PageManager& pageMgr) { return pageMgr.mPagesMutex; }
+
+    static size_t GetFetchSplit(const PageManager& pageMgr, const size_t readCount) {
+        return pageMgr.GetFetchSplit(readCount); }
+
+    /** Fetches count pages at index as a read would and waits for all of them */
+    static void Fetch(PageManager& pageMgr, const uint64_t index, const size_t count)
+    {
+        PageManager::UniqueLock pagesLock(pageMgr.mPagesMutex);
+        pageMgr.StartFetch(index, count, FetchPool::Priority::SYNC, pagesLock);
+        pageMgr.mPagesCV.wait(pagesLock, [&](){ return pageMgr.mPendingPages.empty(); });
+    }
+
+    /** Returns true if the page at index is cached */
+    static bool isCached(PageManager& pageMgr, const uint64_t index)
+    {
+        const PageManager::UniqueLock pagesLock(pageMgr.mPagesMutex);
+        return pageMgr.mPages.find(index) != pageMgr.mPages.end();
+    }
+
+    /** Returns true if the last fetch of the page at index failed */
+    static bool isFailed(PageManager& pageMgr, const uint64_t index)
+    {
+        const PageManager::UniqueLock pagesLock(pageMgr.mPagesMutex);
+        return pageMgr.isFetchFailed(index, pagesLock) != nullptr;
+    }
+};
+
+namespace { // anonymous
+
+constexpr size_t PAGE_SIZE { 4096 };
+
+/** Returns options with small pages and parallel flushing */
+ConfigOptions GetOptions()
+{
+    ConfigOptions options;
+    options.pageSize = PAGE_SIZE;
+    options.flushThreads = 4;
+    options.runnerPoolSize = 4;
+    return options;
+}
+
+/** Returns options where each fetch is a single page with no read-ahead */
+ConfigOptions GetHintOptions()
+{
+    ConfigOptions options { GetOptions() };
+    options.readAheadBuffer = 0;
+    options.readAheadTime = std::chrono::milliseconds(0);
+    return options;
+}
+
+/** Returns file data where each page is filled with a different character */
+std::string GetPagesData(const size_t pages)
+{
+    std::string data;
+    for (size_t page { 0 }; page < pages; ++page)
+        data += std::string(PAGE_SIZE, static_cast<char>('a'+page%26));
+    return data;
+}
+
+/** A PageManager for a file in a TestBackend, separate from the file's own */
+class TestPageManager
+{
+public:
+    TestPageManager(TestBackend& backend, const std::string& data) :
+        mFileID(backend.GetServer().AddFile("file", data)),
+        mFile(backend.GetRoot().GetFileByPath("file")),
+        mPageBackend(*mFile, mFileID, data.size(), PAGE_SIZE),
+        mPageMgr(*mFile, data.size(), PAGE_SIZE, mPageBackend) { }
+
+    const std::string& GetFileID() const { return mFileID; }
+    File& GetFile() { return *mFile; }
+    PageManager& GetPageManager() { return mPageMgr; }
+
+    /** Reads the whole page at index */
+    std::string Read(const uint64_t index)
+    {
+        const SharedLockR fileLock { mFile->GetReadLock() };
+        std::string buf(PAGE_SIZE, '\0');
+        mPageMgr.ReadPage(buf.data(), index, 0, buf.size(), fileLock);
+        return buf;
+    }
+
+    /** Reads the whole page at index in another thread */
+    std::future<std::string> ReadAsync(const uint64_t index)
+    {
+        return std::async(std::launch::async, [this,index](){ return Read(index); });
+    }
+
+private:
+    const std::string mFileID;
+    File::ScopeLocked mFile;
+    PageBackend mPageBackend;
+    PageManager mPageMgr;
+};
+
+} // namespace
+
+/*****************************************************/
+TEST_CASE("FlushFailedRuns", "[PageManager]")
+{
+    TestBackend backend(GetOptions());
+    MockServer& server { backend.GetServer() };
+    const std::string fileID { server.AddFile("file", std::string(PAGE_SIZE*5, 'a')) };
+    File::ScopeLocked file { backend.GetRoot().GetFileByPath("file") };
+
+    // pages 0, 2 and 4 are separate runs, the ones at page 2 and 4 fail
+    const std::string page(PAGE_SIZE, 'b');
+    { const SharedLockW fileLock { file->GetWriteLock() };
+        for (const size_t index : {0, 2, 4})
+            file->WriteBytes(page.data(), index*PAGE_SIZE, PAGE_SIZE, fileLock); }
+
+    std::atomic<size_t> failures { 0 };
+    server.SetHook([&](const MockServer::RunnerInput& input)
+    {
+        if (input.action != "writefile") return;
+        const size_t offset { std::stoul(input.dataParams.at("offset")) };
+        if (offset == PAGE_SIZE*2 || offset == PAGE_SIZE*4)
+        {
+            ++failures;
+            throw Backend::BackendException("test failure at "+std::to_string(offset));
+        }
+    });
+
+    { const SharedLockW fileLock { file->GetWriteLock() };
+        REQUIRE_THROWS_AS(file->FlushCache(fileLock), Backend::BackendException); }
+
+    // every run was attempted, the successful one was written
+    REQUIRE(failures == 2);
+    REQUIRE(server.GetCount("writefile") == 1);
+    std::string expect { page+std::string(PAGE_SIZE*4, 'a') };
+    REQUIRE(server.GetData(fileID) == expect);
+
+    // only the failed runs are still dirty
+    server.SetHook(nullptr);
+    { const SharedLockW fileLock { file->GetWriteLock() };
+        file->FlushCache(fileLock); }
+    REQUIRE(server.GetCount("writefile") == 3);
+
+    expect = page+std::string(PAGE_SIZE, 'a')+page+std::string(PAGE_SIZE, 'a')+page;
+    REQUIRE(server.GetData(fileID) == expect);
+
+    { const SharedLockW fileLock { file->GetWriteLock() };
+        file->FlushCache(fileLock); }
+    REQUIRE(server.GetCount("writefile") == 3);
+}
+
+/*****************************************************/
+TEST_CASE("ReadDirectCached", "[PageManager]")
+{
+    TestBackend backend(GetOptions());
+    MockServer& server { backend.GetServer() };
+
+    std::string data; // one whole page and a bit
+    for (size_t i { 0 }; i < PAGE_SIZE+100; ++i) data += static_cast<char>('a'+i%26);
+
+    server.AddFile("small", data.substr(0, 100));
+    server.AddFile("large", data);
+
+    SECTION("Small file")
+    {
+        File::ScopeLocked file { backend.GetRoot().GetFileByPath("small") };
+        const SharedLockR fileLock { file->GetReadLock() };
+
+        for (size_t i { 0 }; i < 2; ++i)
+        {
+            std::string buf(100, '\0');
+            file->ReadBytes(buf.data(), 0, buf.size(), fileLock);
+            REQUIRE(buf == data.substr(0, 100));
+        }
+        REQUIRE(server.GetCount("download") == 1);
+    }
+
+    SECTION("First page")
+    {
+        File::ScopeLocked file { backend.GetRoot().GetFileByPath("large") };
+        const SharedLockR fileLock { file->GetReadLock() };
+
+        for (size_t i { 0 }; i < 2; ++i)
+        {
+            std::string buf(PAGE_SIZE, '\0');
+            file->ReadBytes(buf.data(), 0, buf.size(), fileLock);
+            REQUIRE(buf == data.substr(0, PAGE_SIZE));
+        }
+        REQUIRE(server.GetCount("download") == 1);
+
+        // a partial read of the same page is also cached
+        std::string buf(10, '\0');
+        file->ReadBytes(buf.data(), 5, buf.size(), fileLock);
+        REQUIRE(buf == data.substr(5, 10));
+        REQUIRE(server.GetCount("download") == 1);
+    }
+}
+
+/*****************************************************/
+TEST_CASE("WriteRefRollback", "[PageManager]")
+{
+    TestBackend backend(GetOptions());
+    MockServer& server { backend.GetServer() };
+    const std::string fileID { server.AddFile("file", std::string(PAGE_SIZE, 'a')) };
+
+    File::ScopeLocked file { backend.GetRoot().GetFileByPath("file") };
+    const SharedLockW fileLock { file->GetWriteLock() };
+
+    SECTION("Short fill")
+    {
+        // extend by two pages but the data runs out halfway through the first
+        const size_t written { file->WriteBytes([&](char* buffer, const size_t length)->size_t
+        {
+            const size_t filled { std::min(length, PAGE_SIZE/2) };
+            std::memset(buffer, 'b', filled); return filled;
+        }, PAGE_SIZE, PAGE_SIZE*2, fileLock) };
+
+        REQUIRE(written == PAGE_SIZE/2);
+        REQUIRE(file->GetSize(fileLock) == PAGE_SIZE+PAGE_SIZE/2);
+
+        file->FlushCache(fileLock);
+        REQUIRE(server.GetData(fileID) == std::string(PAGE_SIZE, 'a')+std::string(PAGE_SIZE/2, 'b'));
+    }
+
+    SECTION("Failed fill")
+    {
+        const auto failFunc { [&](char* buffer, const size_t length)->size_t
+        {
+            std::memset(buffer, 'b', length); // garbage
+            throw Backend::BackendException("test failure");
+        } };
+
+        // a new page past the end and an existing clean page
+        REQUIRE_THROWS_AS(file->WriteBytes(failFunc, PAGE_SIZE*2, 10, fileLock), Backend::BackendException);
+        REQUIRE_THROWS_AS(file->WriteBytes(failFunc, 10, 10, fileLock), Backend::BackendException);
+        REQUIRE(file->GetSize(fileLock) == PAGE_SIZE);
+
+        file->FlushCache(fileLock);
+        REQUIRE(server.GetCount("writefile") == 0);
+
+        // the dropped page is read again rather than exposing the garbage
+        std::string buf(PAGE_SIZE, '\0');
+        file->ReadBytes(buf.data(), 0, buf.size(), fileLock);
+        REQUIRE(buf == std::string(PAGE_SIZE, 'a'));
+    }
+}
+
+/*****************************************************/
+TEST_CASE("PageHintFastPath", "[PageManager]")
+{
+    TestBackend backend(GetHintOptions());
+    const std::string data { GetPagesData(3) };
+    TestPageManager testMgr(backend, data);
+    PageManager& pageMgr { testMgr.GetPageManager() };
+
+    REQUIRE(testMgr.Read(1) == data.substr(PAGE_SIZE, PAGE_SIZE));
+    REQUIRE(PageManagerTest::GetPageHint(pageMgr, 1) != nullptr);
+
+    // a hinted hit never takes the pages lock
+    std::future<std::string> read; bool ready { false };
+    { const std::lock_guard<std::mutex> pagesLock(PageManagerTest::GetPagesMutex(pageMgr));
+        read = testMgr.ReadAsync(1);
+        ready = (read.wait_for(std::chrono::seconds(5)) == std::future_status::ready); }
+    REQUIRE(ready);
+    REQUIRE(read.get() == data.substr(PAGE_SIZE, PAGE_SIZE));
+
+    // an unhinted page takes the slow path
+    { const std::lock_guard<std::mutex> pagesLock(PageManagerTest::GetPagesMutex(pageMgr));
+        read = testMgr.ReadAsync(2);
+        REQUIRE(read.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout); }
+    REQUIRE(read.get() == data.substr(PAGE_SIZE*2, PAGE_SIZE));
+    REQUIRE(backend.GetServer().GetCount("download") == 2);
+}
+
+/*****************************************************/
+TEST_CASE("PageHintCollision", "[PageManager]")
+{
+    constexpr size_t HINT_SLOTS { PageManagerTest::HINT_SLOTS };
+    TestBackend backend(GetHintOptions());
+    const std::string data { GetPagesData(HINT_SLOTS+2) };
+    TestPageManager testMgr(backend, data);
+    PageManager& pageMgr { testMgr.GetPageManager() };
+
+    // pages 1 and 1+HINT_SLOTS share a hint slot, the later one wins
+    static_cast<void>(testMgr.Read(1));
+    REQUIRE(testMgr.Read(1+HINT_SLOTS) == data.substr((1+HINT_SLOTS)*PAGE_SIZE, PAGE_SIZE));
+    REQUIRE(PageManagerTest::GetPageHint(pageMgr, 1) == nullptr);
+    REQUIRE(PageManagerTest::GetPageHint(pageMgr, 1+HINT_SLOTS) != nullptr);
+    { const SharedLockR fileLock { testMgr.GetFile().GetReadLock() };
+        REQUIRE(PageManagerTest::TryGetPageFast(pageMgr, 1, fileLock) == nullptr); }
+
+    // page 1 is still cached, but read through the slow path which takes the pages lock
+    std::future<std::string> read;
+    { const std::lock_guard<std::mutex> pagesLock(PageManagerTest::GetPagesMutex(pageMgr));
+        read = testMgr.ReadAsync(1);
+        REQUIRE(read.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout); }
+    REQUIRE(read.get() == data.substr(PAGE_SIZE, PAGE_SIZE));
+    REQUIRE(backend.GetServer().GetCount("download") == 2);
+
+    // which hints it again
+    REQUIRE(PageManagerTest::GetPageHint(pageMgr, 1) != nullptr);
+    REQUIRE(PageManagerTest::GetPageHint(pageMgr, 1+HINT_SLOTS) == nullptr);
+}
+
+/*****************************************************/
+TEST_CASE("PageHintRemoved", "[PageManager]")
+{
+    TestBackend backend(GetHintOptions());
+    MockServer& server { backend.GetServer() };
+    const std::string data { GetPagesData(3) };
+    TestPageManager testMgr(backend, data);
+    PageManager& pageMgr { testMgr.GetPageManager() };
+    File& file { testMgr.GetFile() };
+    server.SetData(testMgr.GetFileID(), std::string(data.size(), 'z')); // seen only if re-fetched
+
+    SECTION("Evicted")
+    {
+        static_cast<void>(testMgr.Read(1));
+        REQUIRE(PageManagerTest::GetPageHint(pageMgr, 1) != nullptr);
+        { const SharedLockW fileLock { file.GetWriteLock() };
+            pageMgr.EvictPage(1, fileLock); }
+        REQUIRE(PageManagerTest::GetPageHint(pageMgr, 1) == nullptr);
+        REQUIRE(testMgr.Read(1) == std::string(PAGE_SIZE, 'z'));
+    }
+
+    SECTION("Truncated")
+    {
+        static_cast<void>(testMgr.Read(2));
+        REQUIRE(PageManagerTest::GetPageHint(pageMgr, 2) != nullptr);
+        { const SharedLockW fileLock { file.GetWriteLock() };
+            pageMgr.Truncate(PAGE_SIZE*2, fileLock); 
+            pageMgr.Truncate(PAGE_SIZE*3, fileLock); } // now a hole
+        REQUIRE(PageManagerTest::GetPageHint(pageMgr, 2) == nullptr);
+        REQUIRE(testMgr.Read(2) == std::string(PAGE_SIZE, '\0'));
+    }
+}
+
+/*****************************************************/
+TEST_CASE("PageHintEvictRace", "[PageManager]")
+{
+    constexpr size_t PAGES { 8 };
+    constexpr size_t READS { 500 };
+
+    TestBackend backend(GetHintOptions());
+    const std::string data { GetPagesData(PAGES) };
+    TestPageManager testMgr(backend, data);
+    PageManager& pageMgr { testMgr.GetPageManager() };
+
+    // thread 0 keeps evicting pages while the others read them through hints where possible
+    std::atomic<size_t> wrongData { 0 };
+    RunThreads([&](const size_t thread)
+    {
+        for (size_t i { 0 }; i < READS; ++i)
+        {
+            const uint64_t index { 1 + (i+thread) % (PAGES-1) };
+            if (thread == 0)
+            {
+                const SharedLockW fileLock { testMgr.GetFile().GetWriteLock() };
+                pageMgr.EvictPage(index, fileLock);
+            }
+            else if (testMgr.Read(index) != data.substr(index*PAGE_SIZE, PAGE_SIZE)) ++wrongData;
+        }
+    });
+    REQUIRE(wrongData == 0);
+}
+
+/*****************************************************/
+TEST_CASE("FetchSplit", "[PageManager]")
+{
+    ConfigOptions options { GetHintOptions() };
+    options.runnerPoolMin = options.runnerPoolSize; // 4
+    options.readSplitSize = PAGE_SIZE*2 + 1; // rounds up to 3 pages
+    TestBackend backend(options);
+    MockServer& server { backend.GetServer() };
+    const std::string data { GetPagesData(32) };
+    TestPageManager testMgr(backend, data);
+    PageManager& pageMgr { testMgr.GetPageManager() };
+
+    REQUIRE(PageManagerTest::GetFetchSplit(pageMgr, 1) == 1);
+    REQUIRE(PageManagerTest::GetFetchSplit(pageMgr, 5) == 1);
+    REQUIRE(PageManagerTest::GetFetchSplit(pageMgr, 6) == 2);
+    REQUIRE(PageManagerTest::GetFetchSplit(pageMgr, 12) == 4);
+    REQUIRE(PageManagerTest::GetFetchSplit(pageMgr, 30) == 4); // runnerPoolSize
+
+    using Range = std::pair<size_t, size_t>; // fstart, flast
+    std::mutex rangesMutex; std::vector<Range> ranges;
+    uint64_t failStart { 0 };
+    server.SetHook([&](const MockServer::RunnerInput& input)
+    {
+        if (input.action != "download") return;
+        const Range range { std::stoul(input.dataParams.at("fstart")), std::stoul(input.dataParams.at("flast")) };
+        { const std::lock_guard<std::mutex> lock(rangesMutex); ranges.push_back(range); }
+        if (range.first == failStart) throw Backend::BackendException("test failure");
+    });
+
+    PageManagerTest::Fetch(pageMgr, 1, 14);
+    REQUIRE(ranges.size() == 4);
+    std::sort(ranges.begin(), ranges.end());
+
+    // consecutive and non-overlapping, covering exactly the fetch
+    REQUIRE(ranges.front().first == PAGE_SIZE);
+    REQUIRE(ranges.back().second == PAGE_SIZE*15-1);
+    for (size_t range { 0 }; range < ranges.size(); ++range)
+    {
+        REQUIRE(ranges[range].second+1 - ranges[range].first >= options.readSplitSize);
+        if (range) REQUIRE(ranges[range].first == ranges[range-1].second+1);
+    }
+    for (uint64_t index { 1 }; index < 15; ++index)
+        REQUIRE(PageManagerTest::isCached(pageMgr, index));
+    REQUIRE(testMgr.Read(14) == data.substr(PAGE_SIZE*14, PAGE_SIZE));
+    REQUIRE(server.GetCount("download") == 4);
+
+    // the same split 15 pages later, with the second range failing
+    const std::vector<Range> split { ranges }; ranges.clear();
+    failStart = split[1].first + PAGE_SIZE*15;
+    PageManagerTest::Fetch(pageMgr, 16, 14);
+    REQUIRE(ranges.size() == 4);
+
+    // only the failed range's pages failed
+    for (uint64_t index { 16 }; index < 30; ++index)
+    {
+        const bool failed { index*PAGE_SIZE >= failStart && index*PAGE_SIZE <= split[1].second + PAGE_SIZE*15 };
+        REQUIRE(PageManagerTest::isFailed(pageMgr, index) == failed);
+        REQUIRE(PageManagerTest::isCached(pageMgr, index) == !failed);
+    }
+}
+
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
@@ -0,0 +1,141 @@
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "andromeda/filesystem/filedata/PageTable.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+namespace { // anonymous
+
+using TestT = PageTable<std::string>;
+
+/** Returns the list of indexes in the table, in iteration order */
+std::vector<uint64_t> GetIndexes(const TestT& table)
+{
+    std::vector<uint64_t> ret;
+    for (const TestT::value_type& entry : table)
+        ret.push_back(entry.first);
+    return ret;
+}
+
+/*****************************************************/
+TEST_CASE("TestBasic", "[PageTable]")
+{
+    TestT table;
+    REQUIRE(table.empty());
+    REQUIRE(table.begin() == table.end());
+
+    REQUIRE(table.try_emplace(5, "five").second);
+    REQUIRE(table.emplace(200, "twohundred").second);
+    REQUIRE(table.try_emplace(63, "sixtythree").second);
+    REQUIRE(table.try_emplace(64, "sixtyfour").second);
+    REQUIRE(!table.try_emplace(5, "other").second); // no overwrite
+    REQUIRE(table.size() == 4);
+
+    REQUIRE(table.find(5)->second == "five");
+    REQUIRE(table.find(6) == table.end());
+    REQUIRE(table.find(1000) == table.end());
+
+    REQUIRE(GetIndexes(table) == std::vector<uint64_t>{5, 63, 64, 200});
+
+    REQUIRE(table.upper_bound(0)->first == 5);
+    REQUIRE(table.upper_bound(5)->first == 63);
+    REQUIRE(table.upper_bound(63)->first == 64);
+    REQUIRE(table.upper_bound(64)->first == 200);
+    REQUIRE(table.upper_bound(200) == table.end());
+    REQUIRE(table.lower_bound(64)->first == 64);
+
+    const TestT::const_iterator cit { table.find(63) };
+    REQUIRE(cit->second == "sixtythree");
+}
+
+/*****************************************************/
+TEST_CASE("TestErase", "[PageTable]")
+{
+    TestT table;
+    for (uint64_t index { 0 }; index < 300; index += 3)
+        table.try_emplace(index, std::to_string(index));
+    REQUIRE(table.size() == 100);
+
+    // entry addresses are stable while others are added/removed
+    const std::string* const entry { &table.find(150)->second };
+
+    REQUIRE(table.erase(151) == 0);
+    REQUIRE(table.erase(0) == 1);
+    REQUIRE(table.find(0) == table.end());
+
+    for (TestT::iterator it { table.begin() }; it != table.end(); )
+    {
+        if (it->first != 150 && it->first % 2 == 0)
+            it = table.erase(it);
+        else ++it;
+    }
+    for (uint64_t index { 1000 }; index < 2000; ++index)
+        table.try_emplace(index, "new");
+
+    REQUIRE(&table.find(150)->second == entry);
+    REQUIRE(*entry == "150");
+
+    for (const TestT::value_type& pair : table)
+        REQUIRE((pair.first % 2 == 1 || pair.first == 150 || pair.first >= 1000));
+
+    while (!table.empty()) table.erase(table.begin());
+    REQUIRE(table.begin() == table.end());
+    REQUIRE(table.upper_bound(0) == table.end());
+}
+
+/*****************************************************/
+TEST_CASE("PageIndexLookups", "[.benchmark][PageTable]")
+{
+    constexpr uint64_t PAGES { 131072 }; // 16G file of 128K pages
+    using Entry = std::unique_ptr<char[]>; // stand-in for Page's data pointer
+
+    std::map<uint64_t, Entry> map;
+    PageTable<Entry> table;
+    for (uint64_t index { 0 }; index < PAGES; index += 2)
+    {
+        map.try_emplace(index); table.try_emplace(index);
+    }
+
+    BENCHMARK("std::map find")
+    {
+        size_t found { 0 };
+        for (uint64_t index { 0 }; index < PAGES; ++index)
+            found += (map.find(index) != map.end());
+        return found;
+    };
+
+    BENCHMARK("PageTable find")
+    {
+        size_t found { 0 };
+        for (uint64_t index { 0 }; index < PAGES; ++index)
+            found += (table.find(index) != table.end());
+        return found;
+    };
+
+    BENCHMARK("std::map iterate")
+    {
+        uint64_t sum { 0 };
+        for (const decltype(map)::value_type& entry : map) sum += entry.first;
+        return sum;
+    };
+
+    BENCHMARK("PageTable iterate")
+    {
+        uint64_t sum { 0 };
+        for (const decltype(table)::value_type& entry : table) sum += entry.first;
+        return sum;
+    };
+}
+
+} // namespace
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
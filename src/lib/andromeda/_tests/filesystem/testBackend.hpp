@@ -0,0 +1,271 @@
+#ifndef LIBA2_TESTBACKEND_H_
+#define LIBA2_TESTBACKEND_H_
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "nlohmann/json.hpp"
+
+#include "andromeda/ConfigOptions.hpp"
+#include "andromeda/backend/BackendImpl.hpp"
+#include "andromeda/backend/BaseRunner.hpp"
+#include "andromeda/backend/Config.hpp"
+#include "andromeda/backend/RunnerInput.hpp"
+#include "andromeda/backend/RunnerPool.hpp"
+#include "andromeda/filesystem/folders/PlainFolder.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+
+/**
+ * An in-memory files app server for testing, shared by all of its runners
+ * Serves one filesystem with a tree of folders and files starting at ID "root"
+ */
+class MockServer
+{
+public:
+    using RunnerInput = Backend::RunnerInput;
+
+    /** @param sttype the storage type of the filesystem (see FSConfig) */
+    explicit MockServer(std::string sttype) :
+        mSttype(std::move(sttype)), mFsID("fs"+mSttype) { }
+
+    /** Function called at the start of every request with no locks held, may block or throw */
+    using Hook = std::function<void (const RunnerInput&)>;
+    /** Sets the hook to call at the start of every request */
+    void SetHook(Hook hook) { const LockGuard lock(mMutex); mHook = std::move(hook); }
+
+    /** Adds a new file with the given content to the given folder, returns its ID */
+    std::string AddFile(const std::string& name, const std::string& data, const std::string& parent = "root")
+    {
+        const LockGuard lock(mMutex); return AddItem(name, parent, false, data);
+    }
+
+    /** Adds a new empty folder to the given folder, returns its ID */
+    std::string AddFolder(const std::string& name, const std::string& parent = "root")
+    {
+        const LockGuard lock(mMutex); return AddItem(name, parent, true, "");
+    }
+
+    /** Returns the content of the file with the given ID */
+    std::string GetData(const std::string& id) const
+    {
+        const LockGuard lock(mMutex); return mItems.at(id).data;
+    }
+
+    /** Sets the content of the file with the given ID */
+    void SetData(const std::string& id, const std::string& data)
+    {
+        const LockGuard lock(mMutex); mItems.at(id).data = data;
+    }
+
+    /** Returns the number of requests completed for the given app action */
+    size_t GetCount(const std::string& action) const
+    {
+        const LockGuard lock(mMutex);
+        const decltype(mCounts)::const_iterator it { mCounts.find(action) };
+        return (it != mCounts.end()) ? it->second : 0;
+    }
+
+    /** 
+     * Returns the JSON response for a request
+     * @param fileData the file input data if any
+     * @param fileName the name of the file input if any
+     */
+    std::string Respond(const RunnerInput& input, const std::string* fileData = nullptr, const std::string& fileName = "")
+    {
+        RunHook(input);
+        const LockGuard lock(mMutex);
+        ++mCounts[input.action];
+        return nlohmann::json {{"ok",true},{"appdata",GetAppdata(input, fileData, fileName)}}.dump();
+    }
+
+    /** Returns the JSON response for a writefile or upload request with its input stream */
+    std::string RespondStream(const RunnerInput& input, const Backend::RunnerInput_StreamIn::FileStream& fstream)
+    {
+        const Backend::WriteFunc& streamer { fstream.streamer };
+        std::string data; std::array<char,4096> buf {}; // NOLINT(readability-magic-numbers)
+        for (bool more { true }; more; )
+        {
+            size_t read { 0 }; more = streamer(data.size(), buf.data(), buf.size(), read);
+            data.append(buf.data(), read);
+        }
+        return Respond(input, &data, fstream.name);
+    }
+
+    /** Handles a download request with its output stream */
+    void RespondOut(const Backend::RunnerInput_StreamOut& input)
+    {
+        RunHook(input);
+        std::string data;
+        { const LockGuard lock(mMutex);
+            ++mCounts[input.action];
+            const size_t fstart { std::stoul(input.dataParams.at("fstart")) };
+            const size_t flast { std::stoul(input.dataParams.at("flast")) };
+            data = mItems.at(input.plainParams.at("file")).data.substr(fstart, flast+1-fstart);
+        }
+        input.streamer(0, data.data(), data.size());
+    }
+
+private:
+
+    using LockGuard = std::lock_guard<std::mutex>;
+
+    struct MockItem
+    {
+        std::string name;
+        std::string parent;
+        bool folder;
+        std::string data;
+    };
+
+    void RunHook(const RunnerInput& input)
+    {
+        Hook hook; { const LockGuard lock(mMutex); hook = mHook; }
+        if (hook) hook(input);
+    }
+
+    std::string AddItem(const std::string& name, const std::string& parent, bool folder, const std::string& data)
+    {
+        const std::string id { "id"+std::to_string(++mNextID) };
+        mItems.emplace(id, MockItem{name, parent, folder, data});
+        return id;
+    }
+
+    nlohmann::json GetItemJ(const std::string& id) const
+    {
+        const MockItem& item { mItems.at(id) };
+        nlohmann::json retval {{"id",id},{"name",item.name},{"filesystem",mFsID}};
+        retval["dates"] = {{"created",0},{"modified",nullptr},{"accessed",nullptr}};
+        if (!item.folder) retval["size"] = item.data.size();
+        return retval;
+    }
+
+    nlohmann::json GetFolderJ(const std::string& id) const
+    {
+        nlohmann::json retval((id == "root") ? nlohmann::json{{"id",id},{"name",""},{"filesystem",mFsID}} : GetItemJ(id));
+        retval["dates"] = {{"created",0},{"modified",nullptr},{"accessed",nullptr}};
+        retval["files"] = nlohmann::json::array(); retval["folders"] = nlohmann::json::array();
+        for (const decltype(mItems)::value_type& item : mItems)
+            if (item.second.parent == id)
+                retval[item.second.folder ? "folders" : "files"].push_back(GetItemJ(item.first));
+        return retval;
+    }
+
+    nlohmann::json GetAppdata(const RunnerInput& input, const std::string* fileData, const std::string& fileName)
+    {
+        const RunnerInput::Params& params { input.plainParams };
+        const std::string& action { input.action };
+
+        // NOTE a single-pair initializer list would make an array, not an object
+        if (input.app == "core") return {{"api",Backend::Config::API_VERSION},
+            {"apps",{{"core",""},{"accounts",""},{"files",""}}},{"features",nlohmann::json::object({{"read_only",false}})}};
+
+        if (action == "getconfig") return nlohmann::json::object({{"upload_maxbytes",nullptr}});
+        if (action == "getfilesystem") return {{"readonly",false},{"sttype",mSttype}};
+        if (action == "getlimits") return nullptr;
+        if (action == "getfolder") return GetFolderJ(params.at("folder"));
+        if (action == "createfolder") return GetItemJ(AddItem(input.dataParams.at("name"), params.at("parent"), true, ""));
+        if (action == "deletefile") { mItems.erase(params.at("file")); return nullptr; }
+        if (action == "deletefolder") { mItems.erase(params.at("folder")); return nullptr; }
+
+        if (action == "renamefile" || action == "renamefolder" || action == "movefile" || action == "movefolder")
+        {
+            const std::string& id { params.at(action.find("file") != std::string::npos ? "file" : "folder") };
+            if (action.find("rename") == 0) mItems.at(id).name = input.dataParams.at("name");
+            else mItems.at(id).parent = params.at("parent");
+            return GetItemJ(id);
+        }
+
+        if (action == "upload") // create with data
+            return GetItemJ(AddItem(fileName, params.at("parent"), false, *fileData));
+
+        if (action == "writefile")
+        {
+            std::string& data { mItems.at(params.at("file")).data };
+            const size_t offset { std::stoul(input.dataParams.at("offset")) };
+            if (data.size() < offset + fileData->size()) data.resize(offset + fileData->size());
+            data.replace(offset, fileData->size(), *fileData);
+            return GetItemJ(params.at("file"));
+        }
+
+        if (action == "ftruncate")
+        {
+            mItems.at(params.at("file")).data.resize(std::stoul(input.dataParams.at("size")));
+            return GetItemJ(params.at("file"));
+        }
+
+        throw Backend::BackendException("unknown action "+action);
+    }
+
+    mutable std::mutex mMutex;
+    const std::string mSttype;
+    const std::string mFsID;
+    std::map<std::string, MockItem> mItems;
+    size_t mNextID { 0 };
+    std::map<std::string, size_t> mCounts;
+    Hook mHook;
+};
+
+/** A runner that sends all requests to a MockServer */
+class MockRunner : public Backend::BaseRunner
+{
+public:
+    explicit MockRunner(MockServer& server) : mServer(server) { }
+
+    [[nodiscard]] std::unique_ptr<BaseRunner> Clone() const override {
+        return std::make_unique<MockRunner>(mServer); }
+
+    [[nodiscard]] std::string GetHostname() const override { return "mock"; }
+
+    std::string RunAction_Read(const Backend::RunnerInput& input) override { return mServer.Respond(input); }
+    std::string RunAction_Write(const Backend::RunnerInput& input) override { return mServer.Respond(input); }
+
+    std::string RunAction_FilesIn(const Backend::RunnerInput_FilesIn& input) override {
+        return mServer.Respond(input, &input.files.at("file").data, input.files.at("file").name); }
+
+    std::string RunAction_StreamIn(const Backend::RunnerInput_StreamIn& input) override {
+        return mServer.RespondStream(input, input.fstreams.begin()->second); }
+
+    void RunAction_StreamOut(const Backend::RunnerInput_StreamOut& input) override { mServer.RespondOut(input); }
+
+    [[nodiscard]] bool RequiresSession() const override { return false; }
+
+private:
+    MockServer& mServer;
+};
+
+/** A real BackendImpl and root folder backed by a MockServer */
+class TestBackend
+{
+public:
+    /** @param sttype the storage type of the filesystem (see FSConfig) */
+    explicit TestBackend(const ConfigOptions& options = ConfigOptions(), const std::string& sttype = "Local") :
+        mServer(sttype), mRunner(mServer), mRunners(mRunner, options), mBackend(options, mRunners) { }
+
+    MockServer& GetServer() { return mServer; }
+    Backend::BackendImpl& GetBackend() { return mBackend; }
+
+    /** Returns the root folder, loading it the first time */
+    Folders::PlainFolder& GetRoot()
+    {
+        if (!mRoot) mRoot = Folders::PlainFolder::LoadByID(mBackend, "root");
+        return *mRoot;
+    }
+
+private:
+    MockServer mServer;
+    MockRunner mRunner;
+    Backend::RunnerPool mRunners;
+    Backend::BackendImpl mBackend;
+    std::unique_ptr<Folders::PlainFolder> mRoot;
+};
+
+} // namespace Filesystem
+} // namespace Andromeda
+
+#endif // LIBA2_TESTBACKEND_H_
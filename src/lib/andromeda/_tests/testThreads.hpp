@@ -0,0 +1,25 @@
+#ifndef LIBA2_TESTTHREADS_H_
+#define LIBA2_TESTTHREADS_H_
+
+#include <cstddef>
+#include <list>
+#include <thread>
+
+namespace Andromeda {
+
+/** The default number of threads for concurrency tests */
+constexpr size_t TEST_THREADS { 8 };
+
+/** Runs func(threadIdx) on the given number of threads and waits for them */
+template<typename Func>
+void RunThreads(const Func& func, const size_t count = TEST_THREADS)
+{
+    std::list<std::thread> threads;
+    for (size_t thread { 0 }; thread < count; ++thread)
+        threads.emplace_back(func, thread);
+    for (std::thread& thread : threads) thread.join();
+}
+
+} // namespace Andromeda
+
+#endif // LIBA2_TESTTHREADS_H_
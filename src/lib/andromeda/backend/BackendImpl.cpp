@@ -19,6 +19,8 @@
 #include "andromeda/filesystem/filedata/CacheManager.hpp"
 #include "andromeda/filesystem/filedata/CachingAllocator.hpp"
 using Andromeda::Filesystem::Filedata::CachingAllocator;
+#include "andromeda/filesystem/filedata/FetchPool.hpp"
+using Andromeda::Filesystem::Filedata::FetchPool;
 
 namespace Andromeda {
 namespace Backend {
@@ -28,6 +30,7 @@ std::atomic<uint64_t> BackendImpl::sReqNext { 1 };
 /*****************************************************/
 BackendImpl::BackendImpl(const ConfigOptions& options, RunnerPool& runners) : 
     mOptions(options), mRunners(runners),
+    mFetchPool(std::make_unique<FetchPool>(mOptions.fetchThreads)),
     mDebug("Backend",this) , mConfig(*this)
     // loading mConfig now has the nice side effect of making sure any potential
     // HTTP->HTTPS redirect is out of the way before trying other actions!
@@ -40,6 +43,8 @@ BackendImpl::~BackendImpl()
 {
     MDBG_INFO("()");
 
+    mFetchPool.reset(); // finish running requests first
+
     try { CloseSession(); }
     catch (const BackendException& ex) 
     { 
@@ -58,6 +63,24 @@ CachingAllocator& BackendImpl::GetPageAllocator()
     return *mPageAllocator;
 }
 
+/*****************************************************/
+void BackendImpl::AddAsync(const void* owner, AsyncPriority priority, std::function<void ()> func)
+{
+    mFetchPool->AddJob(owner, priority, std::move(func));
+}
+
+/*****************************************************/
+void BackendImpl::PromoteAsync(const void* owner)
+{
+    mFetchPool->PromoteJobs(owner);
+}
+
+/*****************************************************/
+void BackendImpl::CancelAsync(const void* owner)
+{
+    mFetchPool->RemoveJobs(owner);
+}
+
 /*****************************************************/
 bool BackendImpl::isReadOnly() const
 {
@@ -186,27 +209,94 @@ std::string BackendImpl::RunAction_ReadStr(RunnerInput& input)
     return mRunners.GetRunner()->RunAction_Read(FinalizeInput(input));
 }
 
+/*****************************************************/
+std::string BackendImpl::GetInputKey(const RunnerInput& input)
+{
+    std::string key; // length-prefix each field so the key is unambiguous
+    const auto addField { [&](const std::string& str){ 
+        key += std::to_string(str.size()); key += ':'; key += str; } };
+
+    addField(input.app); addField(input.action);
+    for (const RunnerInput::Params* params : { &input.plainParams, &input.dataParams })
+    {
+        key += '|';
+        for (const RunnerInput::Params::value_type& param : *params) {
+            addField(param.first); addField(param.second); }
+    }
+    return key;
+}
+
 /*****************************************************/
 nlohmann::json BackendImpl::RunAction_Read(RunnerInput& input)
 {
-    return GetJSON(mRunners.GetRunner()->RunAction_Read(FinalizeInput(input)));
+    const std::string key { GetInputKey(input) };
+    std::promise<nlohmann::json> promise;
+    uint64_t gen { 0 };
+
+    { // lock scope
+        std::unique_lock<std::mutex> llock(mReadsMutex);
+        const decltype(mReadsInFlight)::iterator it { mReadsInFlight.find(key) };
+        if (it != mReadsInFlight.end()) // join the in-flight request
+        {
+            const std::shared_future<nlohmann::json> future { it->second.second };
+            llock.unlock();
+
+            const uint64_t coalesced { ++mCoalesced };
+            MDBG_INFO("... coalesced:" << coalesced << " " << input.app << " " << input.action);
+            return future.get(); // copy, may throw
+        }
+        gen = mReadsGen;
+        mReadsInFlight.emplace(key, std::make_pair(gen, promise.get_future().share()));
+    }
+
+    // if invalidated, the key may now belong to a newer request
+    const auto eraseKey { [&]()
+    {
+        const std::lock_guard<std::mutex> llock(mReadsMutex);
+        const decltype(mReadsInFlight)::iterator it { mReadsInFlight.find(key) };
+        if (it != mReadsInFlight.end() && it->second.first == gen) mReadsInFlight.erase(it);
+    } };
+
+    try
+    {
+        nlohmann::json retval(GetJSON(mRunners.GetRunner()->RunAction_Read(FinalizeInput(input))));
+        eraseKey();
+        promise.set_value(retval); // copy
+        return retval;
+    }
+    catch (...)
+    {
+        eraseKey();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+/*****************************************************/
+void BackendImpl::InvalidateReads()
+{
+    const std::lock_guard<std::mutex> llock(mReadsMutex);
+    ++mReadsGen; mReadsInFlight.clear(); // the owners still complete their promises
 }
 
 /*****************************************************/
 nlohmann::json BackendImpl::RunAction_Write(RunnerInput& input)
 {
+    const ReadsInvalidator invalidator(*this); // even if it fails
     return GetJSON(mRunners.GetRunner()->RunAction_Write(FinalizeInput(input)));
 }
 
 /*****************************************************/
 nlohmann::json BackendImpl::RunAction_FilesIn(RunnerInput_FilesIn& input)
 {
+    const ReadsInvalidator invalidator(*this); // even if it fails
     return GetJSON(mRunners.GetRunner()->RunAction_FilesIn(FinalizeInput(input)));
 }
 
 /*****************************************************/
 nlohmann::json BackendImpl::RunAction_StreamIn(RunnerInput_StreamIn& input)
 {
+    const ReadsInvalidator invalidator(*this); // even if it fails
     return GetJSON(mRunners.GetRunner()->RunAction_StreamIn(FinalizeInput(input)));
 }
 
@@ -416,6 +506,12 @@ nlohmann::json BackendImpl::GetFolder(const std::string& id)
     return RunAction_Read(input);
 }
 
+/*****************************************************/
+std::future<nlohmann::json> BackendImpl::GetFolderAsync(const void* owner, const std::string& id, AsyncPriority priority)
+{
+    return RunAsync(owner, priority, [this,id](){ return GetFolder(id); });
+}
+
 /*****************************************************/
 nlohmann::json BackendImpl::GetFSRoot(const std::string& id)
 {
@@ -669,6 +765,14 @@ void BackendImpl::ReadFile(const std::string& id, const uint64_t offset, const s
     if (read < length) throw ReadSizeException(length, read);
 }
 
+/*****************************************************/
+std::future<void> BackendImpl::ReadFileAsync(const void* owner, const std::string& id, const uint64_t offset, const size_t length, 
+    ReadFunc userFunc, AsyncPriority priority)
+{
+    return RunAsync(owner, priority, [this,id,offset,length,userFunc=std::move(userFunc)]()
+        { ReadFile(id, offset, length, userFunc); });
+}
+
 namespace { // anonymous
 // if we get a 413 this small the server must be bugged
 constexpr size_t UPLOAD_MINSIZE { 4096 };
@@ -695,7 +799,27 @@ nlohmann::json BackendImpl::WriteFile(const std::string& id, const uint64_t offs
 
     if (isMemory()) return nullptr; // debug only
 
-    return SendFile(userFunc, id, offset, nullptr, false);
+    return SendFile(userFunc, nullptr, id, offset, nullptr, false);
+}
+
+/*****************************************************/
+nlohmann::json BackendImpl::WriteFile(const std::string& id, const uint64_t offset, const WriteSpanFunc& userSpan)
+{
+    MDBG_INFO("(id:" << id << " offset:" << offset << ")");
+
+    if (isReadOnly()) throw ReadOnlyException();
+
+    if (isMemory()) return nullptr; // debug only
+
+    return SendFile(RunnerInput_StreamIn::FromSpans(userSpan), userSpan, id, offset, nullptr, false);
+}
+
+/*****************************************************/
+std::future<nlohmann::json> BackendImpl::WriteFileAsync(const void* owner, const std::string& id, const uint64_t offset, 
+    WriteSpanFunc userSpan, AsyncPriority priority)
+{
+    return RunAsync(owner, priority, [this,id,offset,userSpan=std::move(userSpan)]()
+        { return WriteFile(id, offset, userSpan); });
 }
 
 /*****************************************************/
@@ -723,16 +847,36 @@ nlohmann::json BackendImpl::UploadFile(const std::string& parent, const std::str
         return retval;
     }
 
-    return SendFile(userFunc, "", 0, [&](const WriteFunc& writeFunc)->RunnerInput_StreamIn
+    return SendFile(userFunc, nullptr, "", 0, [&](const WriteFunc& writeFunc, const WriteSpanFunc& writeSpan)->RunnerInput_StreamIn
     {
         return {{{"files", "upload", 
             {{"parent", parent}, {"overwrite", BOOLSTR(overwrite)}}}}, // plainParams
-            {{"file", {name, writeFunc}}}}; // StreamIn
+            {{"file", {name, writeFunc, writeSpan}}}}; // StreamIn
     }, oneshot);
 }
 
 /*****************************************************/
-nlohmann::json BackendImpl::SendFile(const WriteFunc& userFunc, std::string id, const uint64_t offset, const UploadInput& getUpload, bool oneshot)
+nlohmann::json BackendImpl::UploadFile(const std::string& parent, const std::string& name, const WriteSpanFunc& userSpan, bool oneshot, bool overwrite)
+{
+    MDBG_INFO("(parent:" << parent << " name:" << name << ")");
+
+    if (isReadOnly()) throw ReadOnlyException();
+
+    if (isMemory()) // debug only
+        return UploadFile(parent, name, RunnerInput_StreamIn::FromSpans(userSpan), oneshot, overwrite);
+
+    return SendFile(RunnerInput_StreamIn::FromSpans(userSpan), userSpan, "", 0, 
+        [&](const WriteFunc& writeFunc, const WriteSpanFunc& writeSpan)->RunnerInput_StreamIn
+    {
+        return {{{"files", "upload", 
+            {{"parent", parent}, {"overwrite", BOOLSTR(overwrite)}}}}, // plainParams
+            {{"file", {name, writeFunc, writeSpan}}}}; // StreamIn
+    }, oneshot);
+}
+
+/*****************************************************/
+nlohmann::json BackendImpl::SendFile(const WriteFunc& userFunc, const WriteSpanFunc& userSpan, 
+    std::string id, const uint64_t offset, const UploadInput& getUpload, bool oneshot)
 {
     nlohmann::json retval;    // last json response to return
     size_t byte { 0 };        // starting stream offset to read
@@ -744,26 +888,44 @@ nlohmann::json BackendImpl::SendFile(const WriteFunc& userFunc, std::string id,
         MDBG_INFO("... byte:" << byte << " maxSize:" << maxSize);
 
         size_t streamSize { 0 }; // total bytes read during stream
-        const WriteFunc& writeFunc { [&](const size_t soffset, char* const buf, const size_t buflen, size_t& sread)->bool
+
+        // returns the max size to read at the given offset, or 0 if at the end of the chunk
+        const auto getReadSize { [&](const size_t soffset, const size_t buflen)->size_t
         {
             if (maxSize && soffset >= maxSize)
             {
                 if (oneshot) throw WriteSizeException();
-                else { sread = 0; return false; } // end of chunk
+                else return 0; // end of chunk
             }
+            return maxSize ? std::min(buflen,maxSize) : buflen;
+        }};
+
+        const WriteFunc writeFunc { [&](const size_t soffset, char* const buf, const size_t buflen, size_t& sread)->bool
+        {
+            const size_t strSize { getReadSize(soffset, buflen) };
+            if (!strSize) { sread = 0; return false; } // end of chunk
 
-            const size_t strSize { maxSize ? std::min(buflen,maxSize) : buflen };
             streamCont = userFunc(soffset+byte, buf, strSize, sread);
             streamSize += sread; return streamCont;
         }};
 
+        const WriteSpanFunc writeSpan { !userSpan ? WriteSpanFunc() : 
+            [&](const size_t soffset, const size_t buflen, const char*& buf, size_t& sread)->bool
+        {
+            const size_t strSize { getReadSize(soffset, buflen) };
+            if (!strSize) { sread = 0; return false; } // end of chunk
+
+            streamCont = userSpan(soffset+byte, strSize, buf, sread);
+            streamSize += sread; return streamCont;
+        }};
+
         RunnerInput_StreamIn input;
         if (!byte && getUpload) // upload file
-            input = getUpload(writeFunc);
+            input = getUpload(writeFunc, writeSpan);
         else // write file
         {
             input = {{{"files", "writefile", {{"file", id}}, // plainParams
-                {{"offset", std::to_string(offset+byte)}}}}, {{"data", {"data", writeFunc}}}}; // dataParams, StreamIn
+                {{"offset", std::to_string(offset+byte)}}}}, {{"data", {"data", writeFunc, writeSpan}}}}; // dataParams, StreamIn
         }
         MDBG_BACKEND(input);
 
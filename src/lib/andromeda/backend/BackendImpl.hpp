@@ -4,8 +4,13 @@
 #include <atomic>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #include "nlohmann/json_fwd.hpp"
 
@@ -15,6 +20,7 @@
 #include "andromeda/common.hpp"
 #include "andromeda/ConfigOptions.hpp"
 #include "andromeda/Debug.hpp"
+#include "andromeda/filesystem/filedata/FetchPool.hpp"
 
 namespace Andromeda {
 
@@ -114,9 +120,43 @@ public:
     /** Returns the CachingAllocator to use for file data */
     Filesystem::Filedata::CachingAllocator& GetPageAllocator();
 
+    /** Returns the shared worker pool that runs asynchronous requests (see RunAsync) */
+    inline Filesystem::Filedata::FetchPool& GetFetchPool() { return *mFetchPool; }
+
+    /** The priority of an asynchronous request */
+    using AsyncPriority = Filesystem::Filedata::FetchPool::Priority;
+
+    /** 
+     * Runs func (which makes backend requests) asynchronously on the backend's request workers
+     * Requests are queued per-owner and owners are served round-robin. At most fetchThreads READAHEAD
+     * requests run at once, SYNC requests never wait for a busy pool (see FetchPool).
+     * Each running request takes its own runner from the RunnerPool for the round trip.
+     * @param owner the object the request belongs to (see PromoteAsync/CancelAsync)
+     * @param priority the priority of the request
+     * @param func the function to run
+     * @return future for the function's result or exception (get() throws std::future_error if cancelled)
+     */
+    template <typename Func>
+    auto RunAsync(const void* owner, AsyncPriority priority, Func func) -> std::future<std::invoke_result_t<Func>>
+    {
+        return mFetchPool->Run(owner, priority, std::move(func));
+    }
+
+    /** Queues func (which must not throw) to run asynchronously with no result (see RunAsync) */
+    void AddAsync(const void* owner, AsyncPriority priority, std::function<void ()> func);
+
+    /** Moves all of the owner's queued READAHEAD requests to SYNC, e.g. if a caller is now waiting on them */
+    void PromoteAsync(const void* owner);
+
+    /** Cancels all of the owner's queued requests and waits for its running requests to finish */
+    void CancelAsync(const void* owner);
+
     /** Returns true if doing memory only */
     [[nodiscard]] bool isMemory() const;
 
+    /** Returns the number of read requests that were served by joining an identical in-flight request */
+    [[nodiscard]] inline uint64_t GetCoalescedCount() const { return mCoalesced.load(); }
+
     /** Returns true if the backend is read-only */
     [[nodiscard]] bool isReadOnly() const;
 
@@ -203,6 +243,15 @@ public:
      */
     nlohmann::json GetFolder(const std::string& id = "");
 
+    /**
+     * Load folder metadata (with subitems) asynchronously (see RunAsync)
+     * @param owner the object the request belongs to
+     * @param id folder ID (or blank for default)
+     * @param priority the priority of the request
+     * @return future for the metadata or BackendException
+     */
+    std::future<nlohmann::json> GetFolderAsync(const void* owner, const std::string& id, AsyncPriority priority);
+
     /**
      * Load root folder metadata (no subitems)
      * @param id filesystem ID (or blank for default)
@@ -320,6 +369,19 @@ public:
      */
     void ReadFile(const std::string& id, uint64_t offset, size_t length, const ReadFunc& userFunc);
 
+    /**
+     * Streams data from a file asynchronously (see RunAsync)
+     * @param owner the object the request belongs to
+     * @param id file ID
+     * @param offset offset to read from
+     * @param length number of bytes to read
+     * @param userFunc data handler function, called on a worker thread
+     * @param priority the priority of the request
+     * @return future for completion or BackendException
+     */
+    std::future<void> ReadFileAsync(const void* owner, const std::string& id, uint64_t offset, size_t length, 
+        ReadFunc userFunc, AsyncPriority priority);
+
     /**
      * Writes data to a file
      * @param id file ID
@@ -337,6 +399,27 @@ public:
      * @throws BackendException for backend issues
      */
     nlohmann::json WriteFile(const std::string& id, uint64_t offset, const WriteFunc& userFunc);
+
+    /**
+     * Writes data to a file (streaming, in place - data is sent without an intermediate copy if possible)
+     * @param id file ID
+     * @param offset offset to write to
+     * @param userSpan function to provide data in place
+     * @throws BackendException for backend issues
+     */
+    nlohmann::json WriteFile(const std::string& id, uint64_t offset, const WriteSpanFunc& userSpan);
+
+    /**
+     * Writes data to a file asynchronously (in place, see RunAsync)
+     * @param owner the object the request belongs to
+     * @param id file ID
+     * @param offset offset to write to
+     * @param userSpan function to provide data in place, the data must stay valid until the future is ready
+     * @param priority the priority of the request
+     * @return future for the file metadata or BackendException
+     */
+    std::future<nlohmann::json> WriteFileAsync(const void* owner, const std::string& id, uint64_t offset, 
+        WriteSpanFunc userSpan, AsyncPriority priority);
     
     /**
      * Creates a new file with data
@@ -364,6 +447,19 @@ public:
     nlohmann::json UploadFile(const std::string& parent, const std::string& name, const WriteFunc& userFunc, 
         bool oneshot = false, bool overwrite = false);
 
+    /**
+     * Creates a new file with data (streaming, in place - data is sent without an intermediate copy if possible)
+     * @param parent parent folder ID
+     * @param name name of new file
+     * @param userSpan function to provide data in place
+     * @param oneshot if true, can't split into multiple writes
+     * @param overwrite whether to overwrite existing
+     * @throws WriteSizeException if oneshot is true and too big for one upload
+     * @throws BackendException for backend issues
+     */
+    nlohmann::json UploadFile(const std::string& parent, const std::string& name, const WriteSpanFunc& userSpan, 
+        bool oneshot = false, bool overwrite = false);
+
     /**
      * Truncates a file
      * @param id file ID
@@ -390,8 +486,28 @@ private:
 
     /** Finalizes input, runs the action, returns string */
     std::string RunAction_ReadStr(RunnerInput& input);
-    /** Finalizes input, runs the action, returns JSON */
+    /** 
+     * Finalizes input, runs the action, returns JSON
+     * Concurrent identical calls (same app/action/params) are coalesced into a single request,
+     * but never with a request that started before a write request finished (see InvalidateReads)
+     */
     nlohmann::json RunAction_Read(RunnerInput& input);
+
+    /** Returns a string that uniquely identifies the app/action/params of the given input */
+    static std::string GetInputKey(const RunnerInput& input);
+
+    /** Makes sure reads started from now on don't join any read that is in-flight */
+    void InvalidateReads();
+
+    /** Calls InvalidateReads() when it goes out of scope, use for any request that modifies the server */
+    class ReadsInvalidator { public:
+        explicit ReadsInvalidator(BackendImpl& backend) : mBackend(backend) { }
+        ~ReadsInvalidator() { mBackend.InvalidateReads(); }
+        DELETE_COPY(ReadsInvalidator)
+        DELETE_MOVE(ReadsInvalidator)
+    private:
+        BackendImpl& mBackend; };
+
     /** Finalizes input, runs the action, returns JSON */
     nlohmann::json RunAction_Write(RunnerInput& input);
     /** Finalizes input, runs the action, returns JSON */
@@ -401,19 +517,21 @@ private:
     /** Finalizes input, runs the action, returns JSON */
     void RunAction_StreamOut(RunnerInput_StreamOut& input);
 
-    /** Function that is given a WriteFunc and returns a RunnerInput_StreamIn for file upload */
-    using UploadInput = std::function<RunnerInput_StreamIn (const WriteFunc&)>;
+    /** Function that is given a WriteFunc (and optional WriteSpanFunc) and returns a RunnerInput_StreamIn for file upload */
+    using UploadInput = std::function<RunnerInput_StreamIn (const WriteFunc&, const WriteSpanFunc&)>;
 
     /**
      * Commonized file upload/write stream with max upload size checking/retries
      * @param userFunc user-provided data streaming function
+     * @param userSpan user-provided in-place data function (optional, same data as userFunc)
      * @param id ID of the file if already created (getUpload=nullptr)
      * @param offset offset of the file to write to if already created (getUpload=nullptr)
      * @param getUpload function to get an input for the initial upload if NOT already created (ignore id,offset)
      * @param oneshot if true, can't split into multiple writes
      * @throws WriteSizeException if oneshot is true and too big for one upload
      */
-    nlohmann::json SendFile(const WriteFunc& userFunc, std::string id, uint64_t offset, const UploadInput& getUpload, bool oneshot);
+    nlohmann::json SendFile(const WriteFunc& userFunc, const WriteSpanFunc& userSpan, 
+        std::string id, uint64_t offset, const UploadInput& getUpload, bool oneshot);
 
     /** True if the session in use should be deleted when done */
     bool mDeleteSession { false };
@@ -433,6 +551,17 @@ private:
 
     /** Allocator to use for all file pages (null if no cacheMgr) */
     std::unique_ptr<Filesystem::Filedata::CachingAllocator> mPageAllocator;
+    /** Worker pool for asynchronous requests (never null) */
+    std::unique_ptr<Filesystem::Filedata::FetchPool> mFetchPool;
+
+    /** Map of input key to the generation and result of each in-flight read request */
+    std::map<std::string, std::pair<uint64_t, std::shared_future<nlohmann::json>>> mReadsInFlight;
+    /** The generation of in-flight reads, incremented by InvalidateReads() */
+    uint64_t mReadsGen { 0 };
+    /** Mutex that protects mReadsInFlight and mReadsGen */
+    std::mutex mReadsMutex;
+    /** Number of read requests coalesced into another */
+    std::atomic<uint64_t> mCoalesced { 0 };
     
     mutable Debug mDebug;
     Config mConfig;
@@ -50,6 +50,9 @@ public:
     /** Returns whether retry is enabled or disabled */
     [[nodiscard]] inline bool GetCanRetry() const { return mCanRetry.load(); }
 
+    /** Returns true if the server reported being overloaded since the last call, and resets */
+    [[nodiscard]] inline bool TakeOverloaded() { return mOverloaded.exchange(false); }
+
     /**
      * Runs an API call and returns the result
      * @param input input params struct
@@ -93,10 +96,16 @@ public:
 
     /** Returns true if the backend requires sessions */
     [[nodiscard]] virtual bool RequiresSession() const = 0;
+
+protected:
+
+    /** Records that the server reported being overloaded (e.g. HTTP 503) */
+    inline void SetOverloaded() { mOverloaded.store(true); }
     
 private:
 
     std::atomic<bool> mCanRetry { false };
+    std::atomic<bool> mOverloaded { false };
 };
 
 } // namespace Backend
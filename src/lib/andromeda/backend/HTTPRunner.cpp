@@ -221,6 +221,9 @@ std::string HTTPRunner::HandleResponse(const httplib::Response& response, bool&
 {
     MDBG_INFO("() HTTP:" << response.status);
 
+    // let the runner pool back off
+    if (response.status == 503 || response.status == 429) SetOverloaded();
+
     const bool wantRetry { response.status == 500 || response.status == 503 }; // TODO remove me (don't retry on 500)
     respData.doRetry = (respData.canRetry && wantRetry);
     if (respData.doRetry) return ""; // early return
@@ -321,7 +324,17 @@ std::string HTTPRunner::RunAction_StreamIn(const RunnerInput_StreamIn& input, bo
             return true;
         }};
 
-        streamParams.push_back({it.first, sfunc, it.second.name, {}});
+        // callback that writes the provided data straight to the socket, skipping our buffer
+        const httplib::ContentProviderWithoutLength spanfunc { [&](size_t offset, httplib::DataSink& sink)->bool
+        {
+            const char* data { nullptr }; size_t read { 0 };
+            const bool hasMore { it.second.spanner(offset, mStreamBuffer.size(), data, read) };
+            if (read && !sink.write(data, read)) return false; // connection error
+            if (!hasMore) sink.done(); 
+            return true;
+        }};
+
+        streamParams.push_back({it.first, it.second.spanner ? spanfunc : sfunc, it.second.name, {}});
     }
     
     return DoRequestsFull([&](){ return mHttpClient->Post(url, headers, postParams, streamParams); }, isJson);
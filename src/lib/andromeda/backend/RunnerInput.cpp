@@ -34,6 +34,17 @@ WriteFunc RunnerInput_StreamIn::FromString(const std::string& data)
     };
 }
 
+/*****************************************************/
+WriteFunc RunnerInput_StreamIn::FromSpans(const WriteSpanFunc& func)
+{
+    return [&func](const size_t soffset, char* const buf, const size_t buflen, size_t& sread)->bool
+    {
+        const char* sdata { nullptr };
+        const bool hasMore { func(soffset, buflen, sdata, sread) };
+        std::copy(sdata, sdata+sread, buf); return hasMore;
+    };
+}
+
 /*****************************************************/
 WriteFunc RunnerInput_StreamIn::FromStream(std::istream& data)
 {
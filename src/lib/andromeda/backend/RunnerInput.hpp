@@ -64,6 +64,18 @@ struct RunnerInput_FilesIn : RunnerInput
  */
 using WriteFunc = std::function<bool (const size_t, char *const, const size_t, size_t&)>;
 
+/** 
+ * A function to provide input data in place, so it can be sent without copying
+ * The data must stay valid and unchanged until the request is complete
+ * MUST NOT call another backend action within the callback!
+ * @param offset offset of the input data to send (may reset!)
+ * @param buflen max number of bytes wanted
+ * @param buf output pointer to the data at offset
+ * @param written output number of bytes available at buf
+ * @return bool true if more data is remaining
+ */
+using WriteSpanFunc = std::function<bool (const size_t, const size_t, const char*&, size_t&)>;
+
 /** A RunnerInput with streams for files input */
 struct RunnerInput_StreamIn : RunnerInput_FilesIn
 {
@@ -72,6 +84,8 @@ struct RunnerInput_StreamIn : RunnerInput_FilesIn
     { 
         const std::string name;
         const WriteFunc streamer;
+        /** Optional in-place version of streamer, for runners that can send without copying */
+        const WriteSpanFunc spanner {};
     };
 
     /** Map of file streams to the input param name */
@@ -85,6 +99,8 @@ struct RunnerInput_StreamIn : RunnerInput_FilesIn
     * @throws StreamFailException (the returned func)
      */
     static WriteFunc FromStream(std::istream& data);
+    /** Returns a Func that copies from the in-place data func */
+    static WriteFunc FromSpans(const WriteSpanFunc& func);
     /** Reads through a stream to find its size (must be seekable) */
     static size_t StreamSize(const WriteFunc& func);
 };
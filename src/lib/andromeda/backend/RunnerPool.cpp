@@ -1,4 +1,6 @@
 
+#include <algorithm>
+
 #include "BaseRunner.hpp"
 #include "RunnerPool.hpp"
 #include "andromeda/ConfigOptions.hpp"
@@ -6,66 +8,175 @@
 namespace Andromeda {
 namespace Backend {
 
+namespace { // anonymous
+// latency above this many times the baseline means the server is saturated, stop growing
+constexpr size_t LATENCY_FACTOR { 2 };
+// weight of a new sample in the latency average (1/x)
+constexpr size_t LATENCY_AVG_WEIGHT { 8 };
+// rate at which the latency baseline drifts up to the average (1/x)
+constexpr size_t LATENCY_BASE_DRIFT { 64 };
+} // namespace
+
 /*****************************************************/
 RunnerPool::RunnerPool(BaseRunner& runner, const ConfigOptions& options) :
-    mRunnerPool(options.runnerPoolSize, nullptr),
-    mRunnerLocks(options.runnerPoolSize),
+    mFirstRunner(runner),
+    mMaxRunners(std::max(options.runnerPoolSize, static_cast<size_t>(1))),
+    mMinRunners(std::min(std::max(options.runnerPoolMin, static_cast<size_t>(1)), mMaxRunners)),
+    mIdleTime(options.runnerIdleTime),
+    mTargetRunners(mMinRunners),
+    mIdleRunners{{&runner, Clock::now()}},
     mDebug(__func__,this)
 {
-    MDBG_INFO("(poolSize:" << mRunnerPool.size() << ")");
-    mRunnerPool[0] = &runner; // first is never null
+    MDBG_INFO("(minSize:" << mMinRunners << " maxSize:" << mMaxRunners << ")");
 }
 
 /*****************************************************/
-const BaseRunner& RunnerPool::GetFirst() const { return *mRunnerPool[0]; }
+const BaseRunner& RunnerPool::GetFirst() const { return mFirstRunner; }
+
+/*****************************************************/
+size_t RunnerPool::GetSize() const
+{
+    const UniqueLock llock(mMutex);
+    return mNumRunners;
+}
+
+/*****************************************************/
+size_t RunnerPool::GetTargetSize() const
+{
+    const UniqueLock llock(mMutex);
+    return mTargetRunners;
+}
 
 /*****************************************************/
 RunnerPool::LockedRunner RunnerPool::GetRunner()
 {
+    RunnerList reaped; // close outside the lock
     UniqueLock llock(mMutex);
     MDBG_INFO("()");
 
-    size_t idx { 0 }; while (true)
+    ReapIdle(reaped, llock);
+
+    while (mIdleRunners.empty())
     {
-        UniqueLock rlock(mRunnerLocks[idx], std::try_to_lock);
-        if (!rlock) // not locked
+        if (mNumRunners < mTargetRunners) // create a new one
         {
-            if (idx+1 == mRunnerPool.size()) // all busy, wait
-            {
-                MDBG_INFO("... waiting!");
-                idx = 0; // start over
-                mCV.wait(llock); 
-            }
-            else ++idx; // try next
+            const size_t runnerNum { mNumRunners++ };
+            llock.unlock(); // don't block others while cloning
+            std::unique_ptr<BaseRunner> runner;
+            try { runner = GetFirst().Clone(); }
+            catch (...) { llock.lock(); --mNumRunners; throw; }
+            llock.lock();
+
+            MDBG_INFO("... new runner:" << runnerNum);
+            mRunnersOwned.emplace_back(std::move(runner));
+            return LockedRunner(*this, *mRunnersOwned.back());
         }
-        else // have lock
+
+        MDBG_INFO("... waiting!");
+        mWindowWaited = true; // demand exceeds the pool
+        mCV.wait(llock);
+    }
+
+    BaseRunner& runner { *mIdleRunners.back().runner };
+    mIdleRunners.pop_back();
+
+    MDBG_INFO("... return runner, idle:" << mIdleRunners.size());
+    return LockedRunner(*this, runner);
+}
+
+/*****************************************************/
+void RunnerPool::ReturnRunner(BaseRunner& runner, const Clock::duration& latency)
+{
+    RunnerList removed; // close outside the lock
+    bool notifyAll { false };
+    bool notifyOne { true };
+
+    { const UniqueLock llock(mMutex);
+        MDBG_INFO("()");
+
+        notifyAll = UpdateTarget(latency, runner.TakeOverloaded(), llock);
+
+        if (mNumRunners > mTargetRunners && RemoveRunner(runner, removed, llock))
         {
-            if (!mRunnerPool[idx]) // not initialized
-            {
-                MDBG_INFO("... new runner:" << idx);
-                mRunnersOwned.emplace_back(GetFirst().Clone());
-                mRunnerPool[idx] = mRunnersOwned.back().get();
-            }
-
-            MDBG_INFO("... return runner:" << idx);
-            return LockedRunner(*this, *mRunnerPool[idx], std::move(rlock));
+            MDBG_INFO("... shrinking, runners:" << mNumRunners);
+            notifyOne = false;
         }
+        else mIdleRunners.push_back({&runner, Clock::now()});
+
+        ReapIdle(removed, llock);
     }
+
+    if (notifyAll) mCV.notify_all(); // can create more
+    else if (notifyOne) mCV.notify_one();
 }
 
 /*****************************************************/
-void RunnerPool::SignalWaiters()
+bool RunnerPool::UpdateTarget(const Clock::duration& latency, const bool overloaded, const UniqueLock& llock)
 {
-    const UniqueLock llock(mMutex);
-    MDBG_INFO("()");
-    mCV.notify_one();
+    if (mLatencyAvg == Clock::duration::zero()) mLatencyAvg = latency;
+    else mLatencyAvg += (latency-mLatencyAvg)/LATENCY_AVG_WEIGHT;
+
+    if (mLatencyBase == Clock::duration::zero() || mLatencyAvg < mLatencyBase)
+        mLatencyBase = mLatencyAvg;
+    else mLatencyBase += (mLatencyAvg-mLatencyBase)/LATENCY_BASE_DRIFT;
+
+    if (overloaded) // multiplicative decrease
+    {
+        mTargetRunners = std::max(mTargetRunners/2, mMinRunners);
+        MDBG_INFO("... server overloaded, target:" << mTargetRunners);
+        mWindowCount = 0; mWindowWaited = false;
+        return false;
+    }
+
+    if (++mWindowCount < mTargetRunners) return false;
+
+    // additive increase, once per window
+    const bool increase { mWindowWaited && mTargetRunners < mMaxRunners &&
+        mLatencyAvg <= mLatencyBase*LATENCY_FACTOR };
+    mWindowCount = 0; mWindowWaited = false;
+
+    if (increase)
+    {
+        ++mTargetRunners;
+        MDBG_INFO("... increase target:" << mTargetRunners);
+    }
+    return increase;
+}
+
+/*****************************************************/
+bool RunnerPool::RemoveRunner(const BaseRunner& runner, RunnerList& removed, const UniqueLock& llock)
+{
+    const RunnerList::iterator it { std::find_if(mRunnersOwned.begin(), mRunnersOwned.end(),
+        [&](const std::unique_ptr<BaseRunner>& owned){ return owned.get() == &runner; }) };
+    if (it == mRunnersOwned.end()) return false; // first runner
+
+    removed.splice(removed.end(), mRunnersOwned, it);
+    --mNumRunners;
+    return true;
+}
+
+/*****************************************************/
+void RunnerPool::ReapIdle(RunnerList& removed, const UniqueLock& llock)
+{
+    const Clock::time_point now { Clock::now() };
+
+    // the least recently used are at the front
+    for (decltype(mIdleRunners)::iterator it { mIdleRunners.begin() };
+        it != mIdleRunners.end() && mNumRunners > mMinRunners && now-it->since > mIdleTime; )
+    {
+        if (RemoveRunner(*it->runner, removed, llock))
+        {
+            MDBG_INFO("... reaped idle runner, runners:" << mNumRunners);
+            it = mIdleRunners.erase(it);
+        }
+        else ++it;
+    }
 }
 
 /*****************************************************/
 RunnerPool::LockedRunner::~LockedRunner()
 {
-    mLock.unlock(); // BEFORE signal!
-    mPool.SignalWaiters();
+    mPool.ReturnRunner(mRunner, std::chrono::steady_clock::now()-mStart);
 }
 
 } // namespace Backend
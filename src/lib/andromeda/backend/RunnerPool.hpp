@@ -1,6 +1,7 @@
 #ifndef LIBA2_RUNNERPOOL_H_
 #define LIBA2_RUNNERPOOL_H_
 
+#include <chrono>
 #include <condition_variable>
 #include <list>
 #include <memory>
@@ -18,6 +19,10 @@ class BaseRunner;
 
 /** 
  * Manages a pool of concurrent backend runners 
+ * The pool size adapts between the configured min and max (AIMD) - it grows by one runner per window of
+ * requests in which callers had to wait for a runner, unless request latency has risen well above its
+ * baseline (the server is saturated), and is halved when the server reports being overloaded.
+ * Runners above the min that sit idle too long are closed.
  * THREAD SAFE (INTERNAL LOCKS)
  */
 class RunnerPool
@@ -26,12 +31,12 @@ public:
 
     using UniqueLock = std::unique_lock<std::mutex>;
 
-    /** Scoped wrapper for accessing a runner under a lock */
+    /** Scoped wrapper for exclusive use of a runner, returns it to the pool when destructed */
     class LockedRunner
     {
     public:
-        explicit LockedRunner(RunnerPool& pool, BaseRunner& runner, UniqueLock&& lock) : 
-            mPool(pool), mRunner(runner), mLock(std::move(lock)) { }
+        explicit LockedRunner(RunnerPool& pool, BaseRunner& runner) : 
+            mPool(pool), mRunner(runner), mStart(std::chrono::steady_clock::now()) { }
 
         ~LockedRunner();
         DELETE_COPY(LockedRunner)
@@ -42,12 +47,13 @@ public:
     private:
         RunnerPool& mPool;
         BaseRunner& mRunner;
-        UniqueLock mLock;
+        /** The time the runner was taken from the pool */
+        const std::chrono::steady_clock::time_point mStart;
     };
 
     /** 
      * Initialize the pool from a single runner that will be cloned as necessary
-     * @param options ConfigOptions containing the max pool size
+     * @param options ConfigOptions containing the min/max pool size and idle time
      */
     explicit RunnerPool(BaseRunner& runner, const Andromeda::ConfigOptions& options);
 
@@ -55,25 +61,83 @@ public:
     DELETE_COPY(RunnerPool)
     DELETE_MOVE(RunnerPool)
 
-    /** Returns a reference to a runner and accompanying lock */
+    /** 
+     * Returns an idle runner for exclusive use, the most recently used first (warm connection)
+     * Creates a new runner if none are idle and the pool is below its target size, else waits for one
+     */
     LockedRunner GetRunner();
 
     /** Returns a const reference to the first runner */
     [[nodiscard]] const BaseRunner& GetFirst() const;
 
+    /** Returns the number of runners that currently exist (including the first) */
+    [[nodiscard]] size_t GetSize() const;
+
+    /** Returns the current target (max) pool size */
+    [[nodiscard]] size_t GetTargetSize() const;
+
 private:
 
-    /** Signal waiting threads */
-    void SignalWaiters();
+    using Clock = std::chrono::steady_clock;
+    using RunnerList = std::list<std::unique_ptr<BaseRunner>>;
+
+    /** 
+     * Returns a runner to the idle list (or closes it if the pool is too big) and signals a waiting thread
+     * @param latency the time the runner was in use (the request latency)
+     */
+    void ReturnRunner(BaseRunner& runner, const Clock::duration& latency);
+
+    /** 
+     * Updates the target pool size for a completed request
+     * @param overloaded true if the server reported being overloaded
+     * @return true if the target size was increased
+     */
+    bool UpdateTarget(const Clock::duration& latency, bool overloaded, const UniqueLock& llock);
+
+    /** 
+     * Moves the given runner from mRunnersOwned to the given list, and decrements mNumRunners
+     * @return false if the runner is the first runner (not owned, can't be removed)
+     */
+    bool RemoveRunner(const BaseRunner& runner, RunnerList& removed, const UniqueLock& llock);
+
+    /** Removes runners that have been idle longer than the idle time while above the min size */
+    void ReapIdle(RunnerList& removed, const UniqueLock& llock);
+
+    /** A runner in the idle list and the time it became idle */
+    struct IdleRunner
+    {
+        BaseRunner* runner;
+        Clock::time_point since;
+    };
 
-    /** Array of possibly-null pointers to runners to use */
-    std::vector<BaseRunner*> mRunnerPool;
-    /** Array of locks for each runner */
-    std::vector<std::mutex> mRunnerLocks;
+    /** The first runner, all others are cloned from it */
+    BaseRunner& mFirstRunner;
+    /** The max number of runners in the pool */
+    const size_t mMaxRunners;
+    /** The min number of runners to keep around */
+    const size_t mMinRunners;
+    /** The time a runner above the min can be idle before it is closed */
+    const Clock::duration mIdleTime;
+    /** The current target size of the pool, between the min and max */
+    size_t mTargetRunners;
+    /** The number of runners created or being created (including the first) */
+    size_t mNumRunners { 1 };
+    /** Stack of runners not in use, the most recently used is at the back */
+    std::vector<IdleRunner> mIdleRunners;
     /** List of runners that we created and own */
-    std::list<std::unique_ptr<BaseRunner>> mRunnersOwned;
-    /** Mutex to protect the runner vectors */
-    std::mutex mMutex;
+    RunnerList mRunnersOwned;
+
+    /** The number of requests completed in the current adjustment window */
+    size_t mWindowCount { 0 };
+    /** True if any caller had to wait for a runner during the current window */
+    bool mWindowWaited { false };
+    /** Moving average of request latency */
+    Clock::duration mLatencyAvg { Clock::duration::zero() };
+    /** Baseline request latency (the lowest average, drifting up slowly) */
+    Clock::duration mLatencyBase { Clock::duration::zero() };
+
+    /** Mutex to protect the runner lists (only held briefly, not while running) */
+    mutable std::mutex mMutex;
     /** Condition variable to wait for a runner */
     std::condition_variable mCV;
 
@@ -18,16 +18,20 @@ std::mutex sCacheMutex; CacheMap sCache;
 /*****************************************************/
 const FSConfig& FSConfig::LoadByID(BackendImpl& backend, const std::string& id)
 {
-    const std::lock_guard<decltype(sCacheMutex)> llock(sCacheMutex);
+    std::unique_lock<decltype(sCacheMutex)> llock(sCacheMutex);
 
     CacheMap::iterator it { sCache.find(id) };
+    if (it != sCache.end()) return it->second;
 
-    if (it == sCache.end())
-    {
-        it = sCache.emplace(std::piecewise_construct, std::forward_as_tuple(id), 
-            std::forward_as_tuple(backend.GetFilesystem(id), backend.GetFSLimits(id))).first;
-    }
+    // don't hold the global lock for the requests - concurrent loads of the same ID are coalesced by the backend
+    llock.unlock();
+    const nlohmann::json data(backend.GetFilesystem(id));
+    const nlohmann::json lims(backend.GetFSLimits(id));
+    llock.lock();
 
+    // if another thread loaded it first, keep theirs (references are stable)
+    it = sCache.emplace(std::piecewise_construct, std::forward_as_tuple(id), 
+        std::forward_as_tuple(data, lims)).first;
     return it->second;
 }
 
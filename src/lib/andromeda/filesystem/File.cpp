@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 #include <utility>
 #include "nlohmann/json.hpp"
 
@@ -40,6 +41,7 @@ File::File(BackendImpl& backend, const nlohmann::json& data, Folder& parent) :
     mFsConfig = &FSConfig::LoadByID(mBackend, fsid);
 
     MDBG_INFO("... ID:" << mId << " name:" << mName);
+    mBackendModified = mModified;
 
     const size_t pageSize { CalcPageSize() };
     mPageBackend = std::make_unique<PageBackend>(*this, mId, fileSize, pageSize);
@@ -101,21 +103,44 @@ bool File::ExistsOnBackend(const SharedLock& thisLock) const
     return mPageBackend->ExistsOnBackend(thisLock);
 }
 
+/*****************************************************/
+bool File::isDirty(const SharedLock& thisLock) const
+{
+    return mLocalWrites == LocalWrites::DIRTY || !ExistsOnBackend(thisLock);
+}
+
 /*****************************************************/
 void File::Refresh(const nlohmann::json& data, const SharedLockW& thisLock)
 {
+    const Date localModified { mModified };
     Item::Refresh(data, thisLock);
 
+    // our own writes also change the backend's modified time
+    bool changed { mModified != mBackendModified && mLocalWrites == LocalWrites::NONE };
+    mBackendModified = mModified;
+
+    if (mLocalWrites == LocalWrites::DIRTY) // keep our own time until flushed
+        mModified = std::max(mModified, localModified);
+    else mLocalWrites = LocalWrites::NONE;
+
     try
     {
         if (mId.empty()) data.at("id").get_to(mId);
 
         uint64_t newSize = 0;
         data.at("size").get_to(newSize);
+        // not remote if the refresh is from our own create/upload
+        const bool remote { ExistsOnBackend(thisLock) };
+
         // TODO use server mtime once supported here to check for changing
         // will also need a mBackendTime in case of dirty writes
         if (newSize != mPageBackend->GetBackendSize(thisLock))
+        {
             mPageManager->RemoteChanged(newSize, thisLock);
+            changed = true;
+        }
+
+        if (remote && changed) NotifyRemoteChange();
     }
     catch (const nlohmann::json::exception& ex) {
         throw BackendImpl::JSONErrorException(ex.what()); }
@@ -174,7 +199,10 @@ void File::FlushCache(const SharedLockW& thisLock, bool nothrow)
 
     if (!nothrow) mPageManager->FlushPages(thisLock);
     else try { mPageManager->FlushPages(thisLock); } catch (const BackendException& e){
-        ITDBG_ERROR("... ignoring error: " << e.what()); }
+        ITDBG_ERROR("... ignoring error: " << e.what()); return; }
+
+    if (mLocalWrites == LocalWrites::DIRTY)
+        mLocalWrites = LocalWrites::FLUSHED;
 }
 
 /*****************************************************/
@@ -203,9 +231,12 @@ void File::ReadBytes(char* buffer, const uint64_t offset, const size_t length, c
 
     if (mBackend.GetOptions().cacheType == ConfigOptions::CacheType::NONE)
     {
-        const std::string data { mBackend.ReadFile(GetID(), offset, length) };
-
-        std::copy(data.cbegin(), data.cend(), buffer);
+        // receive straight into the caller's buffer (the backend checks the length)
+        mBackend.ReadFile(GetID(), offset, length, 
+            [&](const size_t roffset, const char* rbuf, const size_t rlength)->void
+        {
+            std::memcpy(buffer+roffset, rbuf, rlength);
+        });
     }
     else for (uint64_t byte { offset }; byte < offset+length; )
     {
@@ -223,6 +254,36 @@ void File::ReadBytes(char* buffer, const uint64_t offset, const size_t length, c
     }
 }
 
+/*****************************************************/
+size_t File::ReadBytesRefMax(const ReadRefFunc& func, const uint64_t offset, const size_t maxLength, const SharedLock& thisLock)
+{
+    ITDBG_INFO("(offset:" << offset << " maxLength:" << maxLength << ")");
+
+    const uint64_t fileSize { mPageManager->GetFileSize(thisLock) };
+    if (offset >= fileSize) return 0;
+    const size_t length { Filedata::min64st(fileSize-offset, maxLength) };
+
+    if (mBackend.GetOptions().cacheType == ConfigOptions::CacheType::NONE)
+    {
+        std::vector<char> buffer(length); // no pages to reference
+        ReadBytes(buffer.data(), offset, length, thisLock);
+        func(buffer.data(), length);
+    }
+    else for (uint64_t byte { offset }; byte < offset+length; )
+    {
+        const size_t pageSize { mPageManager->GetPageSize() };
+
+        const uint64_t index { byte / pageSize };
+        const size_t pOffset { static_cast<size_t>(byte - index*pageSize) }; // offset within the page
+        const size_t pLength { Filedata::min64st(length+offset-byte, pageSize-pOffset) }; // length within the page
+
+        func(mPageManager->ReadPageRef(index, pOffset, pLength, thisLock), pLength);
+        byte += pLength;
+    }
+
+    return length;
+}
+
 /*****************************************************/
 void File::WriteBytes(const char* buffer, uint64_t offset, size_t length, const SharedLockW& thisLock)
 {
@@ -243,6 +304,7 @@ void File::WriteBytes(const char* buffer, uint64_t offset, size_t length, const
         const std::string data(buffer, length);
         mBackend.WriteFile(GetID(), offset, data);
         mPageManager->RemoteChanged(std::max(fileSize, offset+length), thisLock);
+        SetModifiedNow(thisLock);
         return; // early return
     }
     
@@ -289,6 +351,43 @@ void File::WriteBytes(const char* buffer, uint64_t offset, size_t length, const
         mPageManager->WritePage(buffer, index, pOffset, pLength, thisLock);
         buffer += pLength; byte += pLength;
     }
+
+    SetModifiedNow(thisLock);
+}
+
+/*****************************************************/
+size_t File::WriteBytes(const WriteRefFunc& func, const uint64_t offset, const size_t length, const SharedLockW& thisLock)
+{
+    ITDBG_INFO("(offset:" << offset << " length:" << length << ")");
+
+    // other write modes may need to write to the backend directly, see WriteBytes(buffer)
+    if (mBackend.GetOptions().cacheType == ConfigOptions::CacheType::NONE ||
+        GetWriteMode() < FSConfig::WriteMode::RANDOM)
+    {
+        std::vector<char> buffer(length);
+        const size_t filled { std::min(func(buffer.data(), length), length) };
+        if (filled) WriteBytes(buffer.data(), offset, filled, thisLock);
+        return filled; // early return
+    }
+
+    if (isReadOnlyFS()) throw ReadOnlyFSException();
+
+    uint64_t byte { offset };
+    while (byte < offset+length)
+    {
+        const size_t pageSize { mPageManager->GetPageSize() };
+
+        const uint64_t index { byte / pageSize };
+        const size_t pOffset { static_cast<size_t>(byte - index*pageSize) }; // offset within the page
+        const size_t pLength { Filedata::min64st(length+offset-byte, pageSize-pOffset) }; // length within the page
+
+        const size_t filled { mPageManager->WritePage(func, index, pOffset, pLength, thisLock) };
+        byte += filled; if (filled < pLength) break; // data ran out
+    }
+
+    const size_t written { static_cast<size_t>(byte-offset) };
+    if (written) SetModifiedNow(thisLock);
+    return written;
 }
 
 /*****************************************************/
@@ -347,6 +446,22 @@ void File::Truncate(const uint64_t newSize, const SharedLockW& thisLock)
             && newSize != 0)) throw WriteTypeException();
 
     mPageManager->Truncate(newSize, thisLock);
+    SetModifiedNow(thisLock);
+}
+
+/*****************************************************/
+void File::SetModified(const Date modified, const SharedLockW& thisLock)
+{
+    ITDBG_INFO("(modified:" << modified << ")");
+
+    mModified = modified;
+}
+
+/*****************************************************/
+void File::SetModifiedNow(const SharedLockW& thisLock)
+{
+    mModified = GetNowDate();
+    mLocalWrites = LocalWrites::DIRTY;
 }
 
 } // namespace Filesystem
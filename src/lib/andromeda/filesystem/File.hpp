@@ -74,7 +74,7 @@ public:
     /** Function to create the file on the backend and return its JSON */
     using CreateFunc = std::function<nlohmann::json (const std::string&)>;
     /** Function to upload the file on the backend and return its JSON */
-    using UploadFunc = std::function<nlohmann::json (const std::string&, const Andromeda::Backend::WriteFunc&, bool)>;
+    using UploadFunc = std::function<nlohmann::json (const std::string&, const Andromeda::Backend::WriteSpanFunc&, bool)>;
 
     /**
      * @brief Construct a new file in memory only to be created on the backend when flushed
@@ -92,6 +92,15 @@ public:
     /** Returns true iff the file exists on the backend (false if waiting for flush) */
     virtual bool ExistsOnBackend(const SharedLock& thisLock) const;
 
+    /** 
+     * Returns true if the file was changed locally since the last FlushCache (through any handle)
+     * or doesn't exist on the backend yet, i.e. FlushCache may have something to do
+     */
+    [[nodiscard]] bool isDirty(const SharedLock& thisLock) const;
+
+    /** Returns the modified time last returned by the backend (GetModified may be our own local time) */
+    [[nodiscard]] inline Date GetBackendModified(const SharedLock& thisLock) const { return mBackendModified; }
+
     /**
      * Read data from the file
      * @param buffer pointer to buffer to fill
@@ -115,6 +124,21 @@ public:
      */
     virtual void ReadBytes(char* buffer, uint64_t offset, size_t length, const SharedLock& thisLock) final;
 
+    /** Function given the file's data by reference, in order */
+    using ReadRefFunc = std::function<void (const char* data, size_t length)>;
+
+    /**
+     * Read data from the file by reference to its pages, without copying
+     * The data stays valid while thisLock is held, but is copied if not using the page cache
+     * @param func function to call with each span of data
+     * @param offset byte offset in file to read
+     * @param maxLength max number of bytes to read
+     * @return the number of bytes read (may be < maxLength if EOF)
+     * @throws BackendException for backend issues
+     * @throws CacheManager::MemoryException
+     */
+    virtual size_t ReadBytesRefMax(const ReadRefFunc& func, uint64_t offset, size_t maxLength, const SharedLock& thisLock) final;
+
     /**
      * Writes data to a file
      * @param buffer buffer with data to write
@@ -127,6 +151,27 @@ public:
      */
     virtual void WriteBytes(const char* buffer, uint64_t offset, size_t length, const SharedLockW& thisLock) final;
 
+    /** 
+     * Function that fills in the given buffer with the next length bytes of data to write, in order
+     * Returns the number of bytes filled in, which is less than length only if the data ran out
+     */
+    using WriteRefFunc = std::function<size_t (char* buffer, size_t length)>;
+
+    /**
+     * Write data to the file by filling in its pages directly, without copying
+     * Only random-write files with the page cache are written in place, others use a temporary buffer
+     * Only the bytes func fills in are written, if it returns short then writing stops there
+     * @param func function to fill in each span of data
+     * @param offset byte offset in file to write
+     * @param length number of bytes to write
+     * @return the number of bytes written
+     * @throws WriteTypeException if ExistsOnBackend() and writing UPLOAD only files or non-appending write to APPEND only files 
+     * @throws ReadOnlyFSException if read-only item/filesystem
+     * @throws BackendException for backend issues
+     * @throws CacheManager::MemoryException
+     */
+    virtual size_t WriteBytes(const WriteRefFunc& func, uint64_t offset, size_t length, const SharedLockW& thisLock) final;
+
     /** 
      * Set the file size to the given value
      * @throws WriteTypeException if write mode is UPLOAD, or write mode is APPEND and newSize != 0 
@@ -136,6 +181,12 @@ public:
      */
     virtual void Truncate(uint64_t newSize, const SharedLockW& thisLock) final;
 
+    /** 
+     * Sets the modified time locally, e.g. as given by the kernel's writeback cache
+     * The backend sets its own modified time when written, so this lasts until the next refresh
+     */
+    virtual void SetModified(Date modified, const SharedLockW& thisLock) final;
+
     void FlushCache(const SharedLockW& thisLock, bool nothrow = false) override;
 
 protected:
@@ -164,6 +215,24 @@ private:
     /** Calls WriteBytes() with zeroes until the file size equals offset */
     void FillWriteHole(uint64_t offset, const SharedLockW& thisLock);
 
+    /** Sets the modified time to now after a local write */
+    void SetModifiedNow(const SharedLockW& thisLock);
+
+    /** The modified time last returned by the backend */
+    Date mBackendModified { 0 };
+
+    /** The state of local writes not yet seen by a refresh */
+    enum class LocalWrites : uint8_t
+    {
+        /** No local writes since the last refresh */
+        NONE,
+        /** Written locally, maybe not yet flushed to the backend */
+        DIRTY,
+        /** Written locally and flushed, the next refresh has our own changes */
+        FLUSHED
+    };
+    LocalWrites mLocalWrites { LocalWrites::NONE };
+
     std::unique_ptr<Filedata::PageManager> mPageManager;
     std::unique_ptr<Filedata::PageBackend> mPageBackend;
 
@@ -1,17 +1,168 @@
 
+#include <atomic>
+#include <list>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 #include "nlohmann/json.hpp"
 
 #include "Folder.hpp"
 #include "andromeda/ConfigOptions.hpp"
+#include "andromeda/SharedMutex.hpp"
 #include "andromeda/StringUtil.hpp"
 #include "andromeda/backend/BackendImpl.hpp"
 using Andromeda::Backend::BackendImpl;
+#include "andromeda/backend/BackendException.hpp"
+using Andromeda::Backend::BackendException;
+#include "andromeda/filesystem/filedata/FetchPool.hpp"
+using Andromeda::Filesystem::Filedata::FetchPool;
 
 namespace Andromeda {
 namespace Filesystem {
 
+namespace { // anonymous
+/**
+ * Cache of root folder + path -> item for GetItemByPath, with a reverse index from each folder and
+ * name on a path to its entries so invalidating costs only the entries removed.  Paths through an item
+ * are removed whenever it is removed, renamed or moved (or a folder is destroyed) so a cached item always
+ * exists while sPathMutex is held.  Bounded with second-chance (clock) LRU eviction, as lookups only
+ * have a read lock.  NOT THREAD SAFE (use sPathMutex)
+ */
+class PathCache
+{
+public:
+    /** The folder each part of a path was found in, starting with the root */
+    using Parents = std::vector<const Folder*>;
+
+    /** Returns the item cached for root/path no earlier than minTime, or nullptr (needs sPathMutex read) */
+    Item* Find(const Folder& root, const std::string& path, const std::chrono::steady_clock::time_point& minTime) const
+    {
+        const decltype(mPaths)::const_iterator rootIt { mPaths.find(&root) };
+        if (rootIt == mPaths.end()) return nullptr;
+        const PathMap::const_iterator it { rootIt->second.find(path) };
+        if (it == rootIt->second.end() || it->second->time < minTime) return nullptr;
+
+        it->second->used.store(true, std::memory_order_relaxed);
+        return it->second->item;
+    }
+
+    /** 
+     * Caches the item for root/path, evicting the least recently used paths if full (needs sPathMutex write)
+     * @param parents the folder each part of the path was found in
+     * @param parts the path exploded by '/', the same size as parents
+     */
+    void Insert(const Folder& root, const std::string& path, Item& item, 
+        const std::chrono::steady_clock::time_point& time, const Parents& parents, const StringUtil::StringList& parts)
+    {
+        PathMap& paths { mPaths[&root] };
+        const PathMap::iterator oldIt { paths.find(path) };
+        if (oldIt != paths.end()) Remove(oldIt->second);
+
+        while (mEntries.size() >= PATH_CACHE_MAX)
+        {
+            if (mEntries.front().used.exchange(false, std::memory_order_relaxed))
+                mEntries.splice(mEntries.end(), mEntries, mEntries.begin()); // second chance
+            else Remove(mEntries.begin());
+        }
+
+        Entry& entry { mEntries.emplace_back(&root, path, &item, time) };
+        paths.emplace(path, std::prev(mEntries.end()));
+        for (size_t part { 0 }; part < parents.size(); ++part)
+        {
+            entry.parts.emplace_back(parents[part], parts[part]);
+            mIndex[parents[part]][parts[part]].insert(&entry);
+        }
+    }
+
+    /**
+     * Removes cached paths that go through the given folder's item (needs sPathMutex write)
+     * @param name the name of the item in folder, or nullptr to remove all paths through folder itself
+     */
+    void Invalidate(const Folder& folder, const std::string* name)
+    {
+        const decltype(mIndex)::iterator folderIt { mIndex.find(&folder) };
+        if (folderIt == mIndex.end()) return;
+
+        std::vector<const Entry*> remove;
+        for (const NameIndex::value_type& names : folderIt->second)
+            if (name == nullptr || names.first == *name)
+                remove.insert(remove.end(), names.second.begin(), names.second.end());
+
+        for (const Entry* entry : remove)
+            Remove(mPaths.at(entry->root).at(entry->path));
+    }
+
+    /** Returns the number of cached paths */
+    [[nodiscard]] size_t size() const { return mEntries.size(); }
+
+private:
+
+    // the max number of cached paths
+    static constexpr size_t PATH_CACHE_MAX { 65536 };
+
+    struct Entry
+    {
+        Entry(const Folder* rootIn, std::string pathIn, Item* itemIn, const std::chrono::steady_clock::time_point& timeIn) :
+            root(rootIn), path(std::move(pathIn)), item(itemIn), time(timeIn) { }
+
+        const Folder* root;
+        std::string path;
+        Item* item;
+        /** When the path was looked up */
+        std::chrono::steady_clock::time_point time;
+        /** The folder each part of the path was found in and the part's name (see mIndex) */
+        std::vector<std::pair<const Folder*, std::string>> parts;
+        /** True if found since last considered for eviction (set with only a read lock) */
+        mutable std::atomic<bool> used { false };
+    };
+    using EntryList = std::list<Entry>;
+    using PathMap = std::unordered_map<std::string, EntryList::iterator>;
+    using NameIndex = std::unordered_map<std::string, std::unordered_set<const Entry*>>;
+
+    /** Removes the given entry and its index references */
+    void Remove(const EntryList::iterator& it)
+    {
+        for (const std::pair<const Folder*, std::string>& part : it->parts)
+        {
+            const decltype(mIndex)::iterator folderIt { mIndex.find(part.first) };
+            const NameIndex::iterator nameIt { folderIt->second.find(part.second) };
+            nameIt->second.erase(&*it);
+            if (nameIt->second.empty()) folderIt->second.erase(nameIt);
+            if (folderIt->second.empty()) mIndex.erase(folderIt);
+        }
+
+        const decltype(mPaths)::iterator rootIt { mPaths.find(it->root) };
+        rootIt->second.erase(it->path);
+        if (rootIt->second.empty()) mPaths.erase(rootIt);
+        mEntries.erase(it);
+    }
+
+    /** All entries in eviction order */
+    EntryList mEntries;
+    /** Map of root folder -> path -> entry */
+    std::unordered_map<const Folder*, PathMap> mPaths;
+    /** Map of each folder on a path -> name of the part in it -> entries */
+    std::unordered_map<const Folder*, NameIndex> mIndex;
+};
+
+SharedMutex sPathMutex; PathCache sPathCache;
+// incremented on every invalidate, a lookup that started before one must not insert its result
+uint64_t sPathGeneration { 0 };
+
+/** 
+ * Removes cached paths that go through the given folder's item, call BEFORE removing it
+ * @param name the name of the item in folder, or nullptr to remove all paths through folder itself
+ */
+void InvalidatePaths(const Folder& folder, const std::string* name)
+{
+    const SharedLockW llock(sPathMutex);
+    ++sPathGeneration;
+    sPathCache.Invalidate(folder, name);
+}
+} // namespace
+
 /*****************************************************/
 Folder::Folder(BackendImpl& backend) : 
     Item(backend), mDebug(__func__,this)
@@ -26,6 +177,13 @@ Folder::Folder(BackendImpl& backend, const nlohmann::json& data) :
     MDBG_INFO("()");
 }
 
+/*****************************************************/
+Folder::~Folder()
+{
+    mBackend.CancelAsync(this); // background refresh
+    InvalidatePaths(*this, nullptr); // may be a root
+}
+
 /*****************************************************/
 Item::DeleteLock Folder::GetDeleteLock()
 {
@@ -54,7 +212,21 @@ Item::ScopeLocked Folder::GetItemByPath(std::string path)
         return Item::TryLockScope();
     }
 
+    const std::chrono::steady_clock::time_point now { std::chrono::steady_clock::now() };
+    uint64_t generation { 0 };
+    { // lock scope - cached items can't be removed while we have the lock
+        const SharedLockR llock(sPathMutex);
+        generation = sPathGeneration;
+        Item* const cached { sPathCache.Find(*this, path, now - mBackend.GetOptions().refreshTime) };
+        if (cached != nullptr)
+        {
+            Item::ScopeLocked item { cached->TryLockScope() };
+            if (item) { ITDBG_INFO("... cached!"); return item; }
+        }
+    }
+
     StringUtil::StringList parts { StringUtil::explode(path,"/") };
+    PathCache::Parents parents; // for the path cache
 
     // iteratively find the correct parent/subitem
     Folder::ScopeLocked parent { TryLockScope() };
@@ -64,20 +236,29 @@ Item::ScopeLocked Folder::GetItemByPath(std::string path)
     for (StringUtil::StringList::iterator pIt { parts.begin() }; 
         pIt != parts.end(); ++pIt )
     {
-        const SharedLockW parentLock { parent->GetWriteLock() };
-        parent->LoadItems(parentLock); // populate items
-        const ItemMap& items { parent->mItemMap };
-
-        const ItemMap::const_iterator it { items.find(*pIt) };
-        if (it == items.end()) {
-            ITDBG_INFO("... not in map: " << *pIt); 
-            throw NotFoundException(); }
-
-        Item::ScopeLocked item { it->second->TryLockScope() };
-        if (!item) { ITDBG_INFO("... item deleted: " << *pIt); 
-            throw NotFoundException(); }
+        Item::ScopeLocked item;
+        parents.push_back(&*parent);
+        { // lock scope - only need a write lock if loading
+            SharedLockR parentLockR { parent->GetReadLock() };
+            if (parent->isLoaded(parentLockR))
+                item = parent->FindItem(*pIt, parentLockR);
+            else
+            {
+                parentLockR.unlock();
+                const SharedLockW parentLock { parent->GetWriteLock() };
+                parent->LoadItems(parentLock); // populate items
+                item = parent->FindItem(*pIt, parentLock);
+            }
 
-        if (std::next(pIt) == parts.end()) return item; // last part of path
+            if (std::next(pIt) == parts.end()) // last part of path
+            {
+                // an item (or ancestor) being removed/renamed was invalidated after we started
+                const SharedLockW llock(sPathMutex);
+                if (generation == sPathGeneration)
+                    sPathCache.Insert(*this, path, *item, now, parents, parts);
+                return item;
+            }
+        }
 
         if (item->GetType() != Type::FOLDER) throw NotFolderException();
         parent = ScopeLocked::FromBase(std::move(item));
@@ -129,6 +310,31 @@ size_t Folder::CountItems(const SharedLockW& thisLock)
     return mItemMap.size();
 }
 
+/*****************************************************/
+bool Folder::isLoaded(const SharedLockR& thisLock) const
+{
+    if (!mHaveItems) return false;
+
+    if (mRefreshFuture.valid() && // background refresh to apply
+        mRefreshFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) return false;
+
+    return mBackend.isMemory() || (std::chrono::steady_clock::now() - mRefreshed) <= mBackend.GetOptions().refreshTime;
+}
+
+/*****************************************************/
+Item::ScopeLocked Folder::FindItem(const std::string& name, const SharedLock& thisLock)
+{
+    const ItemMap::const_iterator it { mItemMap.find(name) };
+    if (it == mItemMap.end()) {
+        ITDBG_INFO("... not in map: " << name); 
+        throw NotFoundException(); }
+
+    Item::ScopeLocked item { it->second->TryLockScope() };
+    if (!item) { ITDBG_INFO("... item deleted: " << name); 
+        throw NotFoundException(); }
+    return item;
+}
+
 /*****************************************************/
 Folder::ItemLockMap Folder::LockItems(const SharedLockW& thisLock)
 {
@@ -159,23 +365,76 @@ void Folder::LoadItems(const SharedLockW& thisLock, bool canRefresh)
 {
     ITDBG_INFO("()");
 
-    const bool expired { (std::chrono::steady_clock::now() - mRefreshed)
-        > mBackend.GetOptions().refreshTime };
+    // apply a finished background refresh
+    if (canRefresh && mRefreshFuture.valid() && 
+        mRefreshFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        ApplyRefresh(thisLock);
+
+    const ConfigOptions& options { mBackend.GetOptions() };
+    const std::chrono::steady_clock::time_point now { std::chrono::steady_clock::now() };
+    const bool expired { (now - mRefreshed) > options.refreshTime };
 
     if (!mHaveItems || (canRefresh && expired && !mBackend.isMemory()))
     {
-        ITDBG_INFO("... expired!");
-
-        // item scope locks not needed since mItemMap is locked
-        ItemLockMap lockMap { LockItems(thisLock) };
-        SubLoadItems(lockMap, thisLock); // populate mItemMap
-        mRefreshed = std::chrono::steady_clock::now();
-        mHaveItems = true;
+        if (mHaveItems && (now - mRefreshed) <= options.refreshTime + options.refreshStaleTime)
+        {
+            if (!mRefreshFuture.valid())
+            {
+                ITDBG_INFO("... expired, refresh in background");
+                mRefreshStart = now;
+                mRefreshChangeCount = mChangeCount;
+                mRefreshFuture = mBackend.RunAsync(this, FetchPool::Priority::READAHEAD, 
+                    [fetch=GetFetchFunc(thisLock)](){ return std::make_shared<nlohmann::json>(fetch()); });
+            }
+        }
+        else if (!mRefreshFuture.valid() || !ApplyRefresh(thisLock))
+        {
+            ITDBG_INFO("... expired!");
+            ApplyItems(GetFetchFunc(thisLock)(), now, thisLock);
+        }
     }
 
     ITDBG_INFO("... return!");
 }
 
+/*****************************************************/
+void Folder::ApplyItems(const nlohmann::json& data, const std::chrono::steady_clock::time_point& refreshed, const SharedLockW& thisLock)
+{
+    // item scope locks not needed since mItemMap is locked
+    ItemLockMap lockMap { LockItems(thisLock) };
+    SubLoadItems(data, lockMap, thisLock); // populate mItemMap
+    mRefreshed = refreshed;
+    mHaveItems = true;
+}
+
+/*****************************************************/
+bool Folder::ApplyRefresh(const SharedLockW& thisLock)
+{
+    std::future<std::shared_ptr<nlohmann::json>> future { std::move(mRefreshFuture) };
+    std::shared_ptr<nlohmann::json> data;
+
+    // don't wait behind read-ahead if the refresh hasn't started yet
+    mBackend.PromoteAsync(this);
+
+    try { data = future.get(); } // may wait
+    catch (const BackendException& ex)
+    {
+        ITDBG_ERROR("... refresh failed: " << ex.what());
+        return false; // keep the stale items
+    }
+
+    // the items are older than any changes made since the refresh started
+    if (mChangeCount != mRefreshChangeCount)
+    {
+        ITDBG_INFO("... changed locally, discard refresh");
+        return false;
+    }
+
+    ITDBG_INFO("... apply background refresh");
+    ApplyItems(*data, mRefreshStart, thisLock);
+    return true;
+}
+
 /*****************************************************/
 void Folder::SyncContents(const NewItemMap& newItems, ItemLockMap& itemsLocks, const SharedLockW& thisLock)
 {
@@ -194,6 +453,7 @@ void Folder::SyncContents(const NewItemMap& newItems, ItemLockMap& itemsLocks, c
         {
             const NewItemFunc newFunc(newIt.second.second);
             mItemMap[name] = newFunc(data);
+            if (mHaveItems) NotifyRemoteChange(name); // not the initial load
         }
         else existIt->second->Refresh(data, 
             itemsLocks.at(existIt->first)); // update existing
@@ -210,7 +470,9 @@ void Folder::SyncContents(const NewItemMap& newItems, ItemLockMap& itemsLocks, c
                 dynamic_cast<const File&>(*oldIt->second).ExistsOnBackend(itLock))
             {
                 ITDBG_INFO("... remote deleted: " << oldIt->second->GetName(itLock));
+                NotifyRemoteChange(oldIt->first);
                 itemsLocks.erase(oldIt->first); // unlock, scope locks come first
+                InvalidatePaths(*this, &oldIt->first);
 
                 oldIt->second->GetDeleteLock();
                 // lock to clear out existing users, then unlock before erasing
@@ -235,6 +497,7 @@ void Folder::CreateFile(const std::string& name, const SharedLockW& thisLock)
         throw DuplicateItemException();
 
     SubCreateFile(name, thisLock);
+    CountChange(thisLock);
 }
 
 /*****************************************************/
@@ -249,6 +512,7 @@ void Folder::CreateFolder(const std::string& name, const SharedLockW& thisLock)
         throw DuplicateItemException();
 
     SubCreateFolder(name, thisLock);
+    CountChange(thisLock);
 }
 
 /*****************************************************/
@@ -261,6 +525,7 @@ void Folder::DeleteItem(const std::string& name, const SharedLockW& thisLock)
     LoadItems(thisLock); // populate items
     const ItemMap::const_iterator it { mItemMap.find(name) };
     if (it == mItemMap.end()) throw NotFoundException();
+    InvalidatePaths(*this, &name);
 
     { // lock scope (must unlock before erasing)
       // we have our W lock so the item cannot get re-acquired
@@ -268,6 +533,7 @@ void Folder::DeleteItem(const std::string& name, const SharedLockW& thisLock)
         it->second->SubDelete(deleteLock);
     }
     mItemMap.erase(it);
+    CountChange(thisLock);
 }
 
 /*****************************************************/
@@ -286,6 +552,8 @@ void Folder::RenameItem(const std::string& oldName, const std::string& newName,
     const ItemMap::const_iterator dup { mItemMap.find(newName) };
     if ((!overwrite && dup != mItemMap.end()) || newName.empty())
         throw DuplicateItemException();
+    InvalidatePaths(*this, &oldName);
+    if (dup != mItemMap.end()) InvalidatePaths(*this, &newName);
 
     const SharedLockW subLock { it->second->GetWriteLock() };
     it->second->SubRename(newName, subLock, overwrite);
@@ -295,6 +563,7 @@ void Folder::RenameItem(const std::string& oldName, const std::string& newName,
 
     ItemMap::node_type node(mItemMap.extract(it));
     node.key() = newName; mItemMap.insert(std::move(node));
+    CountChange(thisLock);
 }
 
 /*****************************************************/
@@ -320,6 +589,8 @@ void Folder::MoveItem(const std::string& name, Folder& newParent, const SharedLo
     const ItemMap::const_iterator dup { newParent.mItemMap.find(name) };
     if (!overwrite && dup != newParent.mItemMap.end())
         throw DuplicateItemException();
+    InvalidatePaths(*this, &name);
+    if (dup != newParent.mItemMap.end()) InvalidatePaths(newParent, &name);
 
     const SharedLockW subLock { it->second->GetWriteLock() };
     it->second->SubMove(newParent.GetID(), subLock, overwrite);
@@ -328,6 +599,8 @@ void Folder::MoveItem(const std::string& name, Folder& newParent, const SharedLo
         newParent.mItemMap.erase(dup);
 
     newParent.mItemMap.insert(mItemMap.extract(it));
+    CountChange(itemLocks.first);
+    newParent.CountChange(itemLocks.second);
 }
 
 /*****************************************************/
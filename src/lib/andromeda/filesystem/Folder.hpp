@@ -2,7 +2,9 @@
 #define LIBA2_FOLDER_H_
 
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -25,7 +27,7 @@ class Folder : public Item
 {
 public:
 
-    ~Folder() override = default;
+    ~Folder() override;
 
     /** Base Exception for all folder issues */
     class Exception : public Item::Exception { public:
@@ -63,7 +65,8 @@ public:
 
     /** 
      * Load the item with the given relative path, returning it with a pre-checked ScopeLock 
-     * Will get a write lock on all parent folders - DO NOT ACQUIRE FIRST!
+     * Recently found paths are cached (until refreshTime or an item on the path is removed/renamed) and need no folder locks.
+     * Otherwise will get a read lock (or write lock if loading) on all parent folders - DO NOT ACQUIRE FIRST!
      * @throws NotFoundException if the path is not found
      * @throws BackendException on backend errors
      */
@@ -171,7 +174,9 @@ protected:
 
     /** 
      * Makes sure mItemMap is populated and refreshed
-     * @param canRefresh if true, allow refreshing
+     * If the items are expired but not older than the stale limit, the existing items are used 
+     * while they are refreshed in the background, and the result is applied on a later call
+     * @param canRefresh if true, allow refreshing (and applying a background refresh)
      * @throws BackendException on backend errors
      */
     virtual void LoadItems(const SharedLockW& thisLock, bool canRefresh = true);
@@ -179,11 +184,22 @@ protected:
     /** Map consisting of an item name -> write lock for the item */
     using ItemLockMap = std::map<std::string, SharedLockW>;
 
+    /** Function that reads and returns the folder's items JSON from the backend */
+    using FetchFunc = std::function<nlohmann::json ()>;
+
+    /** 
+     * Returns a function that reads the items from the backend
+     * The function may run in the background with no locks held, so it MUST NOT reference this folder
+     * @throws BackendException on backend errors
+     */
+    virtual FetchFunc GetFetchFunc(const SharedLockW& thisLock) = 0;
+
     /** 
-     * Populates the item list with items from the backend
+     * Populates the item list with the given items JSON from GetFetchFunc()
+     * @throws BackendImpl::JSONErrorException on JSON errors
      * @throws BackendException on backend errors
      */
-    virtual void SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock) = 0;
+    virtual void SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock) = 0;
 
     /** Function that returns a new Item given its JSON data */
     using NewItemFunc = std::function<std::unique_ptr<Item> (const nlohmann::json&)>;
@@ -226,11 +242,41 @@ protected:
     /** time point when contents were loaded */
     std::chrono::steady_clock::time_point mRefreshed;
 
+    /** Increments the local change count, call when mItemMap is modified other than by a refresh */
+    inline void CountChange(const SharedLockW& thisLock) { ++mChangeCount; }
+
 private:
     
     /** Returns a map with write locks for all items, deadlock-safe */
     ItemLockMap LockItems(const SharedLockW& thisLock);
 
+    /** Returns true if mItemMap is loaded and LoadItems() has nothing to do */
+    bool isLoaded(const SharedLockR& thisLock) const;
+
+    /** 
+     * Returns the scope-locked child item with the given name
+     * @throws NotFoundException if not found or being deleted
+     */
+    Item::ScopeLocked FindItem(const std::string& name, const SharedLock& thisLock);
+
+    /** Locks all items and populates the item list with the given JSON, setting mRefreshed */
+    void ApplyItems(const nlohmann::json& data, const std::chrono::steady_clock::time_point& refreshed, const SharedLockW& thisLock);
+
+    /** 
+     * Waits for the background refresh and applies its result, unless it failed or the items were changed locally since
+     * @return true if the result was applied
+     */
+    bool ApplyRefresh(const SharedLockW& thisLock);
+
+    /** The result of the pending background refresh (if valid) */
+    std::future<std::shared_ptr<nlohmann::json>> mRefreshFuture;
+    /** The time the pending background refresh was started */
+    std::chrono::steady_clock::time_point mRefreshStart;
+    /** The number of local changes to mItemMap (see CountChange) */
+    uint64_t mChangeCount { 0 };
+    /** The value of mChangeCount when the pending background refresh was started */
+    uint64_t mRefreshChangeCount { 0 };
+
     mutable Debug mDebug;
 };
 
@@ -1,4 +1,5 @@
 
+#include <chrono>
 #include "nlohmann/json.hpp"
 
 #include "Item.hpp"
@@ -11,6 +12,17 @@ using Andromeda::Backend::BackendImpl;
 namespace Andromeda {
 namespace Filesystem {
 
+namespace { // anonymous
+// the function to call on remote changes, held shared while calling
+std::shared_mutex sChangeMutex; Item::RemoteChangeFunc sChangeFunc;
+} // namespace
+
+/*****************************************************/
+Item::Date Item::GetNowDate()
+{
+    return std::chrono::duration<Date>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 /*****************************************************/
 Item::Item(BackendImpl& backend) : 
     mBackend(backend), mDebug(__func__,this)
@@ -44,6 +56,63 @@ Item::Item(BackendImpl& backend, const nlohmann::json& data) :
         throw BackendImpl::JSONErrorException(ex.what()); }
 }
 
+/*****************************************************/
+Item::~Item()
+{
+    InvalidateWeakRef(); // if not deleted via GetDeleteLock
+}
+
+/*****************************************************/
+Item::WeakRef Item::GetWeakRef()
+{
+    const std::lock_guard<std::mutex> llock(mWeakRefMutex);
+    if (!mWeakRef) mWeakRef = std::make_shared<WeakRefState>(*this);
+    return mWeakRef;
+}
+
+/*****************************************************/
+Item::ScopeLocked Item::TryLockScope(const WeakRef& ref)
+{
+    // the item can't be destructed while we hold the ref lock - only try to lock its 
+    // scope here so we never wait on a delete lock (which waits on our ref lock)
+    const std::shared_lock<std::shared_mutex> refLock(ref->mMutex);
+    if (ref->mItem == nullptr) return ScopeLocked();
+    return ref->mItem->TryLockScope();
+}
+
+/*****************************************************/
+Item::DeleteLock Item::GetDeleteLock()
+{
+    DeleteLock retval(mScopeMutex);
+    InvalidateWeakRef(); // can't be re-locked after we unlock
+    return retval;
+}
+
+/*****************************************************/
+void Item::SetRemoteChangeFunc(RemoteChangeFunc func)
+{
+    const std::unique_lock<std::shared_mutex> llock(sChangeMutex);
+    sChangeFunc = std::move(func);
+}
+
+/*****************************************************/
+void Item::NotifyRemoteChange(const std::string& name) const
+{
+    const std::shared_lock<std::shared_mutex> llock(sChangeMutex);
+    if (sChangeFunc) sChangeFunc(*this, name);
+}
+
+/*****************************************************/
+void Item::InvalidateWeakRef()
+{
+    const std::lock_guard<std::mutex> llock(mWeakRefMutex);
+    const WeakRef weakRef { std::move(mWeakRef) }; // outlives refLock
+    if (!weakRef) return;
+
+    const std::unique_lock<std::shared_mutex> refLock(weakRef->mMutex);
+    weakRef->mItem = nullptr;
+}
+
 /*****************************************************/
 void Item::Refresh(const nlohmann::json& data, const SharedLockW& thisLock)
 {
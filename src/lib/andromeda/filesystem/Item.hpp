@@ -1,6 +1,9 @@
 #ifndef LIBA2_ITEM_H_
 #define LIBA2_ITEM_H_
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 
@@ -65,9 +68,42 @@ public:
      */
     inline ScopeLocked TryLockScope() { return ScopeLocked(*this, mScopeMutex); }
 
+    /** Shared state behind a WeakRef, cleared when the item is deleted */
+    struct WeakRefState
+    {
+        explicit WeakRefState(Item& item) : mItem(&item) { }
+        /** Mutex that protects mItem, held exclusively to clear it */
+        std::shared_mutex mMutex;
+        /** Pointer to the referenced item, null once deleted */
+        Item* mItem;
+    };
+
+    /** 
+     * A reference to an item that does NOT hold its scope lock, so it never blocks deleting the item
+     * Can be kept indefinitely (e.g. by a kernel inode) and re-locked with TryLockScope(ref)
+     */
+    using WeakRef = std::shared_ptr<WeakRefState>;
+
+    /** Returns a weak reference to this item (caller must hold a scope lock) */
+    WeakRef GetWeakRef();
+
+    /** Tries to lock the scope of the referenced item, returns a ref that is not locked if it was deleted */
+    static ScopeLocked TryLockScope(const WeakRef& ref);
+
+    /** 
+     * Function called when a refresh finds a remote change
+     * @param item the file whose data/attributes changed, or the folder whose contents changed
+     * @param name the name of the added/removed item if a folder, else empty
+     * Called with the item (and maybe its parent) locked, so it must not call back into the filesystem
+     */
+    using RemoteChangeFunc = std::function<void (const Item& item, const std::string& name)>;
+
+    /** Sets the process-wide function to call on remote changes (e.g. to invalidate kernel caches) */
+    static void SetRemoteChangeFunc(RemoteChangeFunc func);
+
     using DeleteLock = std::unique_lock<std::shared_mutex>;
     /** Permanently, exclusively locks the scope lock if not acquired (use before deleting) */
-    virtual DeleteLock GetDeleteLock() { return DeleteLock(mScopeMutex); }
+    virtual DeleteLock GetDeleteLock();
 
     /** Returns a read lock for this item */
     inline SharedLockR GetReadLock() const { return SharedLockR(mItemMutex); }
@@ -85,13 +121,16 @@ public:
     inline SharedLockW::LockPair GetWriteLockPair(Item& item) { 
         return SharedLockW::get_pair(mItemMutex, item.mItemMutex); }
 
-    virtual ~Item() = default;
+    virtual ~Item();
     DELETE_COPY(Item)
     DELETE_MOVE(Item)
 
     /** API date format */
     using Date = double;
 
+    /** Returns the current time as a Date */
+    static Date GetNowDate();
+
     /** Concrete item types */
     enum class Type : uint8_t { FILE, FOLDER };
 
@@ -233,6 +272,9 @@ protected:
      */
     static void ValidateName(const std::string& name, bool backend = false);
 
+    /** Calls the RemoteChangeFunc if set, see RemoteChangeFunc */
+    void NotifyRemoteChange(const std::string& name = "") const;
+
     /** 
      * Item type-specific delete
      * @throws ReadOnlyFSException if read only
@@ -285,6 +327,14 @@ protected:
 
 private:
 
+    /** Clears the weak reference so it can no longer be locked */
+    void InvalidateWeakRef();
+
+    /** Weak reference handed out by GetWeakRef() if any */
+    WeakRef mWeakRef;
+    /** Mutex that protects mWeakRef */
+    std::mutex mWeakRefMutex;
+
     mutable Debug mDebug;
 };
 
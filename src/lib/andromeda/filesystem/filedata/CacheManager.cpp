@@ -1,10 +1,12 @@
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 
 #include "CacheManager.hpp"
 #include "CacheOptions.hpp"
 #include "CachingAllocator.hpp"
+#include "DiskCache.hpp"
 #include "Page.hpp"
 #include "PageManager.hpp"
 
@@ -26,7 +28,12 @@ CacheManager::CacheManager(const CacheOptions& cacheOptions, bool startThreads)
 
     const size_t memoryLimit { mCacheOptions.memoryLimit };
     const size_t allocBaseline { memoryLimit - memoryLimit/mCacheOptions.evictSizeFrac };
-    mPageAllocator = std::make_unique<CachingAllocator>(allocBaseline);
+    using AllocMode = CacheOptions::AllocMode; const AllocMode allocMode { mCacheOptions.allocMode };
+    mPageAllocator = std::make_unique<CachingAllocator>(allocBaseline, allocMode >= AllocMode::ARENA, 
+        allocMode >= AllocMode::THP, allocMode == AllocMode::HUGETLB);
+
+    if (!mCacheOptions.diskCachePath.empty())
+        mDiskCache = std::make_unique<DiskCache>(mCacheOptions);
 
     if (startThreads) StartThreads();
 }
@@ -76,6 +83,9 @@ void CacheManager::InformPage(PageManager& pageMgr, const uint64_t index, const
 {
     MDBG_INFO("(page:" << index << " " << &page << " canWait:" << BOOLSTR(canWait) << ")");
 
+    // same size so no memory handling needed, just a deferred LRU promotion
+    if (TryRecordHit(page, dirty)) { MDBG_INFO("... hit recorded"); return; }
+
     UniqueLock lock(mMutex);
 
     const size_t oldSize { EnqueuePage(pageMgr, index, page, dirty, lock) };
@@ -92,12 +102,37 @@ void CacheManager::InformPage(PageManager& pageMgr, const uint64_t index, const
 /*****************************************************/
 size_t CacheManager::EnqueuePage(PageManager& pageMgr, const uint64_t index, const Page& page, bool dirty, const UniqueLock& lock) // cppcheck-suppress constParameterReference
 {
+    // with 2Q, new pages go on probation unless recently evicted from it (mGhostQueue),
+    // then move to the main queue on their next access - read-ahead pages that are never
+    // actually read (only the fetch informs us) never make it past probation
+    bool probation { mCacheOptions.evictPolicy == CacheOptions::EvictPolicy::TWOQ };
+    bool reused { false };
+    if (probation)
+    {
+        const PageQueue::lookup_iterator itLookup { mProbationQueue.lookup(&page) };
+        if (itLookup != mProbationQueue.lend())
+        {
+            reused = itLookup->second->second.mReused;
+            if (!reused) // probation is a FIFO, keep the page's place
+                return UpdateProbation(itLookup->second->second, page, dirty, lock);
+            probation = false; // promote on this access
+        }
+        else if (mPageQueue.lookup(&page) != mPageQueue.lend())
+            probation = false;
+        else reused = mGhostQueue.erase(GetGhostKey(pageMgr, index));
+    }
+
     const size_t oldSize { RemovePage(page, lock) };
     const size_t newSize { page.capacity() }; // real memory usage
 
-    const PageInfo pageInfo { pageMgr, index, newSize };
+    const PageInfo pageInfo { pageMgr, index, newSize, reused };
 
-    mPageQueue.enqueue_front(&page, pageInfo);
+    if (probation)
+    {
+        mProbationQueue.enqueue_front(&page, pageInfo);
+        mProbationTotal += newSize;
+    }
+    else mPageQueue.enqueue_front(&page, pageInfo);
     mCurrentTotal += newSize;
 
     PrintStatus(__func__, lock);
@@ -109,11 +144,134 @@ size_t CacheManager::EnqueuePage(PageManager& pageMgr, const uint64_t index, con
         PrintDirtyStatus(__func__, lock);
     }
 
+    UpdateHitShard(page, lock);
+
+    MDBG_INFO("... pageSize:" << page.size() 
+        << " newSize:" << newSize << " oldSize:" << oldSize);
+    return oldSize;
+}
+
+/*****************************************************/
+size_t CacheManager::UpdateProbation(PageInfo& pageInfo, const Page& page, bool dirty, const UniqueLock& lock)
+{
+    const size_t oldSize { pageInfo.mPageSize };
+    const size_t newSize { page.capacity() }; // real memory usage
+
+    RemoveDirty(page, lock);
+    mCurrentTotal = mCurrentTotal - oldSize + newSize;
+    mProbationTotal = mProbationTotal - oldSize + newSize;
+    pageInfo.mPageSize = newSize;
+
+    PrintStatus(__func__, lock);
+
+    if (dirty)
+    {
+        mDirtyQueue.enqueue_front(&page, pageInfo);
+        mCurrentDirty += newSize;
+        PrintDirtyStatus(__func__, lock);
+    }
+
+    UpdateHitShard(page, lock);
+
     MDBG_INFO("... pageSize:" << page.size() 
         << " newSize:" << newSize << " oldSize:" << oldSize);
     return oldSize;
 }
 
+/*****************************************************/
+CacheManager::HitShard& CacheManager::GetHitShard(const Page& page)
+{
+    // pages are heap-allocated so the low bits are mostly alignment
+    const size_t hash { std::hash<const Page*>()(&page) };
+    return mHitShards[(hash ^ (hash >> 6) ^ (hash >> 12)) % HIT_SHARDS];
+}
+
+/*****************************************************/
+bool CacheManager::TryRecordHit(const Page& page, const bool dirty)
+{
+    HitShard& shard { GetHitShard(page) };
+    std::vector<const Page*> hits;
+
+    { // lock scope
+        const UniqueLock shardLock(shard.mMutex);
+
+        const decltype(HitShard::mPages)::const_iterator pageIt { shard.mPages.find(&page) };
+        if (pageIt == shard.mPages.end() || pageIt->second != std::make_pair(page.capacity(), dirty))
+            return false; // not tracked, or size/dirty changed
+
+        shard.mHits.push_back(&page);
+        if (shard.mHits.size() < HIT_BATCH) return true;
+
+        hits.swap(shard.mHits);
+        shard.mHits.reserve(HIT_BATCH);
+    }
+
+    // never hold a shard lock while getting mMutex
+    const UniqueLock lock(mMutex);
+    PromoteHits(hits, lock);
+    return true;
+}
+
+/*****************************************************/
+void CacheManager::UpdateHitShard(const Page& page, const UniqueLock& lock)
+{
+    HitShard& shard { GetHitShard(page) };
+    const UniqueLock shardLock(shard.mMutex);
+
+    const bool probation { mPageQueue.lookup(&page) == mPageQueue.lend() };
+    PageQueue& pageQueue { probation ? mProbationQueue : mPageQueue };
+
+    const PageQueue::lookup_iterator itLookup { pageQueue.lookup(&page) };
+    if (itLookup == pageQueue.lend())
+        shard.mPages.erase(&page);
+    else
+    {
+        const bool dirty { mDirtyQueue.lookup(&page) != mDirtyQueue.lcend() };
+        shard.mPages[&page] = { itLookup->second->second.mPageSize, dirty };
+    }
+}
+
+/*****************************************************/
+void CacheManager::PromoteHits(const std::vector<const Page*>& hits, const UniqueLock& lock)
+{
+    MDBG_INFO("(hits:" << hits.size() << ")");
+
+    // pages may have been removed since the hit, the key is then not found
+    for (const Page* page : hits) // in order, the latest hit ends up in front
+    {
+        if (mPageQueue.move_front(page))
+            mDirtyQueue.move_front(page);
+        else
+        {
+            // probation is FIFO, only re-used pages are promoted to the main queue
+            const PageQueue::lookup_iterator itLookup { mProbationQueue.lookup(page) };
+            if (itLookup != mProbationQueue.lend() && itLookup->second->second.mReused)
+            {
+                const PageInfo pageInfo { itLookup->second->second }; // copy
+                mProbationTotal -= pageInfo.mPageSize;
+                mProbationQueue.erase(itLookup);
+                mPageQueue.enqueue_front(page, pageInfo);
+                mDirtyQueue.move_front(page);
+            }
+        }
+    }
+}
+
+/*****************************************************/
+void CacheManager::PromoteAllHits(const UniqueLock& lock)
+{
+    std::vector<const Page*> hits;
+    for (HitShard& shard : mHitShards)
+    {
+        { // lock scope
+            const UniqueLock shardLock(shard.mMutex);
+            hits.swap(shard.mHits);
+        }
+        if (!hits.empty()) PromoteHits(hits, lock);
+        hits.clear();
+    }
+}
+
 /*****************************************************/
 void CacheManager::ResizePage(const PageManager& pageMgr, const Page& page, const SharedLockW* mgrLock)
 {
@@ -122,11 +280,15 @@ void CacheManager::ResizePage(const PageManager& pageMgr, const Page& page, cons
 
     UniqueLock lock(mMutex);
 
-    { const PageQueue::iterator itQueue { mPageQueue.find(&page) };
-    if (itQueue != mPageQueue.end()) 
+    { const bool probation { mPageQueue.find(&page) == mPageQueue.end() };
+    PageQueue& pageQueue { probation ? mProbationQueue : mPageQueue };
+
+    const PageQueue::iterator itQueue { pageQueue.find(&page) };
+    if (itQueue != pageQueue.end()) 
     {
         const size_t oldSize { itQueue->second.mPageSize };
         mCurrentTotal += newSize-oldSize;
+        if (probation) mProbationTotal += newSize-oldSize;
         itQueue->second.mPageSize = newSize;
 
         PrintStatus(__func__, lock);
@@ -147,6 +309,8 @@ void CacheManager::ResizePage(const PageManager& pageMgr, const Page& page, cons
         if (newSize > oldSize)
             HandleDirtyMemory(pageMgr, page, true, lock, mgrLock);
     } }
+
+    UpdateHitShard(page, lock);
 }
 
 /*****************************************************/
@@ -158,14 +322,20 @@ void CacheManager::HandleMemory(const PageManager& pageMgr, const Page& page, bo
     {
         // in this case we can evict synchronously rather than the background thread
         // so we can directly pick up errors (they could be missed due to mSkipEvictWait)
-        while (ShouldEvict(lock) && 
-            &mPageQueue.back().second.mPageMgr == &pageMgr &&
-            mPageQueue.back().first != &page)
+        if (ShouldEvict(lock)) PromoteAllHits(lock);
+        while (ShouldEvict(lock))
         {
+            const PageInfo* nextEvict { nullptr };
+            ForEachEvictable([&](const Page& evictPage, PageInfo& evictInfo)->bool {
+                if (&evictInfo.mPageMgr == &pageMgr && &evictPage != &page)
+                    nextEvict = &evictInfo;
+                return false; }, lock); // only the first
+            if (nextEvict == nullptr) break;
+
             MDBG_INFO("... memory limit! synchronous evict");
 
             PrintStatus(__func__, lock);
-            PageInfo pageInfo { mPageQueue.back().second }; // copy
+            PageInfo pageInfo { *nextEvict }; // copy
 
             lock.unlock(); // don't hold lock during evict
             pageInfo.mPageMgr.EvictPage(pageInfo.mPageIndex, *mgrLock); // throws
@@ -260,9 +430,18 @@ bool CacheManager::ShouldAwaitFlush(const PageManager& pageMgr, const UniqueLock
 }
 
 /*****************************************************/
-void CacheManager::RemovePage(const Page& page)
+void CacheManager::RemovePage(const Page& page, bool evicted)
 {
     const UniqueLock lock(mMutex);
+
+    // remember pages evicted from probation so we know if they are re-used
+    const PageQueue::lookup_iterator itLookup { mProbationQueue.lookup(&page) };
+    if (evicted && itLookup != mProbationQueue.lend())
+    {
+        const PageInfo& pageInfo { itLookup->second->second };
+        AddGhost(pageInfo.mPageMgr, pageInfo.mPageIndex, lock);
+    }
+
     RemovePage(page, lock);
 
     PrintStatus(__func__, lock);
@@ -290,11 +469,67 @@ size_t CacheManager::RemovePage(const Page& page, const UniqueLock& lock)
         mCurrentTotal -= pageSize;
         mPageQueue.erase(itLookup);
     }
+    else
+    {
+        const PageQueue::lookup_iterator itProbation { mProbationQueue.lookup(&page) };
+        if (itProbation != mProbationQueue.lend())
+        {
+            MDBG_INFO("(page:" << &page << ") probation");
+            pageSize = itProbation->second->second.mPageSize;
+            mCurrentTotal -= pageSize;
+            mProbationTotal -= pageSize;
+            mProbationQueue.erase(itProbation);
+        }
+    }
 
-    RemoveDirty(page, lock);
+    RemoveDirty(page, lock); // also updates the hit shard
     return pageSize;
 }
 
+/*****************************************************/
+size_t CacheManager::GetGhostKey(const PageManager& pageMgr, const uint64_t index)
+{
+    // a collision only means a page skips probation, no need to be exact
+    return std::hash<const PageManager*>()(&pageMgr) ^ 
+        static_cast<size_t>(index*0x9E3779B97F4A7C15ULL); // golden ratio
+}
+
+/*****************************************************/
+void CacheManager::AddGhost(const PageManager& pageMgr, const uint64_t index, const UniqueLock& lock)
+{
+    const size_t key { GetGhostKey(pageMgr, index) };
+    mGhostQueue.erase(key);
+    mGhostQueue.enqueue_front(key);
+
+    // remember about as many evicted pages as are cached
+    const size_t maxGhosts { std::max(mPageQueue.size() + mProbationQueue.size(), static_cast<size_t>(1)) };
+    while (mGhostQueue.size() > maxGhosts)
+        static_cast<void>(mGhostQueue.pop_back());
+}
+
+/*****************************************************/
+void CacheManager::ForEachEvictable(const std::function<bool (const Page&, PageInfo&)>& func, const UniqueLock& lock)
+{
+    // with 2Q, evict from probation first while it's over its share, then the main queue
+    const size_t probationMax { mCacheOptions.memoryLimit / PROBATION_FRAC };
+    size_t probationExcess { (mProbationTotal > probationMax) ? mProbationTotal - probationMax : 0 };
+
+    // func may erase the current page, which does not invalidate the next reverse_iterator
+    PageQueue::reverse_iterator probIt { mProbationQueue.rbegin() };
+    for (; probationExcess > 0 && probIt != mProbationQueue.rend(); ++probIt)
+    {
+        const size_t pageSize { probIt->second.mPageSize };
+        if (!func(*probIt->first, probIt->second)) return;
+        probationExcess -= std::min(pageSize, probationExcess);
+    }
+
+    for (PageQueue::reverse_iterator pageIt { mPageQueue.rbegin() }; pageIt != mPageQueue.rend(); ++pageIt)
+        if (!func(*pageIt->first, pageIt->second)) return;
+
+    for (; probIt != mProbationQueue.rend(); ++probIt)
+        if (!func(*probIt->first, probIt->second)) return;
+}
+
 /*****************************************************/
 void CacheManager::RemoveDirty(const Page& page, const UniqueLock& lock)
 {
@@ -305,16 +540,20 @@ void CacheManager::RemoveDirty(const Page& page, const UniqueLock& lock)
         mCurrentDirty -= itLookup->second->second.mPageSize;
         mDirtyQueue.erase(itLookup);
     }
+
+    UpdateHitShard(page, lock);
 }
 
 /*****************************************************/
 void CacheManager::PrintStatus(const char* const fname, const UniqueLock& lock)
 {
     mDebug.Info([&](std::ostream& str){ str << fname << "..."
-        << " pages:" << mPageQueue.size() << ", memory:" << mCurrentTotal; });
+        << " pages:" << mPageQueue.size() << ", probation:" << mProbationQueue.size() << ", memory:" << mCurrentTotal; });
 
 #if DEBUG // this will kill performance
-    size_t total = 0; for (const PageQueue::value_type& pageInfo : mPageQueue) total += pageInfo.second.mPageSize;
+    size_t probTotal = 0; for (const PageQueue::value_type& pageInfo : mProbationQueue) probTotal += pageInfo.second.mPageSize;
+    if (probTotal != mProbationTotal){ MDBG_ERROR(": BAD PROBATION TRACKING! " << probTotal << " != " << mProbationTotal); assert(false); }
+    size_t total = probTotal; for (const PageQueue::value_type& pageInfo : mPageQueue) total += pageInfo.second.mPageSize;
     if (total != mCurrentTotal){ MDBG_ERROR(": BAD MEMORY TRACKING! " << total << " != " << mCurrentTotal); assert(false); }
 #endif // DEBUG
 }
@@ -413,15 +652,14 @@ void CacheManager::DoPageEvictions() noexcept // thread cannot throw
     { // lock scope
         const UniqueLock lock(mMutex);
 
+        PromoteAllHits(lock); // so recent hits aren't evicted
         PrintStatus(__func__, lock);
         size_t cleaned { 0 };
 
-        PageQueue::reverse_iterator pageIt { mPageQueue.rbegin() };
         const size_t margin { mCacheOptions.memoryLimit/mCacheOptions.evictSizeFrac };
-        for (; mCurrentTotal + margin > mCacheOptions.memoryLimit + cleaned; ++pageIt)
+        ForEachEvictable([&](const Page& pageRef, PageInfo& pageInfo)->bool
         {
-            const Page& pageRef { *pageIt->first };
-            PageInfo& pageInfo { pageIt->second };
+            if (mCurrentTotal + margin <= mCacheOptions.memoryLimit + cleaned) return false;
 
             const PageMgrPageMap::iterator evictIt { currentEvicts.find(&pageInfo.mPageMgr) };
             // get ScopeLock to make sure pageManager stays in scope between mMutex release and getting pageMgrW lock
@@ -435,7 +673,8 @@ void CacheManager::DoPageEvictions() noexcept // thread cannot throw
                 evictSet.second.emplace_back(pageRef, pageInfo); // copy
                 cleaned += pageInfo.mPageSize;
             }
-        }
+            return true;
+        }, lock);
     }
 
     // THEN evict all the pages in the set
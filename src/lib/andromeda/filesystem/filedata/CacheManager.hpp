@@ -2,16 +2,20 @@
 #ifndef LIBA2_CACHEMANAGER_H_
 #define LIBA2_CACHEMANAGER_H_
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <exception>
+#include <functional>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "BandwidthMeasure.hpp"
 #include "CacheOptions.hpp"
@@ -29,10 +33,15 @@ namespace Filedata {
 class Page;
 class PageManager;
 class CachingAllocator;
+class DiskCache;
 
 /** 
  * Manages pages as an LRU cache to limit memory usage, by calling EvictPage()
  * Also tracks dirty pages to limit the total dirty memory, by calling FlushPage()
+ * Hits on already-tracked pages are recorded in sharded buffers without taking the
+ *     main lock, and promoted in the LRU in batches (memory accounting stays exact)
+ * The replacement policy is selectable (see CacheOptions::EvictPolicy) - with 2Q,
+ *     new pages are kept in a probation FIFO until proven to be re-used
  * The maximum dirty pages is in terms of time, determined by bandwidth measurement
  * Fully thread-safe. Evict/Flush are synchronous if possible when writing for
  *     error-catching - otherwise, they happen on background threads.
@@ -71,20 +80,38 @@ public:
         size_t currentDirty; 
         size_t dirtyLimit; 
         size_t dirtyPages; 
+        /** Number of pages in the probation queue (2Q) */
+        size_t probationPages;
+        /** Number of reads that found their page in memory */
+        size_t readHits;
+        /** Number of reads that had to wait for a fetch */
+        size_t readMisses;
     };
     /** Returns a copy of some member variables for debugging */
     inline Stats GetStats() const 
     { 
         const UniqueLock lock(mMutex); 
-        return { mCurrentTotal, mPageQueue.size(), 
-            mCurrentDirty, mDirtyLimit, mDirtyQueue.size() }; 
+        return { mCurrentTotal, mPageQueue.size() + mProbationQueue.size(), 
+            mCurrentDirty, mDirtyLimit, mDirtyQueue.size(), mProbationQueue.size(),
+            mReadHits.load(), mReadMisses.load() }; 
+    }
+
+    /** Inform us of a page read for the hit-ratio stats (hit if the page was in memory) */
+    inline void CountRead(bool hit)
+    {
+        (hit ? mReadHits : mReadMisses).fetch_add(1, std::memory_order_relaxed);
     }
 
     /** Returns the allocator to use for all file data */
     inline CachingAllocator& GetPageAllocator(){ return *mPageAllocator; }
+
+    /** Returns the persistent on-disk page cache or nullptr if not enabled */
+    inline DiskCache* GetDiskCache(){ return mDiskCache.get(); }
     
     /** 
      * Inform us that a page was used, putting at the front of the LRU
+     * If the page is already tracked with the same size and dirtiness, the LRU promotion
+     *     is deferred and batched (see HitShard) so concurrent readers don't contend
      * if mgrLock is given, may synchronously evict or flush pages on this manager
      * IF this fails, the caller must call RemovePage() or ResizePage(oldSize)
      * @param pageMgr the page manager that owns the page
@@ -111,8 +138,11 @@ public:
      */
     void ResizePage(const PageManager& pageMgr, const Page& page, const SharedLockW* mgrLock = nullptr);
 
-    /** Inform us that a page has been erased */
-    void RemovePage(const Page& page);
+    /** 
+     * Inform us that a page has been erased
+     * @param evicted true if the page was evicted to free memory rather than deleted
+     */
+    void RemovePage(const Page& page, bool evicted = false);
 
     /** Inform us that a page is no longer dirty */
     void RemoveDirty(const Page& page);
@@ -121,6 +151,21 @@ private:
 
     using UniqueLock = std::unique_lock<std::mutex>;
 
+    using PageInfo = struct
+    {
+        /** Reference to the page manager owner of the page */
+        PageManager& mPageMgr;
+        /** Index of the page in the pageMgr */
+        const uint64_t mPageIndex;
+        /** Size of the page when it was added */
+        size_t mPageSize;
+        /** True if the page was recently evicted and re-fetched (2Q) */
+        bool mReused { false };
+    };
+
+    /** Queue of pages in recently-used order */
+    using PageQueue = OrderedMap<const Page*, PageInfo>;
+
     /** 
      * Returns true if we should wait for a page eviction
      * @throws MemoryException if over limit and mEvictFailure is set
@@ -179,15 +224,71 @@ private:
      */
     size_t EnqueuePage(PageManager& pageMgr, uint64_t index, const Page& page, bool dirty, const UniqueLock& lock);
 
+    /** 
+     * Updates the size and dirtiness of a page already on probation, keeping its place in the queue
+     * @return size_t the size of the old page
+     */
+    size_t UpdateProbation(PageInfo& pageInfo, const Page& page, bool dirty, const UniqueLock& lock);
+
     /** 
      * Inform us that a page has been erased (already have the lock) 
      * @return size_t size of the page that was erased or 0 if it didn't exist
      */
     size_t RemovePage(const Page& page, const UniqueLock& lock);
 
+    /** Returns the history key for the given page in mGhostQueue */
+    static size_t GetGhostKey(const PageManager& pageMgr, uint64_t index);
+
+    /** Adds the given page to mGhostQueue, trimming it to the number of pages cached */
+    void AddGhost(const PageManager& pageMgr, uint64_t index, const UniqueLock& lock);
+
+    /** 
+     * Calls func for pages in the order they should be evicted, until it returns false
+     * func may remove the page it was given, but no others
+     */
+    void ForEachEvictable(const std::function<bool (const Page&, PageInfo&)>& func, const UniqueLock& lock);
+
     /** Inform us that a page is no longer dirty (already have the lock) */
     void RemoveDirty(const Page& page, const UniqueLock& lock);
 
+    /** The number of page hit shards, see HitShard */
+    static constexpr size_t HIT_SHARDS { 16 };
+    /** The number of hits a shard buffers before promoting them */
+    static constexpr size_t HIT_BATCH { 64 };
+
+    /** 
+     * A shard of the tracked pages that allows recording page hits without mMutex
+     * Each page's entry mirrors its state in mPageQueue/mDirtyQueue, updated under mMutex
+     */
+    struct HitShard
+    {
+        /** Mutex that protects this shard (lock AFTER mMutex) */
+        std::mutex mMutex;
+        /** Map of tracked page to its <size, isDirtyQueued> */
+        std::unordered_map<const Page*, std::pair<size_t, bool>> mPages;
+        /** List of page hits not yet promoted in the LRU */
+        std::vector<const Page*> mHits;
+    };
+
+    /** Returns the hit shard for the given page */
+    HitShard& GetHitShard(const Page& page);
+
+    /** 
+     * Records a hit on the given page without taking mMutex, if possible
+     * Promotes the shard's buffered hits if the batch is full
+     * @return true if recorded, false if the page needs a full EnqueuePage()
+     */
+    bool TryRecordHit(const Page& page, bool dirty);
+
+    /** Updates the given page's hit shard entry to match its queue state */
+    void UpdateHitShard(const Page& page, const UniqueLock& lock);
+
+    /** Moves the given hit pages to the front of the LRU (if still tracked) */
+    void PromoteHits(const std::vector<const Page*>& hits, const UniqueLock& lock);
+
+    /** Promotes all buffered hits from every shard, before choosing pages to evict */
+    void PromoteAllHits(const UniqueLock& lock);
+
     /** Send some stats about memory to debug */
     void PrintStatus(const char* fname, const UniqueLock& lock);
 
@@ -227,21 +328,28 @@ private:
     /** Mutex to guard writing data structures */
     mutable std::mutex mMutex;
 
-    using PageInfo = struct
-    {
-        /** Reference to the page manager owner of the page */
-        PageManager& mPageMgr;
-        /** Index of the page in the pageMgr */
-        const uint64_t mPageIndex;
-        /** Size of the page when it was added */
-        size_t mPageSize;
-    };
-
-    /** LIFO queue of pages for an LRU cache */
-    using PageQueue = OrderedMap<const Page*, PageInfo>;
+    /** LIFO queue of pages for an LRU cache (the main queue for 2Q) */
     PageQueue mPageQueue;
+    /** LIFO queue of dirty pages for flushing */
     PageQueue mDirtyQueue;
 
+    /** The fraction of the memory limit the 2Q probation queue may use before it is evicted first (1/x) */
+    static constexpr size_t PROBATION_FRAC { 4 };
+    /** FIFO queue of pages not yet proven to be re-used (2Q), evicted before mPageQueue */
+    PageQueue mProbationQueue;
+    /** The current total memory usage of mProbationQueue */
+    size_t mProbationTotal { 0 };
+    /** FIFO history of pages recently evicted from mProbationQueue (2Q) */
+    HashedQueue<size_t> mGhostQueue;
+
+    /** Number of reads that found their page in memory */
+    std::atomic<size_t> mReadHits { 0 };
+    /** Number of reads that had to wait for a fetch */
+    std::atomic<size_t> mReadMisses { 0 };
+
+    /** Shards for recording page hits without mMutex */
+    std::array<HitShard, HIT_SHARDS> mHitShards;
+
     // structures used in Page Evict/Flush
     using PageList = std::list<std::pair<const Page&, PageInfo>>;
     using LockedPageList = std::pair<ScopeLocked<PageManager>, PageList>;
@@ -289,6 +397,8 @@ private:
     BandwidthMeasure mBandwidth;
     /** Allocator to use for all file pages (never null) */
     std::unique_ptr<CachingAllocator> mPageAllocator;
+    /** Second-tier cache for clean pages (null if disabled) */
+    std::unique_ptr<DiskCache> mDiskCache;
 };
 
 } // namespace Filedata
@@ -20,7 +20,9 @@ std::string CacheOptions::HelpText()
 
     output << "Cache Advanced:  [--no-cachemgr] [--max-dirty ms(" << defDirty << ")]"
         << " [--memory-limit bytes"<<stBits<<"(" << StringUtil::bytesToString(optDefault.memoryLimit) << ")]"
-        << " [--evict-frac uint32(" << optDefault.evictSizeFrac << ")]";
+        << " [--evict-frac uint32(" << optDefault.evictSizeFrac << ")] [--cache-policy lru|2q]"
+        << " [--cache-alloc direct|arena|thp|hugetlb]"
+        << " [--disk-cache path [--disk-cache-limit bytes64(" << StringUtil::bytesToString(optDefault.diskCacheLimit) << ")]]";
 
     return output.str();
 }
@@ -58,6 +60,28 @@ bool CacheOptions::AddOption(const std::string& option, const std::string& value
 
         if (!evictSizeFrac) throw BaseOptions::BadValueException(option);
     }
+    else if (option == "cache-policy")
+    {
+        if      (value == "lru") evictPolicy = EvictPolicy::LRU;
+        else if (value == "2q")  evictPolicy = EvictPolicy::TWOQ;
+        else throw BaseOptions::BadValueException(option);
+    }
+    else if (option == "cache-alloc")
+    {
+        if      (value == "direct")  allocMode = AllocMode::DIRECT;
+        else if (value == "arena")   allocMode = AllocMode::ARENA;
+        else if (value == "thp")     allocMode = AllocMode::THP;
+        else if (value == "hugetlb") allocMode = AllocMode::HUGETLB;
+        else throw BaseOptions::BadValueException(option);
+    }
+    else if (option == "disk-cache")
+        diskCachePath = value;
+    else if (option == "disk-cache-limit")
+    {
+        try { diskCacheLimit = StringUtil::stringToBytes(value); }
+        catch (const std::logic_error& e) { 
+            throw BaseOptions::BadValueException(option); }
+    }
     else return false; // not used
 
     return true; 
@@ -51,6 +51,39 @@ struct CacheOptions
 
     /** True to disable the CacheManager */
     bool disable { false };
+
+    /** The page replacement policy used when evicting */
+    enum class EvictPolicy : uint8_t
+    {
+        /** least recently used, simple but a large sequential read flushes everything */ LRU,
+        /** 2Q - new pages go to a FIFO probation queue and only reach the main LRU
+            if they are accessed again after being evicted recently (scan resistant) */ TWOQ
+    };
+
+    /** The page replacement policy used when evicting */
+    EvictPolicy evictPolicy { EvictPolicy::LRU };
+
+    /** How page memory is requested from the OS (see MemoryAllocator) */
+    enum class AllocMode : uint8_t
+    {
+        /** a separate OS mapping for each allocation */ DIRECT,
+        /** carve allocations out of 2MB-aligned arenas, far fewer mappings */ ARENA,
+        /** ARENA and ask the OS to back arenas with transparent huge pages */ THP,
+        /** ARENA backed by reserved huge pages (MAP_HUGETLB) if available, else THP */ HUGETLB
+    };
+
+    /** How page memory is requested from the OS */
+    AllocMode allocMode { AllocMode::DIRECT };
+
+    /** 
+     * Directory for the persistent on-disk page cache (empty to disable)
+     * Clean pages read from the backend are stored here and re-used across mounts
+     * as long as the file's size and modified date on the backend are unchanged.
+     */
+    std::string diskCachePath;
+
+    /** The maximum total size of the on-disk page cache before evicting (bytes) */
+    uint64_t diskCacheLimit { static_cast<uint64_t>(1024)*1024*1024 };
 };
 
 } // namespace Filedata
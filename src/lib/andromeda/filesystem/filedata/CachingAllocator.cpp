@@ -1,6 +1,9 @@
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <functional>
+#include <thread>
 
 #include "CachingAllocator.hpp"
 #include "andromeda/Debug.hpp"
@@ -10,36 +13,76 @@ namespace Filesystem {
 namespace Filedata {
 
 /*****************************************************/
-CachingAllocator::CachingAllocator(const size_t baseline) : 
-    mDebug(__func__,this), mBaseline(baseline) { }
+CachingAllocator::CachingAllocator(const size_t baseline, const bool useArenas, const bool hugePages, const bool hugeTLB) : 
+    MemoryAllocator(useArenas, hugePages, hugeTLB), mDebug(__func__,this), mBaseline(baseline) { }
 
 /*****************************************************/
 CachingAllocator::~CachingAllocator()
 {
+    for (Magazine& magazine : mMagazines)
+        for (size_t i { 0 }; i < magazine.mCount; ++i)
+            MemoryAllocator::free(magazine.mFree[i], magazine.mPages);
+
     for (const FreeListMap::value_type& pair : mFreeLists)
         for (void* ptr : pair.second)
             MemoryAllocator::free(ptr, pair.first);
 }
 
+// Magazine: when freed, a page goes onto the calling thread's magazine if it is the magazine's size
+// the Magazine allows quick re-alloc of the same size without mMutex, overflow goes to the depot
 // FreeList: when freed, a page goes onto the front of the list for that alloc size
 // the FreeList allows quick re-alloc by looking up the alloc size then taking the first entry (LIFO)
 // FreeQueue: when freed, a page goes onto the front of the free queue
 // the FreeQueue allows quick cleanup by popping a free off the end of the list (FIFO)
 
+/*****************************************************/
+CachingAllocator::Magazine& CachingAllocator::get_magazine() noexcept
+{
+    const size_t hash { std::hash<std::thread::id>()(std::this_thread::get_id()) };
+    return mMagazines[hash % MAGAZINE_SHARDS];
+}
+
+/*****************************************************/
+void CachingAllocator::add_alloc(const size_t bytes) noexcept
+{
+    const size_t curAlloc { mCurAlloc.fetch_add(bytes) + bytes };
+    size_t maxAlloc { mMaxAlloc.load() };
+    while (curAlloc > maxAlloc && !mMaxAlloc.compare_exchange_weak(maxAlloc, curAlloc)) { }
+}
+
 /*****************************************************/
 void* CachingAllocator::alloc(size_t pages)
 {
     MDBG_INFO("(pages:" << pages << " bytes:" << pages*mPageSize << ")");
     if (!pages) return nullptr;
 
+    ++mAllocs; // total
+    add_alloc(pages*mPageSize);
+
+    MDBG_INFO("... mBaseline:" << mBaseline 
+        << " mCurAlloc:" << mCurAlloc << " mMaxAlloc:" << mMaxAlloc);
+
     { // lock scope
-        const LockGuard lock(mMutex);
-        ++mAllocs; // total
-        mCurAlloc += pages*mPageSize;
-        mMaxAlloc = std::max(mCurAlloc, mMaxAlloc);
+        Magazine& magazine { get_magazine() };
+        const LockGuard magLock(magazine.mMutex);
+
+        if (!magazine.mCount) refill_magazine(magazine, pages, magLock);
+        if (magazine.mCount && magazine.mPages == pages)
+        {
+            void* const ptr { magazine.mFree[--magazine.mCount] };
+#if DEBUG // sanity checks
+            std::memset(ptr, 0x55, pages*mPageSize); // poison
+#endif // DEBUG
+            mCurFree -= pages*mPageSize;
+            ++mRecycles;
+
+            MDBG_INFO("... magazine recycle ptr:" << ptr << " count:" << magazine.mCount);
+            return ptr;
+        }
+    }
 
-        MDBG_INFO("... mBaseline:" << mBaseline 
-            << " mCurAlloc:" << mCurAlloc << " mMaxAlloc:" << mMaxAlloc);
+    { // lock scope
+        const LockGuard lock(mMutex);
 
         FreeListMap::iterator fmIt { mFreeLists.lower_bound(pages) };
         if (fmIt != mFreeLists.end())
@@ -93,20 +136,79 @@ void CachingAllocator::free(void* const ptr, size_t pages)
     MDBG_INFO("(ptr:" << ptr << " pages:" << pages << " bytes:" << pages*mPageSize << ")");
     if (ptr == nullptr || !pages) return;
 
-    const LockGuard lock(mMutex);
-    const size_t freeListSize { add_entry(ptr, pages, lock) };
 #if DEBUG // sanity checks
     std::memset(ptr, 0xAA, pages*mPageSize); // poison
     assert(pages*mPageSize <= mCurAlloc);
 #endif // DEBUG
 
-    mCurFree += pages*mPageSize;
     mCurAlloc -= pages*mPageSize;
+    const size_t curFree { mCurFree += pages*mPageSize };
+
+    { // lock scope
+        Magazine& magazine { get_magazine() };
+        const LockGuard magLock(magazine.mMutex);
+
+        if (!magazine.mCount) magazine.mPages = pages;
+        if (magazine.mPages == pages && curFree <= get_free_limit())
+        {
+            if (magazine.mCount == MAGAZINE_SIZE) 
+                flush_magazine(magazine, magLock);
+
+            magazine.mFree[magazine.mCount++] = ptr;
+            MDBG_INFO("... to magazine count:" << magazine.mCount << " mCurFree:" << curFree);
+            return;
+        }
+    }
+
+    const LockGuard lock(mMutex);
+    const size_t freeListSize { add_entry(ptr, pages, lock) };
 
     MDBG_INFO("... to freeList:" << pages << ":" << freeListSize
         << " freeQueue:" << mFreeQueue.size() << " mCurFree:" << mCurFree << " mCurAlloc:" << mCurAlloc);
 
-    while (mCurFree > mMaxAlloc-mBaseline) clean_entry(lock);
+    // magazines are not cleaned, but they are only added to under the limit
+    while (mCurFree > get_free_limit() && !mFreeQueue.empty()) clean_entry(lock);
+}
+
+/*****************************************************/
+void CachingAllocator::refill_magazine(Magazine& magazine, const size_t pages, const LockGuard& magLock)
+{
+    const LockGuard lock(mMutex);
+
+    const FreeListMap::iterator fmIt { mFreeLists.find(pages) }; // exact size only
+    if (fmIt == mFreeLists.end()) return;
+
+    FreeList& freeList { fmIt->second };
+    magazine.mPages = pages;
+    while (!freeList.empty() && magazine.mCount < MAGAZINE_SIZE/2)
+    {
+        void* const ptr { freeList.front() };
+        freeList.pop_front();
+        mFreeQueue.erase(ptr);
+        magazine.mFree[magazine.mCount++] = ptr; // still counted in mCurFree
+    }
+
+    MDBG_INFO("... refilled magazine count:" << magazine.mCount);
+
+    // never have an empty list!
+    if (freeList.empty())
+        mFreeLists.erase(fmIt);
+}
+
+/*****************************************************/
+void CachingAllocator::flush_magazine(Magazine& magazine, const LockGuard& magLock)
+{
+    const LockGuard lock(mMutex);
+
+    const size_t flushCount { magazine.mCount/2 };
+    for (size_t i { 0 }; i < flushCount; ++i) // oldest first
+        add_entry(magazine.mFree[i], magazine.mPages, lock);
+
+    std::move(magazine.mFree.begin()+flushCount, 
+        magazine.mFree.begin()+magazine.mCount, magazine.mFree.begin());
+    magazine.mCount -= flushCount;
+
+    MDBG_INFO("... flushed magazine count:" << magazine.mCount << " freeQueue:" << mFreeQueue.size());
 }
 
 /*****************************************************/
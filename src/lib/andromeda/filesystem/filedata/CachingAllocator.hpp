@@ -2,6 +2,8 @@
 #ifndef LIBA2_CACHINGALLOCATOR_H_
 #define LIBA2_CACHINGALLOCATOR_H_
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <list>
 #include <map>
@@ -24,14 +26,19 @@ namespace Filedata {
  * NOTE 1) memory is allocated only at page size granularity.  Use get_usage() to determine the actual memory size of an allocation.
  * NOTE 2) allocations are only re-used if they are the exact size of a previously freed allocation.
  * ... these make this a bad general allocator, but good for allocating filedata pages that are mostly constant per-filesystem.
+ * Most alloc/free calls only use a per-thread magazine of same-sized free allocations (see Magazine),
+ * the central free lists (the depot) are only used to refill or take overflow from magazines.
  * THREAD SAFE (INTERNAL LOCKS)
  */
 class CachingAllocator : public MemoryAllocator
 {
 public:
 
-    /** @param baseline the amount of memory used when evict stops, used to calculate the free pool max size */
-    explicit CachingAllocator(size_t baseline);
+    /** 
+     * @param baseline the amount of memory used when evict stops, used to calculate the free pool max size
+     * @param useArenas hugePages hugeTLB how to request memory from the OS (see MemoryAllocator)
+     */
+    explicit CachingAllocator(size_t baseline, bool useArenas = false, bool hugePages = false, bool hugeTLB = false);
 
     ~CachingAllocator() override;
     DELETE_COPY(CachingAllocator)
@@ -63,8 +70,7 @@ public:
     /** Returns a copy of some member variables for debugging */
     inline Stats GetStats() const
     { 
-        const LockGuard lock(mMutex); 
-        return { mCurAlloc, mMaxAlloc, mCurFree, mRecycles, mAllocs }; 
+        return { mCurAlloc.load(), mMaxAlloc.load(), mCurFree.load(), mRecycles.load(), mAllocs.load() }; 
     }
 
 private:
@@ -80,7 +86,46 @@ private:
     /** Removes and returns to the OS the smallest freed allocation */
     void clean_entry(const LockGuard& lock);
 
+    /** Returns the max size of the free pool (mMaxAlloc-mBaseline) */
+    [[nodiscard]] inline size_t get_free_limit() const noexcept { return mMaxAlloc - mBaseline; }
+
+    /** Adds to mCurAlloc and updates mMaxAlloc */
+    void add_alloc(size_t bytes) noexcept;
+
+    /** The number of magazine shards, see Magazine */
+    static constexpr size_t MAGAZINE_SHARDS { 16 };
+    /** The max number of free allocations in each magazine */
+    static constexpr size_t MAGAZINE_SIZE { 16 };
+
+    /** 
+     * A small stack of free allocations all of the same size, threads are hashed to magazines.
+     * The common case of re-using a same-sized allocation only takes the (mostly uncontended) 
+     * magazine lock rather than mMutex and the free list maps.  Allocations in magazines 
+     * are counted in mCurFree so the free pool limit still applies.
+     */
+    struct Magazine
+    {
+        /** Mutex that protects this magazine, must be locked before mMutex */
+        std::mutex mMutex;
+        /** The size (pages) of the allocations in this magazine */
+        size_t mPages { 0 };
+        /** The number of allocations in mFree */
+        size_t mCount { 0 };
+        /** Stack of free allocations (LIFO) */
+        std::array<void*, MAGAZINE_SIZE> mFree { };
+    };
+
+    /** Returns the magazine to use for the calling thread */
+    Magazine& get_magazine() noexcept;
+
+    /** Moves up to half a magazine of allocations of the given size from the depot to the (empty) magazine */
+    void refill_magazine(Magazine& magazine, size_t pages, const LockGuard& magLock);
+
+    /** Moves the oldest half of the (full) magazine to the depot */
+    void flush_magazine(Magazine& magazine, const LockGuard& magLock);
+
     mutable Debug mDebug;
+    /** Mutex that protects the depot (free lists/queue) */
     mutable std::mutex mMutex;
 
     // the maximum size of the free pool is (mMaxAlloc-mBaseline)
@@ -91,17 +136,20 @@ private:
     /** The amount of memory used when evict stops */
     const size_t mBaseline;
     /** Current total memory allocated */
-    size_t mCurAlloc { 0 };
+    std::atomic<size_t> mCurAlloc { 0 };
     /** Peak total memory allocated */
-    size_t mMaxAlloc { 0 };
+    std::atomic<size_t> mMaxAlloc { 0 };
 
-    /** The current size (bytes) of the free pool */
-    size_t mCurFree { 0 };
+    /** The current size (bytes) of the free pool, including magazines */
+    std::atomic<size_t> mCurFree { 0 };
 
     /** The number of times an allocation was re-used (debug) */
-    uint64_t mRecycles { 0 };
+    std::atomic<uint64_t> mRecycles { 0 };
     /** The total number of calls to alloc() (debug) */
-    uint64_t mAllocs { 0 };
+    std::atomic<uint64_t> mAllocs { 0 };
+
+    /** Per-thread magazines of free allocations */
+    std::array<Magazine, MAGAZINE_SHARDS> mMagazines;
 
     /** List of freed allocations that can be re-used */
     using FreeList = std::list<void*>;
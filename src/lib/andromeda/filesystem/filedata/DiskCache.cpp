@@ -0,0 +1,342 @@
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+#include "CacheOptions.hpp"
+#include "DiskCache.hpp"
+#include "Page.hpp"
+
+namespace fs = std::filesystem;
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+
+namespace { // anonymous
+
+constexpr uint32_t HEADER_MAGIC { 0x41325043 }; // A2PC
+/** The page file header format, increment when it changes (older files are invalid) */
+constexpr uint32_t HEADER_FORMAT { 1 };
+
+/** 
+ * Page file header, identifies the backend version of the data
+ * magic and format (4 bytes each) then backendSize, modified (IEEE 754) and pageSize (8 bytes each), all little-endian
+ */
+using PageHeader = std::array<char, 4+4+8+8+8>; // NOLINT(readability-magic-numbers)
+constexpr size_t HEADER_SIZE { std::tuple_size<PageHeader>::value };
+
+constexpr const char* PAGE_EXT { ".page" };
+constexpr const char* TEMP_EXT { ".tmp" };
+// pages waiting to be stored are copies in memory, limit them to memoryLimit divided by this
+constexpr size_t PENDING_LIMIT_FRAC { 16 };
+
+/** Writes the given value to header at offset as bytes# little-endian bytes */
+void PutBytes(PageHeader& header, const size_t offset, const uint64_t value, const size_t bytes)
+{
+    for (size_t i { 0 }; i < bytes; ++i)
+        header.at(offset+i) = static_cast<char>((value >> (8*i)) & 0xFF); // NOLINT(readability-magic-numbers)
+}
+
+/** Reads a bytes# little-endian value from header at offset */
+uint64_t GetBytes(const PageHeader& header, const size_t offset, const size_t bytes)
+{
+    uint64_t value { 0 };
+    for (size_t i { 0 }; i < bytes; ++i)
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(header.at(offset+i))) << (8*i); // NOLINT(readability-magic-numbers)
+    return value;
+}
+
+static_assert(sizeof(double) == sizeof(uint64_t), "double must be 64-bit");
+
+/** Returns the serialized header for the given version */
+PageHeader SerializeHeader(const DiskCache::Version& version)
+{
+    uint64_t modified { 0 }; std::memcpy(&modified, &version.modified, sizeof(modified));
+
+    PageHeader header { };
+    PutBytes(header, 0, HEADER_MAGIC, 4);
+    PutBytes(header, 4, HEADER_FORMAT, 4);
+    PutBytes(header, 8, version.backendSize, 8); // NOLINT(readability-magic-numbers)
+    PutBytes(header, 16, modified, 8); // NOLINT(readability-magic-numbers)
+    PutBytes(header, 24, version.pageSize, 8); // NOLINT(readability-magic-numbers)
+    return header;
+}
+
+/** Returns true iff the given header is valid and matches the given version */
+bool CheckHeader(const PageHeader& header, const DiskCache::Version& version)
+{
+    if (GetBytes(header, 0, 4) != HEADER_MAGIC || GetBytes(header, 4, 4) != HEADER_FORMAT) return false;
+
+    DiskCache::Version fileVersion { };
+    fileVersion.backendSize = GetBytes(header, 8, 8); // NOLINT(readability-magic-numbers)
+    const uint64_t modified { GetBytes(header, 16, 8) }; // NOLINT(readability-magic-numbers)
+    std::memcpy(&fileVersion.modified, &modified, sizeof(modified));
+    fileVersion.pageSize = GetBytes(header, 24, 8); // NOLINT(readability-magic-numbers)
+    return fileVersion == version;
+}
+
+/** Returns the given name made safe for use as a directory name */
+std::string GetDirName(std::string name)
+{
+    // hostnames have dots, IDs should be alphanumeric but just in case
+    std::replace_if(name.begin(), name.end(), [](const char c){
+        return c == '/' || c == '\\' || c == '.' || c == ':'; }, '_');
+    return name;
+}
+
+} // namespace
+
+/*****************************************************/
+DiskCache::DiskCache(const CacheOptions& cacheOptions) :
+    mDebug(__func__,this),
+    mCachePath(cacheOptions.diskCachePath),
+    mDiskLimit(cacheOptions.diskCacheLimit),
+    mPendingLimit(cacheOptions.memoryLimit / PENDING_LIMIT_FRAC),
+    mStorePool(1)
+{
+    MDBG_INFO("(path:" << mCachePath.string() << " limit:" << mDiskLimit << ")");
+
+    std::error_code ec; fs::create_directories(mCachePath, ec);
+    if (ec) { MDBG_ERROR("... create_directories failed: " << ec.message()); }
+    else LoadPages();
+}
+
+/*****************************************************/
+std::string DiskCache::GetPageKey(const std::string& backendName, const std::string& fileID, const uint64_t index)
+{
+    // file IDs are only unique per backend
+    return GetDirName(backendName)+"/"+GetDirName(fileID)+"/"+std::to_string(index)+PAGE_EXT;
+}
+
+/*****************************************************/
+void DiskCache::LoadPages()
+{
+    using PageEntry = std::tuple<fs::file_time_type, std::string, uint64_t>;
+    std::vector<PageEntry> pages;
+
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it { mCachePath, ec }, end; !ec && it != end; it.increment(ec))
+    {
+        if (!it->is_regular_file(ec)) continue;
+        const fs::path& path { it->path() };
+
+        if (path.extension() == PAGE_EXT)
+        {
+            const fs::file_time_type time { it->last_write_time(ec) };
+            const uint64_t size { it->file_size(ec) };
+            if (!ec) pages.emplace_back(time, path.lexically_relative(mCachePath).generic_string(), size);
+        }
+        else if (path.extension() == TEMP_EXT)
+            fs::remove(path, ec); // interrupted store
+    }
+    if (ec) { MDBG_ERROR("... directory scan failed: " << ec.message()); }
+
+    // most recently used first
+    std::sort(pages.begin(), pages.end(), std::greater<PageEntry>());
+
+    const UniqueLock lock(mMutex);
+    for (const PageEntry& page : pages)
+    {
+        mPageQueue.enqueue_back(std::get<1>(page), CachedPage{std::get<2>(page), 0});
+        mCurrentTotal += std::get<2>(page);
+    }
+
+    MDBG_INFO("... pages:" << mPageQueue.size() << " total:" << mCurrentTotal);
+    EvictPages(lock); // in case the limit changed
+}
+
+/*****************************************************/
+bool DiskCache::ReadPage(const std::string& backendName, const std::string& fileID, const uint64_t index, const Version& version, Page& page)
+{
+    const std::string key { GetPageKey(backendName, fileID, index) };
+
+    uint64_t storeID { 0 }; { // lock scope
+        const UniqueLock lock(mMutex);
+        const PageQueue::lookup_iterator itLookup { mPageQueue.lookup(key) };
+        if (itLookup == mPageQueue.lend()) { ++mMisses; return false; }
+
+        // move to the front of the LRU
+        const CachedPage cached { itLookup->second->second };
+        mPageQueue.erase(itLookup);
+        mPageQueue.enqueue_front(key, cached);
+        storeID = cached.storeID;
+    }
+
+    const fs::path path { mCachePath / key };
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    // the file might have been evicted since we unlocked, just a miss
+
+    PageHeader header { };
+    file.read(header.data(), static_cast<std::streamsize>(header.size()));
+    const bool valid { file.good() && CheckHeader(header, version) };
+
+    if (valid) file.read(page.data(), static_cast<std::streamsize>(page.size()));
+
+    // the file must contain exactly the page data
+    if (!valid || !file.good() || file.peek() != std::ifstream::traits_type::eof())
+    {
+        MDBG_INFO("(key:" << key << ") invalid page, removing");
+        file.close();
+
+        const UniqueLock lock(mMutex);
+        // a store may have replaced the file since we unlocked, only remove the one we read
+        const PageQueue::lookup_iterator itLookup { mPageQueue.lookup(key) };
+        if (itLookup != mPageQueue.lend() && itLookup->second->second.storeID == storeID)
+            RemovePage(key, lock);
+        ++mMisses; return false;
+    }
+
+    std::error_code ec; // update the persisted LRU order
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+    MDBG_INFO("(key:" << key << ") cache hit");
+    const UniqueLock lock(mMutex);
+    ++mHits; return true;
+}
+
+/*****************************************************/
+void DiskCache::StorePage(const std::string& backendName, const std::string& fileID, const uint64_t index, const Version& version, const Page& page)
+{
+    const std::string key { GetPageKey(backendName, fileID, index) };
+    if (HEADER_SIZE + page.size() > mDiskLimit) return; // would be evicted immediately
+
+    MDBG_INFO("(key:" << key << ")");
+
+    uint64_t storeID { 0 }; { // lock scope
+        const UniqueLock lock(mMutex);
+        const PendingMap::iterator it { mPendingStores.find(key) };
+        if (it != mPendingStores.end()) ErasePendingStore(it, lock); // replaces any older store
+
+        // always allow one store so a small memory limit doesn't disable the cache
+        if (!mPendingStores.empty() && mPendingBytes + page.size() > mPendingLimit)
+        {
+            MDBG_INFO("... too many pending stores, dropping");
+            ++mDroppedStores; return;
+        }
+
+        storeID = mNextStoreID++;
+        mPendingStores.emplace(key, PendingStore{storeID, page.size()});
+        mPendingBytes += page.size();
+    }
+
+    // the page may be evicted or changed once we return, copy it
+    std::string data(page.data(), page.size());
+    mStorePool.AddJob(this, FetchPool::Priority::READAHEAD, 
+        [this, key, storeID, version, data=std::move(data)]() {
+            WritePage(key, storeID, version, data); });
+}
+
+/*****************************************************/
+void DiskCache::WritePage(const std::string& key, const uint64_t storeID, const Version& version, const std::string& data)
+{
+    { // lock scope
+        const UniqueLock lock(mMutex);
+        const PendingMap::const_iterator it { mPendingStores.find(key) };
+        if (it == mPendingStores.end() || it->second.storeID != storeID) return; // removed or replaced
+    }
+
+    const fs::path path { mCachePath / key };
+    // temp name is unique per store in case the same page is stored again
+    const fs::path tempPath { path.string() + "." + std::to_string(storeID) + TEMP_EXT };
+
+    bool written { false };
+    std::error_code ec; fs::create_directories(path.parent_path(), ec);
+    if (ec) { MDBG_ERROR("... create_directories failed: " << ec.message()); }
+    else // write the temp file then rename so a page file is never partial
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        const PageHeader header { SerializeHeader(version) };
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+        file.close(); written = file.good();
+        if (!written) { MDBG_ERROR("... failed to write " << tempPath.string()); }
+    }
+
+    const UniqueLock lock(mMutex);
+
+    const PendingMap::iterator it { mPendingStores.find(key) };
+    if (it == mPendingStores.end() || it->second.storeID != storeID) written = false; // removed or replaced meanwhile
+    else ErasePendingStore(it, lock);
+
+    if (written) // rename while locked so a concurrent RemovePages() can't be undone
+    {
+        fs::rename(tempPath, path, ec);
+        if (ec) { MDBG_ERROR("... rename failed: " << ec.message()); written = false; }
+    }
+    if (!written) { fs::remove(tempPath, ec); return; }
+
+    const uint64_t fileSize { HEADER_SIZE + data.size() };
+
+    const PageQueue::lookup_iterator itLookup { mPageQueue.lookup(key) };
+    if (itLookup != mPageQueue.lend())
+    {
+        mCurrentTotal -= itLookup->second->second.fileSize;
+        mPageQueue.erase(itLookup);
+    }
+
+    mPageQueue.enqueue_front(key, CachedPage{fileSize, storeID});
+    mCurrentTotal += fileSize;
+
+    EvictPages(lock);
+}
+
+/*****************************************************/
+void DiskCache::RemovePages(const std::string& backendName, const std::string& fileID, const uint64_t index, const size_t count)
+{
+    MDBG_INFO("(backend:" << backendName << " fileID:" << fileID << " index:" << index << " count:" << count << ")");
+
+    const UniqueLock lock(mMutex);
+    for (uint64_t curIndex { index }; curIndex < index+count; ++curIndex)
+    {
+        const std::string key { GetPageKey(backendName, fileID, curIndex) };
+        const PendingMap::iterator it { mPendingStores.find(key) };
+        if (it != mPendingStores.end()) ErasePendingStore(it, lock); // cancel
+        RemovePage(key, lock);
+    }
+}
+
+/*****************************************************/
+void DiskCache::RemovePage(const std::string& key, const UniqueLock& lock)
+{
+    const PageQueue::lookup_iterator itLookup { mPageQueue.lookup(key) };
+    if (itLookup != mPageQueue.lend())
+    {
+        mCurrentTotal -= itLookup->second->second.fileSize;
+        mPageQueue.erase(itLookup);
+
+        std::error_code ec; fs::remove(mCachePath / key, ec);
+        if (ec) { MDBG_ERROR("... remove failed: " << ec.message()); }
+    }
+}
+
+/*****************************************************/
+void DiskCache::ErasePendingStore(const PendingMap::iterator& it, const UniqueLock& lock)
+{
+    mPendingBytes -= it->second.size;
+    mPendingStores.erase(it);
+}
+
+/*****************************************************/
+void DiskCache::EvictPages(const UniqueLock& lock)
+{
+    while (mCurrentTotal > mDiskLimit && !mPageQueue.empty())
+    {
+        const PageQueue::value_type page { mPageQueue.pop_back() };
+        MDBG_INFO("... evicting " << page.first);
+        mCurrentTotal -= page.second.fileSize;
+
+        std::error_code ec; fs::remove(mCachePath / page.first, ec);
+        if (ec) { MDBG_ERROR("... remove failed: " << ec.message()); }
+    }
+}
+
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
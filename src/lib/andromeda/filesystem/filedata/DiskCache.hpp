@@ -0,0 +1,189 @@
+
+#ifndef LIBA2_DISKCACHE_H_
+#define LIBA2_DISKCACHE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "FetchPool.hpp"
+#include "andromeda/common.hpp"
+#include "andromeda/Debug.hpp"
+#include "andromeda/OrderedMap.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+
+struct CacheOptions;
+class Page;
+
+/**
+ * Second-tier page cache that stores clean pages read from the backend on local disk
+ * Each page is a separate file under the cache directory, keyed by backend name, file ID and page index,
+ * with a header recording the backend version (size/modified/pagesize) it was read from.
+ * The LRU order is kept in memory and persisted using the page files' modified times,
+ * so the cache survives restarts. Disk errors are never fatal - they are treated as misses.
+ * Pages are stored by a background worker so callers (e.g. receiving from the network) never wait on the disk.
+ * The page copies waiting to be stored are limited to a fraction of the memory limit, further stores are dropped.
+ * THREAD SAFE (INTERNAL LOCKS)
+ */
+class DiskCache
+{
+public:
+
+    /** The backend version of a file that a cached page must match to be valid */
+    struct Version
+    {
+        /** The file size on the backend */
+        uint64_t backendSize;
+        /** The file's modified date on the backend */
+        double modified;
+        /** The page size in use for the file */
+        uint64_t pageSize;
+
+        bool operator==(const Version& rhs) const { return backendSize == rhs.backendSize
+            && modified == rhs.modified && pageSize == rhs.pageSize; }
+        bool operator!=(const Version& rhs) const { return !(*this == rhs); }
+    };
+
+    /** Opens the cache directory given in cacheOptions and loads its existing pages */
+    explicit DiskCache(const CacheOptions& cacheOptions);
+
+    /** Drops any pages not yet stored */
+    virtual ~DiskCache() = default;
+    DELETE_COPY(DiskCache)
+    DELETE_MOVE(DiskCache)
+
+    /**
+     * Reads the given page from the disk cache into the given page buffer
+     * A cached page with a different version or size is removed
+     * @param backendName the name of the file's backend (see BackendImpl::GetName)
+     * @param fileID the backend ID of the file
+     * @param index the page index within the file
+     * @param version the current backend version of the file
+     * @param page the page to fill, must already have the expected size
+     * @return true iff the page was found and read
+     */
+    bool ReadPage(const std::string& backendName, const std::string& fileID, uint64_t index, const Version& version, Page& page);
+
+    /**
+     * Copies the given page and stores it to the disk cache in the background, evicting old pages if over the limit
+     * The store is dropped if too many are already waiting (e.g. the disk is slower than the network)
+     * @param backendName the name of the file's backend (see BackendImpl::GetName)
+     * @param fileID the backend ID of the file
+     * @param index the page index within the file
+     * @param version the backend version the page was read from
+     * @param page the page to store (must not be dirty)
+     */
+    void StorePage(const std::string& backendName, const std::string& fileID, uint64_t index, const Version& version, const Page& page);
+
+    /** 
+     * Removes count# pages of the given file starting at index, e.g. when they are written to the backend
+     * Also cancels storing any of them if not yet finished
+     */
+    void RemovePages(const std::string& backendName, const std::string& fileID, uint64_t index, size_t count);
+
+    /** A copy of some member variables for debugging */
+    struct Stats
+    {
+        uint64_t currentTotal;
+        size_t totalPages;
+        size_t hits;
+        size_t misses;
+        size_t pendingStores;
+        size_t droppedStores;
+    };
+    /** Returns a copy of some member variables for debugging */
+    inline Stats GetStats() const
+    {
+        const UniqueLock lock(mMutex);
+        return { mCurrentTotal, mPageQueue.size(), mHits, mMisses, mPendingStores.size(), mDroppedStores };
+    }
+
+private:
+
+    using UniqueLock = std::unique_lock<std::mutex>;
+
+    /** Returns the cache key (path relative to mCachePath) for the given page */
+    static std::string GetPageKey(const std::string& backendName, const std::string& fileID, uint64_t index);
+
+    /** Scans mCachePath to build mPageQueue, oldest pages last, removing leftover temp files */
+    void LoadPages();
+
+    /** 
+     * Writes the given page data to disk (runs on mStorePool)
+     * @param storeID the ID of the store in mPendingStores, does nothing if no longer pending
+     */
+    void WritePage(const std::string& key, uint64_t storeID, const Version& version, const std::string& data);
+
+    /** Removes the given key from mPageQueue and deletes its file */
+    void RemovePage(const std::string& key, const UniqueLock& lock);
+
+    /** A store queued on mStorePool */
+    struct PendingStore
+    {
+        /** The ID of the store (a later store or remove replaces/erases it) */
+        uint64_t storeID;
+        /** The size of the page data held for the store */
+        size_t size;
+    };
+    using PendingMap = std::map<std::string, PendingStore>;
+
+    /** Erases the given entry from mPendingStores */
+    void ErasePendingStore(const PendingMap::iterator& it, const UniqueLock& lock);
+
+    /** Removes pages from the end of mPageQueue until below the disk limit */
+    void EvictPages(const UniqueLock& lock);
+
+    mutable Debug mDebug;
+
+    /** Mutex that protects the page queue and stats */
+    mutable std::mutex mMutex;
+
+    /** The directory holding the cache */
+    const std::filesystem::path mCachePath;
+    /** The maximum total size of cached files (bytes) */
+    const uint64_t mDiskLimit;
+    /** The maximum total size of page data waiting to be stored (bytes) */
+    const uint64_t mPendingLimit;
+
+    /** A page file in the cache */
+    struct CachedPage
+    {
+        /** The size of the page file */
+        uint64_t fileSize;
+        /** The ID of the store that wrote the file (0 if loaded from disk) */
+        uint64_t storeID;
+    };
+    /** LIFO queue of page key to page file for an LRU cache */
+    using PageQueue = OrderedMap<std::string, CachedPage>;
+    PageQueue mPageQueue;
+
+    /** The current total disk usage */
+    uint64_t mCurrentTotal { 0 };
+    /** Number of pages successfully read */
+    size_t mHits { 0 };
+    /** Number of pages not found or not valid */
+    size_t mMisses { 0 };
+
+    /** Map of page key to its queued store */
+    PendingMap mPendingStores;
+    /** The total size of page data in mPendingStores */
+    uint64_t mPendingBytes { 0 };
+    /** Number of stores dropped because mPendingLimit was reached */
+    size_t mDroppedStores { 0 };
+    /** The ID of the next store (0 is for loaded pages) */
+    uint64_t mNextStoreID { 1 };
+
+    /** Background worker for storing pages (last, so it is stopped first) */
+    FetchPool mStorePool;
+};
+
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
+
+#endif // LIBA2_DISKCACHE_H_
@@ -0,0 +1,243 @@
+
+#include <utility>
+
+#include "FetchPool.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+
+/*****************************************************/
+FetchPool::FetchPool(const size_t maxThreads) :
+    mDebug(__func__,this), mMaxThreads(maxThreads)
+{
+    MDBG_INFO("(maxThreads:" << maxThreads << ")");
+}
+
+/*****************************************************/
+FetchPool::~FetchPool()
+{
+    MDBG_INFO("()");
+
+    std::map<std::thread::id, std::thread> workers;
+    { // lock scope
+        const UniqueLock lock(mMutex);
+        mRunning = false;
+
+        for (OwnerQueue& queue : mQueues) queue.clear();
+        mQueuedJobs.fill(0);
+
+        mJobCV.notify_all();
+        workers.swap(mWorkers);
+    }
+
+    for (decltype(workers)::value_type& worker : workers)
+        worker.second.join();
+
+    MDBG_INFO("... return!");
+}
+
+/*****************************************************/
+void FetchPool::AddJob(const void* owner, const Priority priority, Job job)
+{
+    MDBG_INFO("(owner:" << owner << " priority:" << static_cast<int>(priority) << ")");
+
+    const UniqueLock lock(mMutex);
+    JoinFinished(lock);
+
+    OwnerQueue& queue { mQueues[static_cast<size_t>(priority)] };
+    OwnerQueue::iterator queueIt { queue.find(owner) };
+    if (queueIt == queue.end())
+    {
+        queue.enqueue_back(owner, std::list<Job>());
+        queueIt = std::prev(queue.end());
+    }
+
+    queueIt->second.emplace_back(std::move(job));
+    ++mQueuedJobs[static_cast<size_t>(priority)];
+
+    ScheduleJob(priority, lock);
+}
+
+/*****************************************************/
+void FetchPool::ScheduleJob(const Priority priority, const UniqueLock& lock)
+{
+    if (mIdleWorkers >= CountJobs(lock))
+        mJobCV.notify_one();
+    else if (mBaseWorkers < mMaxThreads)
+        StartWorker(false, lock);
+    else if (priority == Priority::SYNC)
+        StartWorker(true, lock); // SYNC never waits for the pool
+    else { MDBG_INFO("... pool is full, queued:" << CountJobs(lock)); }
+}
+
+/*****************************************************/
+void FetchPool::PromoteJobs(const void* owner)
+{
+    const UniqueLock lock(mMutex);
+
+    OwnerQueue& readQueue { mQueues[static_cast<size_t>(Priority::READAHEAD)] };
+    const OwnerQueue::iterator readIt { readQueue.find(owner) };
+    if (readIt == readQueue.end()) return; // nothing to promote
+
+    MDBG_INFO("(owner:" << owner << ") jobs:" << readIt->second.size());
+
+    std::list<Job> jobs { std::move(readIt->second) };
+    readQueue.erase(owner);
+
+    OwnerQueue& syncQueue { mQueues[static_cast<size_t>(Priority::SYNC)] };
+    OwnerQueue::iterator syncIt { syncQueue.find(owner) };
+    if (syncIt == syncQueue.end())
+    {
+        syncQueue.enqueue_back(owner, std::list<Job>());
+        syncIt = std::prev(syncQueue.end());
+    }
+
+    const size_t count { jobs.size() };
+    syncIt->second.splice(syncIt->second.end(), jobs);
+
+    mQueuedJobs[static_cast<size_t>(Priority::READAHEAD)] -= count;
+    mQueuedJobs[static_cast<size_t>(Priority::SYNC)] += count;
+
+    for (size_t i { 0 }; i < count; ++i)
+        ScheduleJob(Priority::SYNC, lock);
+}
+
+/*****************************************************/
+void FetchPool::RemoveJobs(const void* owner)
+{
+    MDBG_INFO("(owner:" << owner << ")");
+
+    UniqueLock lock(mMutex);
+
+    for (size_t priority { 0 }; priority < mQueues.size(); ++priority)
+    {
+        OwnerQueue& queue { mQueues[priority] };
+        const OwnerQueue::iterator queueIt { queue.find(owner) };
+        if (queueIt != queue.end())
+        {
+            mQueuedJobs[priority] -= queueIt->second.size();
+            queue.erase(owner);
+        }
+    }
+
+    while (mActiveOwners.find(owner) != mActiveOwners.end())
+    {
+        MDBG_INFO("... waiting for running jobs");
+        mDoneCV.wait(lock);
+    }
+}
+
+/*****************************************************/
+FetchPool::Stats FetchPool::GetStats() const
+{
+    const UniqueLock lock(mMutex);
+    return { mQueuedJobs[static_cast<size_t>(Priority::SYNC)], 
+        mQueuedJobs[static_cast<size_t>(Priority::READAHEAD)], 
+        mActiveJobs, mBaseWorkers, mExtraWorkers, mCompletedJobs };
+}
+
+/*****************************************************/
+void FetchPool::StartWorker(const bool extra, const UniqueLock& lock)
+{
+    std::thread worker(&FetchPool::WorkerMain, this, extra);
+    const std::thread::id workerID { worker.get_id() };
+    mWorkers.emplace(workerID, std::move(worker));
+
+    ++(extra ? mExtraWorkers : mBaseWorkers);
+    MDBG_INFO("... workers:" << mBaseWorkers << " extra:" << mExtraWorkers);
+}
+
+/*****************************************************/
+void FetchPool::JoinFinished(const UniqueLock& lock)
+{
+    for (const std::thread::id& workerID : mFinished)
+    {
+        const decltype(mWorkers)::iterator workerIt { mWorkers.find(workerID) };
+        workerIt->second.join(); // already exited
+        mWorkers.erase(workerIt);
+    }
+    mFinished.clear();
+}
+
+/*****************************************************/
+size_t FetchPool::CountJobs(const UniqueLock& lock) const
+{
+    return mQueuedJobs[static_cast<size_t>(Priority::SYNC)] + 
+        mQueuedJobs[static_cast<size_t>(Priority::READAHEAD)];
+}
+
+/*****************************************************/
+bool FetchPool::HasJobs(const bool syncOnly, const UniqueLock& lock) const
+{
+    return syncOnly ? (mQueuedJobs[static_cast<size_t>(Priority::SYNC)] > 0) : (CountJobs(lock) > 0);
+}
+
+/*****************************************************/
+std::pair<const void*, FetchPool::Job> FetchPool::PopJob(const bool syncOnly, const UniqueLock& lock)
+{
+    const size_t queues { syncOnly ? 1 : mQueues.size() };
+    for (size_t priority { 0 }; priority < queues; ++priority) // in priority order
+    {
+        OwnerQueue& queue { mQueues[priority] };
+        if (queue.empty()) continue;
+
+        // take the first owner's first job, then move that owner to the back (round-robin)
+        OwnerQueue::value_type owner { queue.pop_front() };
+        Job job { std::move(owner.second.front()) };
+        owner.second.pop_front();
+
+        if (!owner.second.empty())
+            queue.enqueue_back(std::move(owner));
+
+        --mQueuedJobs[priority];
+        return std::make_pair(owner.first, std::move(job));
+    }
+
+    MDBG_ERROR("() ERROR no jobs!"); return {};
+}
+
+/*****************************************************/
+void FetchPool::WorkerMain(const bool extra)
+{
+    MDBG_INFO("(extra:" << extra << ")");
+
+    UniqueLock lock(mMutex);
+    while (mRunning)
+    {
+        if (!HasJobs(extra, lock))
+        {
+            // extra workers started for SYNC exit rather than wait or take READAHEAD
+            if (extra) break;
+
+            ++mIdleWorkers;
+            mJobCV.wait(lock);
+            --mIdleWorkers;
+            continue; // re-check
+        }
+
+        std::pair<const void*, Job> job { PopJob(extra, lock) };
+        ++mActiveOwners[job.first];
+        ++mActiveJobs;
+
+        lock.unlock();
+        job.second(); // noexcept
+        lock.lock();
+
+        const decltype(mActiveOwners)::iterator ownerIt { mActiveOwners.find(job.first) };
+        if (!--ownerIt->second) mActiveOwners.erase(ownerIt);
+        --mActiveJobs;
+        ++mCompletedJobs;
+        mDoneCV.notify_all();
+    }
+
+    --(extra ? mExtraWorkers : mBaseWorkers);
+    if (mRunning) // else the destructor will join
+        mFinished.push_back(std::this_thread::get_id());
+
+    MDBG_INFO("... exiting");
+}
+
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
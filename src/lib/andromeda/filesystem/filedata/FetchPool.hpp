@@ -0,0 +1,182 @@
+
+#ifndef LIBA2_FETCHPOOL_H_
+#define LIBA2_FETCHPOOL_H_
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "andromeda/common.hpp"
+#include "andromeda/Debug.hpp"
+#include "andromeda/OrderedMap.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+
+/**
+ * A shared, bounded pool of worker threads that runs page fetch jobs for all PageManagers
+ * Jobs are queued per-owner and owners are served round-robin so one file can't starve others.
+ * SYNC jobs (a reader is waiting) always run before READAHEAD jobs.  To guarantee progress
+ * for waiters (a worker may block on a file lock), a SYNC job never waits for a busy pool -
+ * an extra worker is started that only runs SYNC jobs and exits once there are none left,
+ * so at most maxThreads READAHEAD jobs ever run at once.
+ * THREAD SAFE (INTERNAL LOCKS)
+ */
+class FetchPool
+{
+public:
+
+    /** The priority of a fetch job */
+    enum class Priority : uint8_t
+    {
+        /** A reader is waiting for the result */ SYNC,
+        /** Speculative read-ahead */            READAHEAD
+    };
+
+    /** A fetch job to run on a worker thread (must not throw) */
+    using Job = std::function<void ()>;
+
+    /** @param maxThreads the max number of workers for READAHEAD jobs, never zero! */
+    explicit FetchPool(size_t maxThreads);
+
+    /** Removes all queued jobs and waits for running jobs to finish */
+    virtual ~FetchPool();
+    DELETE_COPY(FetchPool)
+    DELETE_MOVE(FetchPool)
+
+    /**
+     * Queues a job to run on a worker thread
+     * @param owner the object the job belongs to (e.g. PageManager)
+     * @param priority the priority of the job
+     * @param job the function to run
+     */
+    void AddJob(const void* owner, Priority priority, Job job);
+
+    /**
+     * Queues a function to run on a worker thread
+     * If the job is removed before it runs, the future's get() throws std::future_error
+     * @param owner the object the job belongs to (e.g. PageManager)
+     * @param priority the priority of the job
+     * @param func the function to run
+     * @return future for the function's result or exception
+     */
+    template <typename Func>
+    auto Run(const void* owner, Priority priority, Func func) -> std::future<std::invoke_result_t<Func>>
+    {
+        using Result = std::invoke_result_t<Func>;
+        // packaged_task is move-only but a Job must be copyable
+        const std::shared_ptr<std::packaged_task<Result ()>> task {
+            std::make_shared<std::packaged_task<Result ()>>(std::move(func)) };
+
+        std::future<Result> future { task->get_future() };
+        AddJob(owner, priority, [task](){ (*task)(); });
+        return future;
+    }
+
+    /** Moves all of the owner's queued READAHEAD jobs to SYNC, e.g. if a reader is now waiting on them */
+    void PromoteJobs(const void* owner);
+
+    /** Removes all of the owner's queued jobs and waits for its running jobs to finish */
+    void RemoveJobs(const void* owner);
+
+    /** A copy of some member variables for debugging */
+    struct Stats
+    {
+        /** Number of SYNC jobs waiting for a worker */
+        size_t syncJobs;
+        /** Number of READAHEAD jobs waiting for a worker */
+        size_t readAheadJobs;
+        /** Number of jobs currently running */
+        size_t activeJobs;
+        /** Number of base worker threads (at most maxThreads) */
+        size_t workers;
+        /** Number of extra worker threads running SYNC jobs */
+        size_t extraWorkers;
+        /** Number of jobs completed */
+        size_t completedJobs;
+    };
+    /** Returns a copy of some member variables for debugging */
+    Stats GetStats() const;
+
+private:
+
+    using UniqueLock = std::unique_lock<std::mutex>;
+
+    /** 
+     * Main loop for each worker thread
+     * @param extra if true, only run SYNC jobs and exit when there are none
+     */
+    void WorkerMain(bool extra);
+
+    /** Wakes or starts a worker for a newly queued job if allowed */
+    void ScheduleJob(Priority priority, const UniqueLock& lock);
+
+    /** Starts a new worker thread, see WorkerMain() */
+    void StartWorker(bool extra, const UniqueLock& lock);
+
+    /** Joins any worker threads that have exited */
+    void JoinFinished(const UniqueLock& lock);
+
+    /** Returns the total number of jobs queued */
+    size_t CountJobs(const UniqueLock& lock) const;
+
+    /** Returns true if any job is queued (or only SYNC jobs if syncOnly) */
+    bool HasJobs(bool syncOnly, const UniqueLock& lock) const;
+
+    /** Removes and returns the next job to run (MUST HasJobs) and its owner */
+    std::pair<const void*, Job> PopJob(bool syncOnly, const UniqueLock& lock);
+
+    mutable Debug mDebug;
+
+    /** Mutex that protects all members */
+    mutable std::mutex mMutex;
+    /** CV to signal workers that a job is available */
+    std::condition_variable mJobCV;
+    /** CV to signal that a running job finished */
+    std::condition_variable mDoneCV;
+
+    /** The max number of workers when not starting extra for SYNC */
+    const size_t mMaxThreads;
+
+    /** Queue of owners (round-robin order) to their list of jobs */
+    using OwnerQueue = OrderedMap<const void*, std::list<Job>>;
+    /** Owner queues indexed by Priority */
+    std::array<OwnerQueue, 2> mQueues;
+    /** Number of jobs in each of mQueues */
+    std::array<size_t, 2> mQueuedJobs { 0, 0 };
+
+    /** Map of owner to its number of running jobs */
+    std::map<const void*, size_t> mActiveOwners;
+    /** Number of jobs running */
+    size_t mActiveJobs { 0 };
+    /** Number of jobs completed */
+    size_t mCompletedJobs { 0 };
+
+    /** Map of worker threads by ID */
+    std::map<std::thread::id, std::thread> mWorkers;
+    /** List of workers that have exited and need joining */
+    std::list<std::thread::id> mFinished;
+    /** Number of base workers running (at most mMaxThreads) */
+    size_t mBaseWorkers { 0 };
+    /** Number of extra SYNC-only workers running */
+    size_t mExtraWorkers { 0 };
+    /** Number of (base) workers waiting for a job */
+    size_t mIdleWorkers { 0 };
+    /** Set to false to stop the workers */
+    bool mRunning { true };
+};
+
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
+
+#endif // LIBA2_FETCHPOOL_H_
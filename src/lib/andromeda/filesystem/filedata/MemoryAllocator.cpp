@@ -1,7 +1,10 @@
 
 #include <cassert>
+#include <fstream>
 #include <memory>
+#include <new>
 #include <ostream>
+#include <string>
 
 #if WIN32
 #include <windows.h>
@@ -12,24 +15,41 @@
 
 #include "MemoryAllocator.hpp"
 #include "andromeda/Debug.hpp"
+#include "andromeda/StringUtil.hpp"
 
 namespace Andromeda {
 namespace Filesystem {
 namespace Filedata {
 
 /*****************************************************/
-MemoryAllocator::MemoryAllocator() : 
+MemoryAllocator::MemoryAllocator(const bool useArenas, const bool hugePages, const bool hugeTLB) : 
     mPageSize(calcPageSize()),
+#if WIN32
+    mUseArenas(false), // arenas not supported
+#else // !WIN32
+    mUseArenas(useArenas && mPageSize <= ARENA_SIZE),
+#endif // WIN32
+    mHugePages(mUseArenas && hugePages),
+    mHugeTLB(mHugePages && hugeTLB),
+    mArenaPages(ARENA_SIZE/mPageSize),
     mDebug(__func__,this)
 {
-    MDBG_INFO("... mPageSize:" << mPageSize);
+    MDBG_INFO("... mPageSize:" << mPageSize << " arenas:" << BOOLSTR(mUseArenas)
+        << " hugePages:" << BOOLSTR(mHugePages) << " hugeTLB:" << BOOLSTR(mHugeTLB));
 }
 
-#if DEBUG // sanity checks
 /*****************************************************/
-MemoryAllocator::~MemoryAllocator(){ assert(mAllocMap.empty()); }
+MemoryAllocator::~MemoryAllocator()
+{
+#if DEBUG // sanity checks
+    assert(mAllocMap.empty());
 #endif // DEBUG
 
+    // in case of leaks, e.g. the CachingAllocator's free pool is freed by its destructor
+    for (const ArenaMap::value_type& arena : mArenas)
+        unmapDirect(arena.first, ARENA_SIZE);
+}
+
 /*****************************************************/
 size_t MemoryAllocator::calcPageSize() const
 {
@@ -47,13 +67,13 @@ void* MemoryAllocator::alloc(size_t pages)
 {
     if (!pages) return nullptr;
 
-#if WIN32
-    LPVOID ptr = VirtualAlloc(nullptr, pages*mPageSize, 
-        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-#else // !WIN32
-    void* ptr = mmap(nullptr, pages*mPageSize, 
-        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-#endif // WIN32
+    void* ptr { nullptr };
+    if (mUseArenas && pages <= mArenaPages)
+    {
+        const LockGuard arenaLock(mArenaMutex);
+        ptr = allocArena(pages, arenaLock);
+    }
+    else ptr = mapDirect(pages*mPageSize);
     MDBG_INFO("(ptr:" << ptr << " pages:" << pages << " bytes:" << pages*mPageSize << ")");
 
 #if DEBUG // sanity checks
@@ -113,13 +133,207 @@ void MemoryAllocator::free(void* const ptr, const size_t pages)
 }
 #endif // DEBUG
 
+    bool inArena { false };
+    if (mUseArenas && pages <= mArenaPages)
+    {
+        const LockGuard arenaLock(mArenaMutex);
+        inArena = freeArena(ptr, pages, arenaLock);
+    }
+    if (!inArena) unmapDirect(ptr, pages*mPageSize);
+
+    stats(__func__, pages, false);
+}
+
+/*****************************************************/
+void* MemoryAllocator::mapDirect(const size_t bytes)
+{
 #if WIN32
-    VirtualFree(ptr, pages*mPageSize, MEM_RELEASE);
+    LPVOID ptr = VirtualAlloc(nullptr, bytes, 
+        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
 #else // !WIN32
-    munmap(ptr, pages*mPageSize);
+    void* ptr = mmap(nullptr, bytes, 
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+#ifdef MADV_HUGEPAGE
+    if (ptr != MAP_FAILED && mHugePages && bytes >= ARENA_SIZE)
+        madvise(ptr, bytes, MADV_HUGEPAGE); // just a hint
+#endif // MADV_HUGEPAGE
 #endif // WIN32
+    return ptr;
+}
 
-    stats(__func__, pages, false);
+/*****************************************************/
+void MemoryAllocator::unmapDirect(void* const ptr, const size_t bytes)
+{
+#if WIN32
+    VirtualFree(ptr, bytes, MEM_RELEASE);
+#else // !WIN32
+    munmap(ptr, bytes);
+#endif // WIN32
+}
+
+/*****************************************************/
+void* MemoryAllocator::allocArena(const size_t pages, const LockGuard& arenaLock)
+{
+    // first-fit in address order to keep the used arenas packed
+    for (ArenaMap::value_type& arena : mArenas)
+    {
+        if (arena.second.mFreePages < pages) continue;
+
+        const size_t page { findFree(arena.second, pages) };
+        if (page < mArenaPages)
+        {
+            setUsed(arena.second, page, pages, true);
+            arena.second.mFreePages -= pages;
+            return arena.first + page*mPageSize;
+        }
+    }
+
+    uint8_t* const base { mapArena(arenaLock) };
+    if (base == nullptr) throw std::bad_alloc();
+
+    Arena& arena { mArenas.emplace(base, Arena{ 
+        std::vector<uint64_t>((mArenaPages+63)/64), mArenaPages }).first->second };
+
+    setUsed(arena, 0, pages, true);
+    arena.mFreePages -= pages;
+    return base;
+}
+
+/*****************************************************/
+uint8_t* MemoryAllocator::mapArena(const LockGuard& arenaLock)
+{
+#if WIN32
+    return nullptr; // not supported
+#else // !WIN32
+
+#ifdef MAP_HUGETLB
+    if (mHugeTLB)
+    {
+        // huge page mappings are always aligned, fails if none are reserved
+        void* const ptr { mmap(nullptr, ARENA_SIZE, PROT_READ | PROT_WRITE, 
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0) };
+        if (ptr != MAP_FAILED)
+        {
+            MDBG_INFO("... hugetlb arena:" << ptr << " arenas:" << mArenas.size()+1);
+            return static_cast<uint8_t*>(ptr);
+        }
+        MDBG_INFO("... MAP_HUGETLB failed, using THP");
+    }
+#endif // MAP_HUGETLB
+
+    // map twice the size, then trim to get the alignment
+    void* const ptr { mmap(nullptr, 2*ARENA_SIZE, PROT_READ | PROT_WRITE, 
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) };
+    if (ptr == MAP_FAILED) { MDBG_ERROR("... mmap failed"); return nullptr; }
+
+    uint8_t* const start { static_cast<uint8_t*>(ptr) };
+    const size_t offset { reinterpret_cast<uintptr_t>(start) % ARENA_SIZE }; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    uint8_t* const base { offset ? start + (ARENA_SIZE-offset) : start };
+
+    if (base > start) munmap(start, static_cast<size_t>(base-start));
+    uint8_t* const end { start + 2*ARENA_SIZE };
+    if (end > base+ARENA_SIZE) munmap(base+ARENA_SIZE, static_cast<size_t>(end-(base+ARENA_SIZE)));
+
+#ifdef MADV_HUGEPAGE
+    if (mHugePages) madvise(base, ARENA_SIZE, MADV_HUGEPAGE); // just a hint
+#endif // MADV_HUGEPAGE
+
+    MDBG_INFO("... arena:" << static_cast<void*>(base) << " arenas:" << mArenas.size()+1);
+    return base;
+#endif // WIN32
+}
+
+/*****************************************************/
+bool MemoryAllocator::freeArena(void* const ptr, const size_t pages, const LockGuard& arenaLock)
+{
+    uint8_t* const ptrFree { static_cast<uint8_t*>(ptr) };
+
+    ArenaMap::iterator it { mArenas.upper_bound(ptrFree) }; // first base > ptr
+    if (it == mArenas.begin()) return false;
+    --it; if (ptrFree >= it->first + ARENA_SIZE) return false;
+
+    Arena& arena { it->second };
+    setUsed(arena, static_cast<size_t>(ptrFree-it->first)/mPageSize, pages, false);
+    arena.mFreePages += pages;
+
+    if (arena.mFreePages == mArenaPages)
+    {
+        MDBG_INFO("... unmap empty arena:" << static_cast<void*>(it->first) << " arenas:" << mArenas.size()-1);
+        unmapDirect(it->first, ARENA_SIZE);
+        mArenas.erase(it);
+    }
+#if !WIN32
+    // release the memory, but not with huge pages (would split them)
+    else if (!mHugePages)
+        madvise(ptr, pages*mPageSize, MADV_DONTNEED);
+#endif // !WIN32
+
+    return true;
+}
+
+/*****************************************************/
+void MemoryAllocator::setUsed(Arena& arena, const size_t page, const size_t count, const bool used)
+{
+    for (size_t cur { page }; cur < page+count; ++cur)
+    {
+        const uint64_t bit { static_cast<uint64_t>(1) << (cur % 64) };
+        if (used) arena.mUsed[cur/64] |= bit;
+        else arena.mUsed[cur/64] &= ~bit;
+    }
+}
+
+/*****************************************************/
+size_t MemoryAllocator::findFree(const Arena& arena, const size_t count) const
+{
+    size_t run { 0 };
+    for (size_t page { 0 }; page < mArenaPages; ++page)
+    {
+        const uint64_t word { arena.mUsed[page/64] };
+        if (!(page % 64) && word == ~static_cast<uint64_t>(0))
+            { run = 0; page += 63; continue; } // skip full words
+
+        if ((word >> (page % 64)) & 1) run = 0;
+        else if (++run == count) return page+1-count;
+    }
+    return mArenaPages;
+}
+
+namespace { // anonymous
+
+/** Returns the number of lines in the given file, 0 if it can't be read */
+size_t CountLines(const char* const path)
+{
+    std::ifstream file(path);
+    size_t lines { 0 };
+    for (std::string line; std::getline(file, line); ) ++lines;
+    return lines;
+}
+
+} // namespace
+
+/*****************************************************/
+MemoryAllocator::OSStats MemoryAllocator::GetOSStats() const
+{
+    OSStats osStats { };
+    { // lock scope
+        const LockGuard arenaLock(mArenaMutex);
+        osStats.arenas = mArenas.size();
+        osStats.arenaBytes = mArenas.size()*ARENA_SIZE;
+        for (const ArenaMap::value_type& arena : mArenas)
+            osStats.arenaFree += arena.second.mFreePages*mPageSize;
+    }
+
+#if LINUX
+    osStats.vmaCount = CountLines("/proc/self/maps");
+
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages { 0 }, residentPages { 0 };
+    if (statm >> totalPages >> residentPages)
+        osStats.rssBytes = residentPages*static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif // LINUX
+
+    return osStats;
 }
 
 /*****************************************************/
@@ -6,6 +6,7 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "andromeda/common.hpp"
 #include "andromeda/Debug.hpp"
@@ -16,6 +17,11 @@ namespace Filedata {
 
 /**
  * A raw, non-caching memory allocator that allocates pages directly from the OS, bypassing the C library.
+ * In DIRECT mode, each allocation is its own OS mapping.  Otherwise allocations are carved out of
+ * 2MB-aligned arenas using a bitmap of used pages (partial frees are simple), which greatly reduces
+ * the number of mappings (VMAs) and allows using huge pages (fewer TLB misses). Arenas are returned
+ * to the OS only once empty, so freed pages in a used arena are fragmentation (see GetOSStats).
+ * Arenas are not supported on Windows, which always uses DIRECT.
  * In DEBUG builds, verifies all calls to free() for validity.
  * THREAD SAFE (INTERNAL LOCKS)
  */
@@ -23,13 +29,14 @@ class MemoryAllocator
 {
 public:
 
-    explicit MemoryAllocator();
+    /** 
+     * @param useArenas if true, carve allocations out of arenas rather than DIRECT
+     * @param hugePages if true (and using arenas), ask the OS to back arenas with transparent huge pages
+     * @param hugeTLB if true (and hugePages), back arenas with reserved huge pages (MAP_HUGETLB) if available
+     */
+    explicit MemoryAllocator(bool useArenas = false, bool hugePages = false, bool hugeTLB = false);
 
-#if DEBUG // sanity checks
     virtual ~MemoryAllocator();
-#else // !DEBUG
-    virtual ~MemoryAllocator() = default;
-#endif // DEBUG
     DELETE_COPY(MemoryAllocator)
     DELETE_MOVE(MemoryAllocator)
 
@@ -54,6 +61,23 @@ public:
     [[nodiscard]] inline size_t getNumBytes(const size_t bytes) const {
         return getNumPages(bytes)*getPageSize(); }
 
+    /** Memory statistics for debugging */
+    struct OSStats
+    {
+        /** The number of arenas mapped */
+        size_t arenas;
+        /** The total bytes of arenas mapped */
+        size_t arenaBytes;
+        /** The bytes within arenas not allocated (fragmentation) */
+        size_t arenaFree;
+        /** The number of memory mappings in the whole process (0 if unknown) */
+        size_t vmaCount;
+        /** The resident memory of the whole process (0 if unknown) */
+        size_t rssBytes;
+    };
+    /** Returns memory statistics for debugging - reads the process's info from the OS */
+    OSStats GetOSStats() const;
+
 protected:
 
     /** The minimum size of OS memory mappings */
@@ -64,9 +88,65 @@ private:
     /** Ask the OS for the page granularity */
     [[nodiscard]] size_t calcPageSize() const;
 
+    /** The size and alignment of arenas */
+    static constexpr size_t ARENA_SIZE { static_cast<size_t>(2)*1024*1024 };
+
+    /** A region of memory that allocations are carved out of */
+    struct Arena
+    {
+        /** Bitmap with a bit set for each used page */
+        std::vector<uint64_t> mUsed;
+        /** The number of pages not in use */
+        size_t mFreePages;
+    };
+
+    using LockGuard = std::lock_guard<std::mutex>;
+
+    /** Maps the given number of bytes directly from the OS */
+    [[nodiscard]] void* mapDirect(size_t bytes);
+
+    /** Returns the given direct mapping to the OS */
+    void unmapDirect(void* ptr, size_t bytes);
+
+    /** 
+     * Allocates the given number of pages (<= mArenaPages) from an arena, mapping a new arena if needed
+     * @throws std::bad_alloc if mapping a new arena fails
+     */
+    [[nodiscard]] void* allocArena(size_t pages, const LockGuard& arenaLock);
+
+    /** Maps a new empty ARENA_SIZE-aligned arena from the OS, returns nullptr on failure */
+    [[nodiscard]] uint8_t* mapArena(const LockGuard& arenaLock);
+
+    /** 
+     * Frees the given pages if they are in an arena, returning the arena to the OS if it's now empty
+     * @return true if the pages were in an arena, false if they were mapped directly
+     */
+    bool freeArena(void* ptr, size_t pages, const LockGuard& arenaLock);
+
+    /** Sets or clears the used bits for count# pages starting at the given page in the arena */
+    static void setUsed(Arena& arena, size_t page, size_t count, bool used);
+
+    /** Returns the first page index of a free run of count# pages in the arena, or mArenaPages if none */
+    [[nodiscard]] size_t findFree(const Arena& arena, size_t count) const;
+
     /** Updates and prints allocator statistics (debug) */
     void stats(const char* fname, size_t pages, bool alloc);
 
+    /** True if allocations are carved out of arenas */
+    const bool mUseArenas;
+    /** True if arenas are backed by transparent huge pages */
+    const bool mHugePages;
+    /** True if arenas are backed by reserved huge pages if available */
+    const bool mHugeTLB;
+    /** The number of pages in each arena */
+    const size_t mArenaPages;
+
+    /** Map of arena base address to arena */
+    using ArenaMap = std::map<uint8_t*, Arena>;
+    ArenaMap mArenas;
+    /** Mutex that protects mArenas */
+    mutable std::mutex mArenaMutex;
+
 #if DEBUG // sanity checks
     using AllocMap = std::map<void*, size_t, std::greater<>>;
     /** Map of all allocations for verifying frees */
@@ -84,7 +164,6 @@ private:
     /** stat-counter mutex */
     std::mutex mMutex;
 
-    using LockGuard = std::lock_guard<std::mutex>;
     mutable Debug mDebug;
 };
 
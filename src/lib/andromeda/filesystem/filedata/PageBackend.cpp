@@ -1,15 +1,17 @@
 
 #include <cassert>
 #include <cstring>
-#include <memory>
+#include <optional>
 #include "nlohmann/json.hpp"
 
+#include "CacheManager.hpp"
+#include "DiskCache.hpp"
 #include "Page.hpp"
 #include "PageBackend.hpp"
 
 #include "andromeda/backend/BackendImpl.hpp"
 #include "andromeda/backend/RunnerInput.hpp"
-using Andromeda::Backend::WriteFunc;
+using Andromeda::Backend::WriteSpanFunc;
 #include "andromeda/filesystem/File.hpp"
 #include "andromeda/filesystem/Folder.hpp"
 
@@ -25,7 +27,13 @@ PageBackend::PageBackend(File& file, const std::string& fileID, uint64_t backend
     mFile(file),
     mFileID(fileID),
     mBackend(file.GetBackend()),
-    mDebug(__func__,this) { }
+    mDebug(__func__,this)
+{
+    CacheManager* const cacheMgr { mBackend.GetCacheManager() };
+    if (cacheMgr && !mBackend.isMemory())
+        mDiskCache = cacheMgr->GetDiskCache();
+    if (mDiskCache) mBackendName = mBackend.GetName(false);
+}
 
 /*****************************************************/
 PageBackend::PageBackend(File& file, const std::string& fileID, const size_t pageSize, 
@@ -38,7 +46,46 @@ PageBackend::PageBackend(File& file, const std::string& fileID, const size_t pag
     mFile(file),
     mFileID(fileID),
     mBackend(file.GetBackend()),
-    mDebug(__func__,this) { }
+    mDebug(__func__,this)
+{
+    CacheManager* const cacheMgr { mBackend.GetCacheManager() };
+    if (cacheMgr && !mBackend.isMemory())
+        mDiskCache = cacheMgr->GetDiskCache();
+    if (mDiskCache) mBackendName = mBackend.GetName(false);
+}
+
+/*****************************************************/
+DiskCache::Version PageBackend::GetDiskVersion(const SharedLock& thisLock) const
+{
+    // the local modified time changes with dirty writes, the backend data doesn't until flushed
+    return { mBackendSize, mFile.GetBackendModified(thisLock), mPageSize };
+}
+
+/*****************************************************/
+size_t PageBackend::FetchCachedPages(const uint64_t index, const size_t count, 
+    const PageBackend::PageHandler& pageHandler, const SharedLock& thisLock)
+{
+    if (!mDiskCache || !mBackendExists) return 0;
+
+    const DiskCache::Version version { GetDiskVersion(thisLock) };
+
+    size_t readCount { 0 };
+    for (; readCount < count; ++readCount)
+    {
+        const uint64_t curIndex { index+readCount };
+        const uint64_t curPageStart { curIndex*mPageSize };
+        if (curPageStart >= mBackendSize) break;
+
+        const size_t pageSize { min64st(mBackendSize-curPageStart, mPageSize) };
+        Page page(pageSize, mBackend.GetPageAllocator());
+
+        if (!mDiskCache->ReadPage(mBackendName, mFileID, curIndex, version, page)) break;
+        pageHandler(curIndex, std::move(page));
+    }
+
+    MDBG_INFO("(index:" << index << " count:" << count << ") readCount:" << readCount);
+    return readCount;
+}
 
 /*****************************************************/
 size_t PageBackend::FetchPages(const uint64_t index, const size_t count, 
@@ -56,7 +103,8 @@ size_t PageBackend::FetchPages(const uint64_t index, const size_t count,
     MDBG_INFO("... pageStart:" << pageStart << " readSize:" << readSize);
 
     uint64_t curIndex { index };
-    std::unique_ptr<Page> curPage;
+    std::optional<Page> curPage; // the page being received into
+    const DiskCache::Version diskVersion { GetDiskVersion(thisLock) };
 
     const char* const fname { __func__ }; // for lambda
     mBackend.ReadFile(mFileID, pageStart, readSize, 
@@ -68,7 +116,7 @@ size_t PageBackend::FetchPages(const uint64_t index, const size_t count,
             const uint64_t curPageStart { curIndex*mPageSize };
             const size_t pageSize { min64st(mBackendSize-curPageStart, mPageSize) };
 
-            if (!curPage) curPage = std::make_unique<Page>(pageSize, mBackend.GetPageAllocator());
+            if (!curPage) curPage.emplace(pageSize, mBackend.GetPageAllocator());
 
             const uint64_t rindex { rbyte / mPageSize }; // page index for this data
             const size_t pwOffset { static_cast<size_t>(rbyte - rindex*mPageSize) }; // offset within the page
@@ -84,6 +132,8 @@ size_t PageBackend::FetchPages(const uint64_t index, const size_t count,
                     mDebug.Info([&](std::ostream& str){ str << fname 
                         << "... pageHandler(curIndex:" << curIndex << ")"; });
 
+                    if (mDiskCache) mDiskCache->StorePage(mBackendName, mFileID, curIndex, diskVersion, *curPage);
+
                     pageHandler(curIndex, std::move(*curPage));
                     curPage.reset(); ++curIndex;
                 }
@@ -95,11 +145,40 @@ size_t PageBackend::FetchPages(const uint64_t index, const size_t count,
         }
     });
 
-    if (curPage != nullptr) { MDBG_ERROR("() ERROR unfinished read!"); assert(false); }
+    if (curPage) { MDBG_ERROR("() ERROR unfinished read!"); assert(false); }
 
     return readSize;
 }
 
+/*****************************************************/
+bool PageBackend::CanFetchDirect(const uint64_t index, const size_t length, const SharedLock& thisLock) const
+{
+    const uint64_t pageStart { index*mPageSize }; // offset of the page start
+    return !mDiskCache && mBackendExists && length && length <= mPageSize && pageStart+length <= mBackendSize;
+}
+
+/*****************************************************/
+void PageBackend::FetchDirect(const uint64_t index, char* const buffer, const size_t length, 
+    const PageBackend::PageHandler& pageHandler, const SharedLock& thisLock)
+{
+    MDBG_INFO("(index:" << index << " length:" << length << ")");
+
+    if (!CanFetchDirect(index, length, thisLock)) { MDBG_ERROR("() ERROR invalid index:" << index 
+        << " length:" << length << " mBackendSize:" << mBackendSize); assert(false); return; }
+
+    // the backend bounds-checks the received offsets, so each chunk is copied straight to both places
+    // while it is still hot, rather than into the page and then out of it again
+    Page page(length, mBackend.GetPageAllocator());
+    mBackend.ReadFile(mFileID, index*mPageSize, length, 
+        [&](const size_t roffset, const char* rbuf, const size_t rlength)->void
+    {
+        std::memcpy(page.data()+roffset, rbuf, rlength);
+        std::memcpy(buffer+roffset, rbuf, rlength);
+    });
+
+    pageHandler(index, std::move(page));
+}
+
 /*****************************************************/
 size_t PageBackend::FlushPageList(const uint64_t index, const PageBackend::PagePtrList& pages, const SharedLockW& thisLock)
 {
@@ -107,12 +186,7 @@ size_t PageBackend::FlushPageList(const uint64_t index, const PageBackend::PageP
 
     if (pages.empty()) { MDBG_ERROR("() ERROR empty list!"); assert(false); return 0; }
 
-    size_t totalSize { 0 };
-    for (const Page* pagePtr : pages)
-        totalSize += pagePtr->size();
-
     const uint64_t writeStart { index*mPageSize };
-    MDBG_INFO("... WRITING " << totalSize << " to " << writeStart);
 
     const FSConfig::WriteMode writeMode { mFile.GetWriteMode() };
     if (writeMode == FSConfig::WriteMode::UPLOAD && mBackendExists)
@@ -127,36 +201,63 @@ size_t PageBackend::FlushPageList(const uint64_t index, const PageBackend::PageP
         FlushCreate(thisLock); // can't use Upload() w/o first page
     }
 
-    const WriteFunc writeFunc { [&](const size_t offset, char* const buf, const size_t buflen, size_t& written)->bool
-    {
-        written = 0; // in case of early return
-        const size_t pagesIdx { offset/mPageSize };
-        if (pagesIdx >= pages.size()) return false;
-
-        const Page& page { *pages[pagesIdx] };
-        const size_t pageOffset { offset - pagesIdx*mPageSize };
-        const size_t pageSize { page.size() };
-        if (pageOffset >= pageSize) return false;
-
-        const char* copyData { page.data()+pageOffset };
-        written = std::min(pageSize-pageOffset,buflen);
-        std::copy(copyData, copyData+written, buf); 
-        return true; // initial check will catch when we're done
-    }};
-
+    size_t totalSize { 0 };
     if (!mBackendExists)
     {
+        for (const Page* pagePtr : pages)
+            totalSize += pagePtr->size();
+        MDBG_INFO("... UPLOADING " << totalSize);
+
         const bool oneshot { mFile.GetWriteMode() < FSConfig::WriteMode::APPEND };
-        mFile.Refresh(mUploadFunc(mFile.GetName(thisLock),writeFunc,oneshot),thisLock);
+        mFile.Refresh(mUploadFunc(mFile.GetName(thisLock),GetWriteSpanFunc(pages),oneshot),thisLock);
         mBackendExists = true;
     }
-    else mBackend.WriteFile(mFileID, writeStart, writeFunc);
+    else totalSize = WritePageList(index, pages, thisLock);
+
+    ExtendBackendSize(writeStart+totalSize, thisLock);
+
+    return totalSize;
+}
+
+/*****************************************************/
+size_t PageBackend::WritePageList(const uint64_t index, const PageBackend::PagePtrList& pages, const SharedLockW& thisLock) const
+{
+    if (pages.empty() || !mBackendExists) { MDBG_ERROR("() ERROR invalid write!"); assert(false); return 0; }
+
+    size_t totalSize { 0 };
+    for (const Page* pagePtr : pages)
+        totalSize += pagePtr->size();
 
-    mBackendSize = std::max(mBackendSize, writeStart+totalSize);
+    const uint64_t writeStart { index*mPageSize };
+    MDBG_INFO("... WRITING " << totalSize << " to " << writeStart);
+
+    // cached pages for this range are now outdated
+    if (mDiskCache) mDiskCache->RemovePages(mBackendName, mFileID, index, pages.size());
+    mBackend.WriteFile(mFileID, writeStart, GetWriteSpanFunc(pages));
 
     return totalSize;
 }
 
+/*****************************************************/
+WriteSpanFunc PageBackend::GetWriteSpanFunc(const PageBackend::PagePtrList& pages) const
+{
+    return [&pages,pageSize=mPageSize](const size_t offset, const size_t buflen, const char*& buf, size_t& written)->bool
+    {
+        written = 0; // in case of early return
+        const size_t pagesIdx { offset/pageSize };
+        if (pagesIdx >= pages.size()) return false;
+
+        const Page& page { *pages[pagesIdx] };
+        const size_t pageOffset { offset - pagesIdx*pageSize };
+        const size_t pageLength { page.size() };
+        if (pageOffset >= pageLength) return false;
+
+        buf = page.data()+pageOffset; // no copy
+        written = std::min(pageLength-pageOffset,buflen);
+        return true; // initial check will catch when we're done
+    };
+}
+
 /*****************************************************/
 void PageBackend::FlushCreate(const SharedLockW& thisLock)
 {
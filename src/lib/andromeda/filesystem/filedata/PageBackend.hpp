@@ -2,10 +2,13 @@
 #ifndef LIBA2_PAGEBACKEND_H_
 #define LIBA2_PAGEBACKEND_H_
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <string>
 
+#include "DiskCache.hpp"
 #include "andromeda/common.hpp"
 #include "andromeda/Debug.hpp"
 #include "andromeda/SharedMutex.hpp"
@@ -66,6 +69,9 @@ public:
     /** Inform us that the size on the backend has changed */
     void SetBackendSize(uint64_t backendSize, const SharedLockW& thisLock) { mBackendSize = backendSize; }
 
+    /** Inform us that the backend size was extended by a write (see WritePageList) */
+    void ExtendBackendSize(uint64_t backendSize, const SharedLockW& thisLock) { mBackendSize = std::max(mBackendSize, backendSize); }
+
     /** Callback used to process fetched pages in FetchPages() */
     using PageHandler = std::function<void (const uint64_t, Page&&)>;
 
@@ -79,6 +85,31 @@ public:
      */
     size_t FetchPages(uint64_t index, size_t count, const PageHandler& pageHandler, const SharedLock& thisLock);
 
+    /**
+     * Returns true if the given whole page can be read with FetchDirect()
+     * Only if the page is entirely within the backend and the disk cache is not enabled (it must be checked first)
+     */
+    [[nodiscard]] bool CanFetchDirect(uint64_t index, size_t length, const SharedLock& thisLock) const;
+
+    /**
+     * Reads a single whole page from the backend into both a new page and the caller's buffer (see CanFetchDirect)
+     * @param index the page index to read
+     * @param buffer the buffer to also read into
+     * @param length the size of the page in bytes
+     * @param pageHandler callback for handling the constructed page, once the read is done
+     * @throws BackendException for backend issues
+     */
+    void FetchDirect(uint64_t index, char* buffer, size_t length, const PageHandler& pageHandler, const SharedLock& thisLock);
+
+    /** 
+     * Reads consecutive pages from the disk cache (if enabled), stopping at the first miss
+     * @param index the page index to start from
+     * @param count the max number of pages to read
+     * @param pageHandler callback for handling constructed pages
+     * @return the number of pages read from the disk cache
+     */
+    size_t FetchCachedPages(uint64_t index, size_t count, const PageHandler& pageHandler, const SharedLock& thisLock);
+
     /** Vector of **consecutive** non-null page pointers */
     using PagePtrList = std::vector<Page*>;
 
@@ -92,6 +123,17 @@ public:
      */
     size_t FlushPageList(uint64_t index, const PagePtrList& pages, const SharedLockW& thisLock);
 
+    /** 
+     * Writes a series of **consecutive** pages to a file that already exists (must mBackendExists!)
+     * Does not modify any members, so multiple runs can be written concurrently under one thisLock.
+     * The caller must ExtendBackendSize() with the returned range afterwards.
+     * @param index the starting index of the page list
+     * @param pages list of pages to write - must NOT be empty
+     * @return the total number of bytes written to the backend
+     * @throws BackendException for backend issues
+     */
+    size_t WritePageList(uint64_t index, const PagePtrList& pages, const SharedLockW& thisLock) const;
+
     /** 
      * Creates the file on the backend if not mBackendExists and feeds to file.Refresh()
      * @throws BackendException for backend issues
@@ -106,6 +148,15 @@ public:
 
 private:
 
+    /** 
+     * Returns a WriteSpanFunc that provides the given page list's data in place (must outlive the function)
+     * The pages are pinned while sending by the caller's exclusive thisLock, so there is no copy
+     */
+    Backend::WriteSpanFunc GetWriteSpanFunc(const PagePtrList& pages) const;
+
+    /** Returns the backend version of the file for the disk cache */
+    DiskCache::Version GetDiskVersion(const SharedLock& thisLock) const;
+
     /** The size of each page - see description in ConfigOptions */
     const size_t mPageSize;
     /** The file size as far as the backend knows (0 if it doesn't exist) */
@@ -124,6 +175,10 @@ private:
     const std::string& mFileID;
     /** Reference to the file's backend */
     Backend::BackendImpl& mBackend;
+    /** Pointer to the on-disk page cache (null if disabled) */
+    DiskCache* mDiskCache { nullptr };
+    /** The backend's name for the disk cache, file IDs are only unique per backend */
+    std::string mBackendName;
 
     mutable Debug mDebug;
 };
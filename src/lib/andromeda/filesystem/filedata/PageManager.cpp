@@ -1,14 +1,20 @@
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <future>
 #include <limits>
+#include <list>
+#include <system_error>
 #include <utility>
+#include <vector>
 
 #include "CacheManager.hpp"
 #include "Page.hpp"
 #include "PageManager.hpp"
 #include "andromeda/BaseException.hpp"
+#include "andromeda/ConfigOptions.hpp"
 #include "andromeda/StringUtil.hpp"
 #include "andromeda/backend/BackendException.hpp"
 using Andromeda::Backend::BackendException;
@@ -42,8 +48,9 @@ PageManager::~PageManager()
 
     const Item::DeleteLock deleteLock(mScopeMutex); // exclusive
 
-    // once we have the deleteLock, no NEW fetch threads can start, wait for existing
-    const std::unique_lock<std::shared_mutex> fetchLock(mFetchMutex);
+    // once we have the deleteLock, no NEW fetches can start, 
+    // cancel any queued and wait for existing to finish
+    mBackend.CancelAsync(this);
 
     if (mCacheMgr != nullptr)
     {
@@ -61,13 +68,91 @@ void PageManager::ReadPage(char* buffer, const uint64_t index, const size_t offs
 
     if (index*mPageSize + offset+length > mFileSize) { MDBG_ERROR("... invalid read!"); assert(false); }
 
+    // a whole page that is not cached can be received straight into the buffer too
+    if (!offset && GetPageHint(index) == nullptr && 
+        TryReadDirect(buffer, index, length, thisLock)) return;
+
+    std::memcpy(buffer, ReadPageRef(index, offset, length, thisLock), length);
+}
+
+/*****************************************************/
+const char* PageManager::ReadPageRef(const uint64_t index, const size_t offset, const size_t length, const SharedLock& thisLock)
+{
+    if (index*mPageSize + offset+length > mFileSize) { MDBG_ERROR("... invalid read!"); assert(false); }
+
     const Page& page { GetPageRead(index, thisLock) };
+    return page.data()+offset;
+}
 
-    std::memcpy(buffer, page.data()+offset, length);
+/*****************************************************/
+bool PageManager::TryReadDirect(char* buffer, const uint64_t index, const size_t length, const SharedLock& thisLock)
+{
+    const uint64_t pageStart { index*mPageSize }; // offset of the page start
+    if (length != min64st(mFileSize-pageStart, mPageSize)) return false; // not a whole page
+
+    if (!mPageBackend.CanFetchDirect(index, length, thisLock)) return false;
+
+    { const UniqueLock pagesLock(mPagesMutex);
+        // if the fetch would include other pages (read-ahead), let a job do it (see StartFetch)
+        if (isFetchPending(index, pagesLock) || 
+            GetFetchSize(index, thisLock, pagesLock) != 1) return false;
+
+        mFailedPages.erase(index, index+1); // reset failures
+        mPendingPages.insert(index, index+1, true); // other readers wait for us
+    }
+
+    MDBG_INFO("(" << mFile.GetName(thisLock) << ")" << " (index:" << index << " length:" << length << ")");
+
+    const std::chrono::steady_clock::time_point timeStart { std::chrono::steady_clock::now() };
+    try
+    {
+        mPageBackend.FetchDirect(index, buffer, length, [&](const uint64_t pageIndex, Page&& page)
+        {
+            const UniqueLock pagesLock(mPagesMutex);
+            const PageMap::iterator newIt { mPages.emplace(pageIndex, std::move(page)).first };
+
+            // hold pagesLock because if inform fails, the page is removed
+            try { InformNewPageRead(pageIndex, newIt->second, false, true, pagesLock);
+                SetPageHint(pageIndex, newIt->second); }
+            catch (const CacheManager::MemoryException& ex) 
+            { // the caller has the data anyway, but others waiting on the page don't
+                MDBG_INFO("... not caching: " << ex.what());
+                mFailedPages.insert(pageIndex, pageIndex+1, std::current_exception());
+            }
+
+            RemovePendingFetch(pageIndex, 1, pagesLock);
+        }, thisLock);
+    }
+    catch (const BackendException& ex)
+    {
+        MDBG_ERROR("... " << ex.what());
+        const UniqueLock pagesLock(mPagesMutex);
+        mFailedPages.insert(index, index+1, std::current_exception());
+        RemovePendingFetch(index, 1, pagesLock);
+        throw;
+    }
+
+    if (length >= mPageSize) // don't consider small reads
+        UpdateBandwidth(length, std::chrono::steady_clock::now()-timeStart);
+    if (mCacheMgr && !mBackend.isMemory())
+        mCacheMgr->CountRead(false);
+
+    MDBG_INFO("... read direct");
+    return true;
 }
 
 /*****************************************************/
 void PageManager::WritePage(const char* buffer, const uint64_t index, const size_t offset, const size_t length, const SharedLockW& thisLock)
+{
+    WritePage([&](char* const pageBuf, const size_t pageLength)->size_t
+    {
+        std::memcpy(pageBuf, buffer, pageLength);
+        return pageLength;
+    }, index, offset, length, thisLock);
+}
+
+/*****************************************************/
+size_t PageManager::WritePage(const File::WriteRefFunc& func, const uint64_t index, const size_t offset, const size_t length, const SharedLockW& thisLock)
 {
     MDBG_INFO("(" << mFile.GetName(thisLock) << ")" << " (index:" << index << " offset:" << offset << " length:" << length << ")");
 
@@ -81,10 +166,38 @@ void PageManager::WritePage(const char* buffer, const uint64_t index, const size
 
     // mDirty is set LAST since GetPageWrite() may cause a synchronous flush
     Page& page { GetPageWrite(index, pageSize, partial, thisLock) };
-    mFileSize = newFileSize; // extend file
+
+    size_t filled { 0 }; // new pages are zeroed so nothing stale is exposed
+    try { filled = std::min(func(page.data()+offset, length), length); }
+    catch (...) { AbortPageWrite(index, thisLock); throw; }
+
+    if (!filled) { AbortPageWrite(index, thisLock); return 0; }
+
+    mFileSize = std::max(mFileSize, pageStart+offset+filled); // extend file
     page.setDirty();
 
-    std::memcpy(page.data()+offset, buffer, length);
+    if (filled < length)
+    {
+        MDBG_INFO("... short fill:" << filled);
+        ResizePages(thisLock); // shrink to what was filled
+    }
+    return filled;
+}
+
+/*****************************************************/
+void PageManager::AbortPageWrite(const uint64_t index, const SharedLockW& thisLock)
+{
+    MDBG_INFO("(index:" << index << ")");
+
+    const PageMap::iterator pageIt { mPages.find(index) };
+    if (pageIt != mPages.end() && !pageIt->second.isDirty())
+    {
+        if (mCacheMgr) mCacheMgr->RemovePage(pageIt->second);
+        ClearPageHint(index);
+        mPages.erase(pageIt);
+    }
+
+    ResizePages(thisLock); // undo any extending
 }
 
 /*****************************************************/
@@ -94,6 +207,17 @@ const Page& PageManager::GetPageRead(const uint64_t index, const SharedLock& thi
 
     if (index*mPageSize >= mFileSize) { MDBG_ERROR("... invalid read!"); assert(false); }
 
+    if (const Page* const fastPage { TryGetPageFast(index, thisLock) })
+    {
+        MDBG_INFO("... return hinted page");
+        if (mCacheMgr && !mBackend.isMemory()) 
+        {
+            mCacheMgr->CountRead(true);
+            mCacheMgr->InformPage(*this, index, *fastPage, false);
+        }
+        return *fastPage;
+    }
+
     UniqueLock pagesLock(mPagesMutex);
 
     { const PageMap::const_iterator it { mPages.find(index) };
@@ -103,9 +227,13 @@ const Page& PageManager::GetPageRead(const uint64_t index, const SharedLock& thi
 
         MDBG_INFO("... return existing page");
         const Page& page { it->second };
+        SetPageHint(index, page);
         
         if (mCacheMgr && !mBackend.isMemory()) 
+        {
+            mCacheMgr->CountRead(true);
             mCacheMgr->InformPage(*this, index, page, page.isDirty());
+        }
         return page;
     } }
 
@@ -121,10 +249,17 @@ const Page& PageManager::GetPageRead(const uint64_t index, const SharedLock& thi
             // hold pagesLock because if inform fails, we will remove this page
             // use non-synchronous InformNewPageRead() so holding pagesLock is okay
             InformNewPageRead(index, newPage, false, true, pagesLock);
+            SetPageHint(index, newPage);
             return newPage;
         }
-        else StartFetch(index, fetchSize, pagesLock);
+        else StartFetch(index, fetchSize, FetchPool::Priority::SYNC, pagesLock);
     }
+    // a read-ahead may already be queued for this page, we're waiting on it now
+    else mBackend.PromoteAsync(this);
+
+    { const FetchPool::Stats stats { mBackend.GetFetchPool().GetStats() }; // we're about to wait on the network anyway
+        MDBG_INFO("... fetch pool sync:" << stats.syncJobs << " readahead:" << stats.readAheadJobs 
+            << " active:" << stats.activeJobs << " workers:" << stats.workers << " extra:" << stats.extraWorkers); }
 
     PageMap::const_iterator it;
     std::exception_ptr fail;
@@ -146,10 +281,77 @@ const Page& PageManager::GetPageRead(const uint64_t index, const SharedLock& thi
     const Page& page { it->second };
 
     if (mCacheMgr && !mBackend.isMemory()) 
+    {
+        mCacheMgr->CountRead(false);
         mCacheMgr->InformPage(*this, index, page, page.isDirty());
+    }
+    return page;
+}
+
+/*****************************************************/
+const Page* PageManager::TryGetPageFast(const uint64_t index, const SharedLock& thisLock) const
+{
+    const Page* const page { GetPageHint(index) };
+    if (page == nullptr || page->isDirty()) return nullptr; // dirty only changes with thisLock W
+
+    if (!index) return page; // no DoAdvanceRead() for the first page
+    const uint64_t readEnd { std::min(mFileSize, mPageBackend.GetBackendSize(thisLock)) };
+    for (uint64_t nextIdx { index+1 }; 
+        nextIdx <= index + mBackend.GetOptions().readAheadBuffer; ++nextIdx)
+    {
+        if (nextIdx*mPageSize >= readEnd) break; // nothing to fetch
+        if (GetPageHint(nextIdx) == nullptr) return nullptr; // might need a fetch
+    }
     return page;
 }
 
+/*****************************************************/
+const Page* PageManager::GetPageHint(const uint64_t index) const
+{
+    const PageHint& hint { mPageHints[index % HINT_SLOTS] };
+
+    const uint32_t seq { hint.mSeq.load(std::memory_order_acquire) };
+    if (seq & 1) return nullptr; // being written
+
+    const uint64_t hintIndex { hint.mIndex.load(std::memory_order_relaxed) };
+    const Page* const page { hint.mPage.load(std::memory_order_relaxed) };
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (hint.mSeq.load(std::memory_order_relaxed) != seq) return nullptr; // changed
+
+    return (hintIndex == index) ? page : nullptr;
+}
+
+/*****************************************************/
+void PageManager::SetPageHint(const uint64_t index, const Page& page)
+{
+    PageHint& hint { mPageHints[index % HINT_SLOTS] };
+    if (hint.mIndex.load(std::memory_order_relaxed) == index &&
+        hint.mPage.load(std::memory_order_relaxed) == &page) return; // already set
+
+    const uint32_t seq { hint.mSeq.load(std::memory_order_relaxed) };
+    hint.mSeq.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    hint.mIndex.store(index, std::memory_order_relaxed);
+    hint.mPage.store(&page, std::memory_order_relaxed);
+    hint.mSeq.store(seq+2, std::memory_order_release);
+}
+
+/*****************************************************/
+void PageManager::ClearPageHint(const uint64_t index)
+{
+    PageHint& hint { mPageHints[index % HINT_SLOTS] };
+    if (hint.mIndex.load(std::memory_order_relaxed) != index) return; // not hinted
+
+    const uint32_t seq { hint.mSeq.load(std::memory_order_relaxed) };
+    hint.mSeq.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    hint.mPage.store(nullptr, std::memory_order_relaxed);
+    hint.mSeq.store(seq+2, std::memory_order_release);
+}
+
 /*****************************************************/
 Page& PageManager::GetPageWrite(const uint64_t index, const size_t pageSize, const bool partial, const SharedLockW& thisLock)
 {
@@ -204,6 +406,7 @@ void PageManager::InformNewPageRead(const uint64_t index, const Page& page, bool
     catch (const CacheManager::MemoryException& ex)
     {
         mCacheMgr->RemovePage(page);
+        ClearPageHint(index);
         mPages.erase(index); // undo memory usage
         throw; // rethrow
     }
@@ -217,6 +420,7 @@ void PageManager::InformNewPageWrite(const uint64_t index, const Page& page, boo
     catch (const BaseException& ex) // MemoryException or BackendException
     {
         mCacheMgr->RemovePage(page);
+        ClearPageHint(index);
         mPages.erase(index); // undo memory usage
         throw; // rethrow
     }
@@ -263,40 +467,26 @@ void PageManager::ResizePage(Page& page, const size_t pageSize, bool cacheMgr, c
 /*****************************************************/
 bool PageManager::isFetchPending(const uint64_t index, const UniqueLock& pagesLock)
 {
-    return std::any_of(mPendingPages.cbegin(), mPendingPages.cend(), 
-        [&](const decltype(mPendingPages)::value_type& pend){
-            return index >= pend.first && index < pend.first + pend.second;
-        });
+    return mPendingPages.contains(index);
 }
 
 /*****************************************************/
 std::exception_ptr PageManager::isFetchFailed(const uint64_t index, const UniqueLock& pagesLock)
 {
-    const FailureMap::iterator it { mFailedPages.find(index) };
-    return (it != mFailedPages.end()) ? it->second : nullptr;
+    const FailureMap::const_iterator it { mFailedPages.find(index) };
+    return (it != mFailedPages.cend()) ? it->second.second : nullptr;
 }
 
 /*****************************************************/
-void PageManager::RemovePendingFetch(const uint64_t index, bool idxOnly, const UniqueLock& pagesLock)
+void PageManager::RemovePendingFetch(const uint64_t index, const size_t count, const UniqueLock& pagesLock)
 {
-    MDBG_INFO("(index:" << index << " idxOnly:" << BOOLSTR(idxOnly) << ")");
-
-    for (PendingMap::iterator pend { mPendingPages.begin() }; 
-        pend != mPendingPages.end(); ++pend)
-    {
-        if (index == pend->first)
-        {
-            ++pend->first; // index
-            --pend->second; // count
+    MDBG_INFO("(index:" << index << " count:" << count << ")");
 
-            if (!idxOnly || !pend->second)
-                mPendingPages.erase(pend);
+    if (!mPendingPages.contains(index))
+        { MDBG_ERROR("... page:" << index << " was not pending!"); }
 
-            mPagesCV.notify_all(); return;
-        }
-    }
-
-    MDBG_ERROR("... page:" << index << " was not pending!");
+    mPendingPages.erase(index, index+count);
+    mPagesCV.notify_all();
 }
 
 /*****************************************************/
@@ -329,15 +519,13 @@ size_t PageManager::GetFetchSize(const uint64_t index, const SharedLock& thisLoc
     } }
 
     // stop before the next pending
-    for (size_t curCount { 0 }; curCount < readCount; ++curCount)
+    { const PendingMap::const_iterator pendIt { mPendingPages.first_after(index) };
+    if (pendIt != mPendingPages.cend() && pendIt->first < index+readCount)
     {
-        if (isFetchPending(curCount+index, pagesLock))
-        {
-            MDBG_INFO("... pending page at:" << curCount+index);
-            readCount = curCount;
-            break; // pages are in order
-        }
-    }
+        const uint64_t pendStart { std::max(pendIt->first, index) };
+        MDBG_INFO("... pending page at:" << pendStart);
+        readCount = static_cast<size_t>(pendStart-index);
+    } }
 
     return readCount;
 }
@@ -356,51 +544,70 @@ void PageManager::DoAdvanceRead(const uint64_t index, const SharedLock& thisLock
         if (fetchSize)
         {
             MDBG_INFO("... advance read nextIdx:" << nextIdx << " fetchSize:" << fetchSize);
-            StartFetch(nextIdx, fetchSize, pagesLock);
+            StartFetch(nextIdx, fetchSize, FetchPool::Priority::READAHEAD, pagesLock);
             break; // exit loop
         }
     }
 }
 
 /*****************************************************/
-void PageManager::StartFetch(const uint64_t index, const size_t readCount, const UniqueLock& pagesLock)
+void PageManager::StartFetch(const uint64_t index, const size_t readCount, const FetchPool::Priority priority, const UniqueLock& pagesLock)
 {
-    MDBG_INFO("(index:" << index << ", readCount:" << readCount << ")");
+    MDBG_INFO("(index:" << index << ", readCount:" << readCount << ", priority:" << static_cast<int>(priority) << ")");
+
+    if (mFailedPages.overlaps(index, index+readCount))
+    {
+        MDBG_INFO("... reset failures");
+        mFailedPages.erase(index, index+readCount);
+    }
 
-    mPendingPages.emplace_back(index, readCount);
+    // split large fetches into concurrent ranges, each will use its own backend runner
+    // spread the remainder so that no range is smaller than readCount/splitCount
+    const size_t splitCount { GetFetchSplit(readCount) };
 
-    if (!mFailedPages.empty())
+    uint64_t start { index };
+    for (size_t range { 0 }; range < splitCount; ++range)
     {
-        size_t erased { 0 };
-        for (uint64_t idx { index }; idx < index+readCount; ++idx)
-            erased += mFailedPages.erase(idx);
-        if (erased) MDBG_INFO("... reset " << erased << " failures");
+        const size_t count { readCount/splitCount + ((range < readCount%splitCount) ? 1 : 0) };
+        mPendingPages.insert(start, start+count, true);
+
+        // only the first range is needed now, the rest are effectively read-ahead
+        const FetchPool::Priority rangePriority { (start == index) ? priority : FetchPool::Priority::READAHEAD };
+        mBackend.AddAsync(this, rangePriority, [this,start,count,splitCount](){ FetchPages(start, count, splitCount); });
+        start += count;
     }
+}
+
+/*****************************************************/
+size_t PageManager::GetFetchSplit(const size_t readCount) const
+{
+    const ConfigOptions& options { mBackend.GetOptions() };
+    if (options.runnerPoolSize <= 1 || !options.readSplitSize) return 1;
+
+    // each range must be at least readSplitSize, rounded up to whole pages
+    const size_t minPages { (options.readSplitSize + mPageSize - 1) / mPageSize };
+    const size_t splitCount { std::min(options.runnerPoolSize, readCount / minPages) };
 
-    std::thread(&PageManager::FetchPages, this, index, readCount).detach();
+    if (splitCount > 1) { MDBG_INFO("(readCount:" << readCount << ") splitCount:" << splitCount); }
+    return std::max(splitCount, static_cast<size_t>(1));
 }
 
 /*****************************************************/
-void PageManager::FetchPages(const uint64_t index, const size_t count) noexcept // thread cannot throw
+void PageManager::FetchPages(const uint64_t index, const size_t count, const size_t splitCount) noexcept // job cannot throw
 {
     // use a read-priority lock since the caller is waiting on us, 
     // if another write happens in the middle we would deadlock
+    // the destructor waits for us to finish via mBackend.CancelAsync()
     const SharedLockRP thisLock { GetReadPriLock() };
 
-    // lock fetch mutex so the destructor has to wait for us to finish
-    // can't acquire the scope lock here because the destructor could already be waiting!
-    const std::shared_lock<std::shared_mutex> fetchLock(mFetchMutex);
-
     uint64_t curIndex { index }; try
     {
-        MDBG_INFO("(index:" << index << " count:" << count << ")");
-        const std::chrono::steady_clock::time_point timeStart { std::chrono::steady_clock::now() };
+        MDBG_INFO("(index:" << index << " count:" << count << " splitCount:" << splitCount << ")");
 
-        const size_t readSize { mPageBackend.FetchPages(index, count, 
-            [&](const uint64_t pageIndex, Page&& page)
+        const PageBackend::PageHandler pageHandler { [&](const uint64_t pageIndex, Page&& page)
         {
             // if we are reading a page that is smaller on the backend (dirty writes), might need to extend
-            const uint64_t pageStart { index*mPageSize }; // offset of the page start
+            const uint64_t pageStart { pageIndex*mPageSize }; // offset of the page start
             const size_t realSize { min64st(mFileSize-pageStart, mPageSize) };
             if (page.size() < realSize) ResizePage(page, realSize, false);
 
@@ -411,28 +618,37 @@ void PageManager::FetchPages(const uint64_t index, const size_t count) noexcept
             InformNewPageRead(pageIndex, newIt->second, false, false, pagesLock);
             // pass false to not wait - not allowed to call the backend for evict/flush within this callback
             // even if canWait was true, the CacheManager could have us skip the wait to get our W lock for evict
-            RemovePendingFetch(pageIndex, true, pagesLock); 
+            SetPageHint(pageIndex, newIt->second);
+            RemovePendingFetch(pageIndex, 1, pagesLock);
 
             ++curIndex;
-        }, thisLock) };
+        }};
+
+        // use the on-disk cache first if we can, then read the rest from the backend
+        const size_t cachedCount { mPageBackend.FetchCachedPages(index, count, pageHandler, thisLock) };
+        if (cachedCount < count)
+        {
+            const std::chrono::steady_clock::time_point timeStart { std::chrono::steady_clock::now() };
+            const size_t readSize { mPageBackend.FetchPages(index+cachedCount, count-cachedCount, pageHandler, thisLock) };
 
-        if (readSize >= mPageSize) // don't consider small reads
-            UpdateBandwidth(readSize, std::chrono::steady_clock::now()-timeStart);
+            // concurrent ranges each get about the same bandwidth, so the total is ~splitCount times this one
+            if (readSize >= mPageSize) // don't consider small reads
+                UpdateBandwidth(readSize*splitCount, std::chrono::steady_clock::now()-timeStart);
+        }
     }
     catch (const BackendException& ex)
     {
         MDBG_ERROR("... " << ex.what());
         const UniqueLock pagesLock(mPagesMutex);
 
-        const std::exception_ptr exptr { std::current_exception() };
-        for (uint64_t eidx { curIndex }; eidx < index+count; ++eidx)
-            mFailedPages[eidx] = exptr; // shared_ptr
-
         if (curIndex < index+count) // exception can happen after reading
-            RemovePendingFetch(curIndex, false, pagesLock);
+        {
+            mFailedPages.insert(curIndex, index+count, std::current_exception());
+            RemovePendingFetch(curIndex, static_cast<size_t>(index+count-curIndex), pagesLock);
+        }
     }
     
-    MDBG_INFO("... thread returning!");
+    MDBG_INFO("... job returning!");
 }
 
 /*****************************************************/
@@ -519,10 +735,13 @@ void PageManager::EvictPage(const uint64_t index, const SharedLockW& thisLock)
             FlushPageList(index, writeList, thisLock);
         }
 
-        if (mCacheMgr) mCacheMgr->RemovePage(pageIt->second);
+        if (mCacheMgr) mCacheMgr->RemovePage(pageIt->second, true); // evicted
 
         if (!pageIt->second.isDirty() || randWrite)
+        {
+            ClearPageHint(index);
             mPages.erase(pageIt);
+        }
         else mDeferredEvicts.push_back(pageIt->first);
 
         MDBG_INFO("... page removed, numPages:" << mPages.size());
@@ -561,7 +780,7 @@ void PageManager::FlushPages(const SharedLockW& thisLock)
     MDBG_INFO("()");
 
     // create runs of pages to write separate from mPages so we don't have to hold pagesLock
-    std::map<uint64_t, PageBackend::PagePtrList> writeLists;
+    WriteLists writeLists;
 
     PageMap::iterator pageIt { mPages.begin() };
     while (pageIt != mPages.end())
@@ -577,10 +796,28 @@ void PageManager::FlushPages(const SharedLockW& thisLock)
 
     MDBG_INFO("... write runs:" << writeLists.size());
     
+    const ConfigOptions& options { mBackend.GetOptions() };
+    const bool randWrite { mFile.GetWriteMode() >= FSConfig::WriteMode::RANDOM };
+    const size_t flushThreads { !randWrite ? 1 : std::min({ 
+        options.flushThreads, options.runnerPoolSize, writeLists.size() }) };
+
     if (writeLists.empty()) // run anyway so FlushCreate() is called
         FlushPageList(0, PageBackend::PagePtrList(), thisLock);
-    else for (const decltype(writeLists)::value_type& writePair : writeLists)
-        FlushPageList(writePair.first, writePair.second, thisLock);
+    else if (flushThreads <= 1)
+    {
+        for (const WriteLists::value_type& writePair : writeLists)
+            FlushPageList(writePair.first, writePair.second, thisLock);
+    }
+    else
+    {
+        // the first run creates the file if necessary, the rest can be concurrent
+        if (!mPageBackend.ExistsOnBackend(thisLock))
+        {
+            FlushPageList(writeLists.begin()->first, writeLists.begin()->second, thisLock);
+            writeLists.erase(writeLists.begin());
+        }
+        FlushWriteLists(writeLists, flushThreads, thisLock);
+    }
 
     for (const uint64_t pageIdx : mDeferredEvicts)
         EvictPage(pageIdx, thisLock);
@@ -611,6 +848,72 @@ size_t PageManager::FlushPageList(const uint64_t index, const PageBackend::PageP
     return totalSize;
 }
 
+/*****************************************************/
+void PageManager::FlushWriteLists(const WriteLists& writeLists, const size_t threads, const SharedLockW& thisLock)
+{
+    MDBG_INFO("(runs:" << writeLists.size() << " threads:" << threads << ")");
+
+    std::vector<const WriteLists::value_type*> runs;
+    for (const WriteLists::value_type& writePair : writeLists)
+        runs.push_back(&writePair);
+
+    // each run has its own result, no page is clean until its own run succeeds
+    std::vector<std::exception_ptr> failures(runs.size());
+    std::vector<size_t> written(runs.size(), 0);
+    std::atomic<size_t> nextRun { 0 };
+
+    const auto writeRuns { [&]() noexcept // job cannot throw
+    {
+        for (size_t run; (run = nextRun++) < runs.size(); )
+        {
+            try { written[run] = mPageBackend.WritePageList(runs[run]->first, runs[run]->second, thisLock); }
+            catch (const BaseException& ex)
+            {
+                MDBG_ERROR("... run at index " << runs[run]->first << " failed: " << ex.what());
+                failures[run] = std::current_exception();
+            }
+            catch (...)
+            {
+                MDBG_ERROR("... run at index " << runs[run]->first << " failed");
+                failures[run] = std::current_exception();
+            }
+        }
+    } };
+
+    { // this thread also writes, each job will use its own backend runner
+        // SYNC so the jobs never wait behind read-ahead (or for a busy pool) while we hold thisLock
+        std::list<std::future<void>> jobs;
+        for (size_t i { 1 }; i < threads; ++i)
+        {
+            try { jobs.emplace_back(mBackend.RunAsync(this, FetchPool::Priority::SYNC, writeRuns)); }
+            catch (const std::system_error& e) {
+                MDBG_ERROR("... thread error: " << e.what()); break; } // fewer threads is okay
+        }
+        writeRuns();
+        for (std::future<void>& job : jobs) job.wait(); // they reference our locals
+    }
+
+    std::exception_ptr firstFail;
+    for (size_t run { 0 }; run < runs.size(); ++run)
+    {
+        const uint64_t index { runs[run]->first };
+        if (failures[run])
+        {
+            if (!firstFail) firstFail = failures[run];
+            continue; // leave dirty
+        }
+
+        mPageBackend.ExtendBackendSize(index*mPageSize + written[run], thisLock);
+        for (Page* pagePtr : runs[run]->second)
+        {
+            pagePtr->setDirty(false);
+            if (mCacheMgr) mCacheMgr->RemoveDirty(*pagePtr);
+        }
+    }
+
+    if (firstFail) std::rethrow_exception(firstFail);
+}
+
 /*****************************************************/
 void PageManager::FlushCreate(const SharedLockW& thisLock)
 {
@@ -651,6 +954,7 @@ void PageManager::RemoteChanged(const uint64_t backendSize, const SharedLockW& t
         if (!page.isDirty()) // evict all non-dirty
         {
             if (mCacheMgr) mCacheMgr->RemovePage(page);
+            ClearPageHint(it->first);
             it = mPages.erase(it);
         }
         else
@@ -675,12 +979,20 @@ void PageManager::Truncate(const uint64_t newSize, const SharedLockW& thisLock)
     mPageBackend.Truncate(newSize, thisLock);
     mFileSize = newSize;
 
+    ResizePages(thisLock);
+}
+
+/*****************************************************/
+void PageManager::ResizePages(const SharedLockW& thisLock)
+{
+    const uint64_t newSize { mFileSize };
     for (PageMap::iterator it { mPages.begin() }; it != mPages.end(); )
     {
         if (!newSize || it->first > (newSize-1)/mPageSize) // remove past end
         {
             MDBG_INFO("... erase page:" << it->first);
             if (mCacheMgr) mCacheMgr->RemovePage(it->second);
+            ClearPageHint(it->first);
             it = mPages.erase(it);
         }
         else if (it->first == (newSize-1)/mPageSize) // the newly last page
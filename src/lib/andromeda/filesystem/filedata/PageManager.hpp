@@ -2,6 +2,8 @@
 #ifndef LIBA2_PAGEMANAGER_H_
 #define LIBA2_PAGEMANAGER_H_
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
@@ -10,13 +12,15 @@
 #include <map>
 #include <mutex>
 #include <shared_mutex>
-#include <thread>
 
 #include "BandwidthMeasure.hpp"
+#include "FetchPool.hpp"
 #include "PageBackend.hpp"
+#include "PageTable.hpp"
 
 #include "andromeda/common.hpp"
 #include "andromeda/Debug.hpp"
+#include "andromeda/IntervalMap.hpp"
 #include "andromeda/ScopeLocked.hpp"
 #include "andromeda/SharedMutex.hpp"
 
@@ -37,10 +41,14 @@ class Page;
  * Implements thread-safe interfaces to read, write, truncate, evict and flush
  * Implements various tricks/caching to greatly increase speed:
  *  - caches pages read from the backend (see EvictPage)
+ *  - reads resident clean pages without mPagesMutex (see PageHint)
+ *  - optionally keeps clean pages in a persistent on-disk cache (see DiskCache)
  *  - reads ahead consecutive ranges of pages sized by bandwidth,
- *      doing so on a background thread to minimize waiting
+ *      doing so asynchronously on the backend (see RunAsync) to minimize waiting
+ *  - tracks pending/failed fetches as ranges for log-time lookups (see IntervalMap)
  *  - caches writes until flushed (write-back cache) (see FlushPage)
- *  - writes back consecutive ranges of pages to maximize throughput
+ *  - writes back consecutive ranges of pages to maximize throughput,
+ *      and separate ranges concurrently (see FlushWriteLists)
  *  - supports delayed file Create to combine Create+Write to Upload
  * THREAD SAFE (FORCES EXTERNAL LOCKS) (use parent File's lock)
  */
@@ -91,12 +99,30 @@ public:
      */
     void ReadPage(char* buffer, uint64_t index, size_t offset, size_t length, const SharedLock& thisLock);
 
+    /** 
+     * Returns a pointer to the data at offset in the given page index, without copying
+     * Stays valid while thisLock is held, since pages are only evicted or resized with a write lock
+     * @throws BackendException for backend issues
+     * @throws CacheManager::MemoryException
+     */
+    const char* ReadPageRef(uint64_t index, size_t offset, size_t length, const SharedLock& thisLock);
+
     /** Writes data to the given page index from buffer
      * @throws BackendException for backend issues
      * @throws CacheManager::MemoryException
      */
     void WritePage(const char* buffer, uint64_t index, size_t offset, size_t length, const SharedLockW& thisLock);
 
+    /** 
+     * Writes data to the given page index by having func fill in the page at offset, without copying
+     * The page is only marked dirty and the file extended for the bytes func returns as filled in,
+     * anything else is rolled back (if func throws, a clean page is dropped as its content is unknown)
+     * @return the number of bytes func filled in
+     * @throws BackendException for backend issues
+     * @throws CacheManager::MemoryException
+     */
+    size_t WritePage(const File::WriteRefFunc& func, uint64_t index, size_t offset, size_t length, const SharedLockW& thisLock);
+
     /** 
      * Removes the given page, writing it if dirty
      * @throws BackendException for backend issues (only if dirty)
@@ -132,6 +158,8 @@ public:
 
 private:
 
+    friend class PageManagerTest;
+
     using UniqueLock = std::unique_lock<std::mutex>;
 
     /** 
@@ -141,6 +169,30 @@ private:
      */
     const Page& GetPageRead(uint64_t index, const SharedLock& thisLock);
 
+    /**
+     * Reads a whole page from the backend into both a new cached page and buffer, saving a copy out of the page
+     * Only done if the page is not cached or pending and a normal fetch would read just this page
+     * @return true if the page was read, false if it must be read through GetPageRead()
+     * @throws BackendException for backend issues
+     */
+    bool TryReadDirect(char* buffer, uint64_t index, size_t length, const SharedLock& thisLock);
+
+    /** 
+     * Returns the page at the given index if it can be read without mPagesMutex - LOCK-FREE
+     * The page must be hinted (see PageHint) and clean, and any read-ahead it would trigger
+     * (see DoAdvanceRead) must already be satisfied, else returns nullptr (use the slow path)
+     */
+    const Page* TryGetPageFast(uint64_t index, const SharedLock& thisLock) const;
+
+    /** Returns the hinted page at the given index or nullptr if not hinted - LOCK-FREE */
+    const Page* GetPageHint(uint64_t index) const;
+
+    /** Sets the hint for the given page index (see PageHint for locking) */
+    void SetPageHint(uint64_t index, const Page& page);
+
+    /** Clears the hint for the given page index if set - MUST call before erasing a page (see PageHint for locking) */
+    void ClearPageHint(uint64_t index);
+
     /** 
      * Returns the page at the given index and marks dirty/informs cacheMgr - use GetWriteLock() first! 
      * @param pageSize the desired size of the page for writing
@@ -180,6 +232,12 @@ private:
      */
     void ResizePage(Page& page, size_t pageSize, bool cacheMgr, const SharedLockW* thisLock = nullptr);
 
+    /** Removes pages past mFileSize and resizes the rest to fit it (last page exact, others full) */
+    void ResizePages(const SharedLockW& thisLock);
+
+    /** Undoes a WritePage() that filled in nothing, dropping the page if it is not dirty */
+    void AbortPageWrite(uint64_t index, const SharedLockW& thisLock);
+
     /** Returns true if the page at the given index is pending download */
     bool isFetchPending(uint64_t index, const UniqueLock& pagesLock);
 
@@ -195,27 +253,32 @@ private:
     /** Starts a fetch if necessary to prepopulate some pages ahead of the given index (options.readAheadBuffer) */
     void DoAdvanceRead(uint64_t index, const SharedLock& thisLock, const UniqueLock& pagesLock);
 
-    /** Spawns a thread to read some # of pages starting at the given VALID (mBackendSize) index */
-    void StartFetch(uint64_t index, size_t readCount, const UniqueLock& pagesLock);
+    /** 
+     * Queues jobs to read some # of pages starting at the given VALID (mBackendSize) index
+     * Large reads are split into concurrent ranges (see GetFetchSplit)
+     * @param priority SYNC if a reader will wait for the first page, else READAHEAD
+     */
+    void StartFetch(uint64_t index, size_t readCount, FetchPool::Priority priority, const UniqueLock& pagesLock);
+
+    /** Returns the number of concurrent ranges to split a fetch of readCount pages into (options.readSplitSize) */
+    size_t GetFetchSplit(size_t readCount) const;
 
     /** 
      * Reads count# pages from the backend at the given index, adding to the page map
      * Gets its own R thisLock and informs the cacheManager of all new pages
-     * Sets mFailedPages[idx] to any BackendException
+     * Sets the failed range in mFailedPages to any BackendException
+     * @param splitCount the number of concurrent ranges this fetch is a part of
      */
-    void FetchPages(uint64_t index, size_t count) noexcept;
+    void FetchPages(uint64_t index, size_t count, size_t splitCount) noexcept;
 
-    /** 
-     * Removes the given start index from the pending-read list and notifies waiters
-     * @param idxOnly if true, adjust the entry start index to be the next index, else remove it
-     */
-    void RemovePendingFetch(uint64_t index, bool idxOnly, const UniqueLock& pagesLock);
+    /** Removes count# pages starting at index from the pending set and notifies waiters */
+    void RemovePendingFetch(uint64_t index, size_t count, const UniqueLock& pagesLock);
 
     /** Updates mFetchSize with the given bandwidth measurement - THREAD SAFE */
     void UpdateBandwidth(size_t bytes, const std::chrono::steady_clock::duration& time);
 
-    /** Map of page index to page */
-    using PageMap = std::map<uint64_t, Page>;
+    /** Map of page index to page (page addresses are stable) */
+    using PageMap = PageTable<Page>;
 
     /** 
      * Returns a series of **consecutive** dirty pages (total bytes < size_t)
@@ -235,6 +298,18 @@ private:
      */
     size_t FlushPageList(uint64_t index, const PageBackend::PagePtrList& pages, const SharedLockW& thisLock);
 
+    /** Map of start index to consecutive pages to write */
+    using WriteLists = std::map<uint64_t, PageBackend::PagePtrList>;
+
+    /** 
+     * Writes multiple runs of pages concurrently, the file must already exist on the backend
+     * Only pages in runs that succeed are marked not dirty, failed runs stay dirty
+     * @param writeLists the runs of pages to write
+     * @param threads the max number of runs to write at once
+     * @throws BackendException for backend issues (the first failed run's)
+     */
+    void FlushWriteLists(const WriteLists& writeLists, size_t threads, const SharedLockW& thisLock);
+
     /** 
      * Does FlushCreate() in case the file doesn't exist on the backend, then maybe truncates
      *    the file on the backend in case we did a truncate before it existed
@@ -260,27 +335,41 @@ private:
     /** Mutex that protects mFetchSize and mBandwidthHistory */
     std::mutex mFetchSizeMutex;
 
-    /** List of <index,count> pending reads */
-    using PendingMap = std::list<std::pair<uint64_t, size_t>>;
-    /** 
-     * Map of page index to exception thrown when reading 
-     * This is simpler but less efficient than storing a map of FetchPairs,
-     * but performance is not critical for the rare failure case
-     */
-    using FailureMap = std::map<uint64_t, std::exception_ptr>;
+    /** Set of page index ranges being downloaded */
+    using PendingMap = IntervalMap<uint64_t>;
+    /** Map of page index ranges to the exception thrown when reading them */
+    using FailureMap = IntervalMap<uint64_t, std::exception_ptr>;
 
     /** The index based map of pages */
     PageMap mPages;
-    /** Unique set of page ranges being downloaded */
+
+    /** The number of slots in mPageHints (direct-mapped by index) */
+    static constexpr size_t HINT_SLOTS { 256 };
+
+    /** 
+     * A lock-free hint that maps a page index to its page in mPages, for the GetPageRead fast path
+     * Written only with thisLock W, or thisLock R + mPagesMutex, so writers are serialized.
+     * Read with only thisLock R, which guarantees the page is not erased while in use.
+     * The sequence number (seqlock) guarantees readers never see a torn index/page pair.
+     */
+    struct PageHint
+    {
+        /** Sequence number, odd while being written */
+        std::atomic<uint32_t> mSeq { 0 };
+        /** The index of the hinted page */
+        std::atomic<uint64_t> mIndex { 0 };
+        /** Pointer to the hinted page (null if none) */
+        std::atomic<const Page*> mPage { nullptr };
+    };
+    /** Direct-mapped table of page hints */
+    std::array<PageHint, HINT_SLOTS> mPageHints;
+    /** Set of page ranges being downloaded */
     PendingMap mPendingPages;
     /** Map of failures encountered while downloading pages */
     FailureMap mFailedPages;
     /** Condition variable for waiting for pages */
     std::condition_variable mPagesCV;
 
-    /** Lock for fetch threads to acquire (so destructor can wait) */
-    std::shared_mutex mFetchMutex;
-
     /** List of pages we didn't evict due to requiring sequential writing */
     std::list<uint64_t> mDeferredEvicts;
 
@@ -0,0 +1,277 @@
+
+#ifndef LIBA2_PAGETABLE_H_
+#define LIBA2_PAGETABLE_H_
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "andromeda/common.hpp"
+
+namespace Andromeda {
+namespace Filesystem {
+namespace Filedata {
+
+/**
+ * A sparse array of values keyed by page index, with std::map-like semantics (ordered)
+ * Indexes are grouped into fixed-size chunks that store their entries inline with a
+ * bitmask of used slots, and chunks are found by directly indexing a vector (a 2-level radix).
+ * Lookups are O(1) and iterating/upper_bound scan the bitmasks, rather than chasing tree nodes.
+ * An entry's address never changes until it is erased (chunks are never moved),
+ * and empty chunks are freed. Only the top-level vector scales with the highest index in use.
+ * @tparam T the value type to store for each index
+ */
+template<typename T>
+class PageTable
+{
+public:
+
+    using key_type = uint64_t;
+    using mapped_type = T;
+    using value_type = std::pair<const uint64_t, T>;
+
+private:
+
+    /** Number of index bits resolved within a chunk */
+    static constexpr size_t CHUNK_BITS { 6 };
+    /** Number of entries in each chunk (bits in mMask) */
+    static constexpr size_t CHUNK_SLOTS { static_cast<size_t>(1) << CHUNK_BITS };
+    /** The index used by end() iterators, never a valid index */
+    static constexpr uint64_t END_INDEX { std::numeric_limits<uint64_t>::max() };
+
+    /** A fixed-size group of consecutive entries */
+    struct Chunk
+    {
+        /** Bit set for each slot that holds an entry */
+        uint64_t mMask { 0 };
+        /** Storage for the entries, only constructed if set in mMask */
+        std::array<std::aligned_storage_t<sizeof(value_type), alignof(value_type)>, CHUNK_SLOTS> mSlots;
+
+        /** Returns the entry at the given slot (MUST be set in mMask) */
+        [[nodiscard]] inline value_type& at(const size_t slot) noexcept {
+            return *std::launder(reinterpret_cast<value_type*>(&mSlots[slot])); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        /** Returns the entry at the given slot (MUST be set in mMask) */
+        [[nodiscard]] inline const value_type& at(const size_t slot) const noexcept {
+            return *std::launder(reinterpret_cast<const value_type*>(&mSlots[slot])); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    };
+
+    /** Returns the index of the lowest set bit in the given (non-zero) mask */
+    [[nodiscard]] static inline size_t LowestBit(uint64_t mask) noexcept
+    {
+    #if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctzll(mask));
+    #else
+        size_t bit { 0 };
+        for (; !(mask & 1); mask >>= 1) ++bit;
+        return bit;
+    #endif
+    }
+
+    /** Iterator over the used entries in index order */
+    template<bool Const>
+    class Iterator
+    {
+    public:
+        using Table = std::conditional_t<Const, const PageTable, PageTable>;
+
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = PageTable::value_type;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        Iterator() = default;
+        Iterator(Table* table, const uint64_t index) noexcept : mTable(table), mIndex(index) { }
+
+        /** Allows converting an iterator to a const_iterator */
+        template<bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other) noexcept : // NOLINT(google-explicit-constructor)
+            mTable(other.mTable), mIndex(other.mIndex) { }
+
+        [[nodiscard]] inline reference operator*() const noexcept { return mTable->GetEntry(mIndex); }
+        [[nodiscard]] inline pointer operator->() const noexcept { return &mTable->GetEntry(mIndex); }
+
+        inline Iterator& operator++() noexcept { mIndex = mTable->NextIndex(mIndex+1); return *this; }
+        inline Iterator operator++(int) noexcept { Iterator ret { *this }; ++(*this); return ret; }
+
+        [[nodiscard]] inline bool operator==(const Iterator& rhs) const noexcept { return mIndex == rhs.mIndex; }
+        [[nodiscard]] inline bool operator!=(const Iterator& rhs) const noexcept { return mIndex != rhs.mIndex; }
+
+    private:
+        friend class PageTable;
+        template<bool> friend class Iterator;
+
+        Table* mTable { nullptr };
+        uint64_t mIndex { END_INDEX };
+    };
+
+public:
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    PageTable() = default;
+    inline ~PageTable() { clear(); }
+    DELETE_COPY(PageTable)
+    DELETE_MOVE(PageTable)
+
+    /** Returns an iterator to the lowest index entry */
+    [[nodiscard]] inline iterator begin() noexcept { return { this, NextIndex(0) }; }
+    /** Returns the past-the-end iterator (never invalidated) */
+    [[nodiscard]] inline iterator end() noexcept { return { this, END_INDEX }; }
+    /** Returns a const iterator to the lowest index entry */
+    [[nodiscard]] inline const_iterator begin() const noexcept { return { this, NextIndex(0) }; }
+    /** Returns the const past-the-end iterator (never invalidated) */
+    [[nodiscard]] inline const_iterator end() const noexcept { return { this, END_INDEX }; }
+    /** Returns a const iterator to the lowest index entry */
+    [[nodiscard]] inline const_iterator cbegin() const noexcept { return begin(); }
+    /** Returns the const past-the-end iterator (never invalidated) */
+    [[nodiscard]] inline const_iterator cend() const noexcept { return end(); }
+
+    /** Returns the number of entries (O(1)) */
+    [[nodiscard]] inline size_t size() const noexcept { return mSize; }
+    /** Returns true iff there are no entries (O(1)) */
+    [[nodiscard]] inline bool empty() const noexcept { return !mSize; }
+
+    /** Returns an iterator to the entry at index, else end() (O(1)) */
+    [[nodiscard]] inline iterator find(const uint64_t index) noexcept {
+        return { this, HasEntry(index) ? index : END_INDEX }; }
+    /** Returns a const iterator to the entry at index, else end() (O(1)) */
+    [[nodiscard]] inline const_iterator find(const uint64_t index) const noexcept {
+        return { this, HasEntry(index) ? index : END_INDEX }; }
+
+    /** Returns an iterator to the first entry at or after index, else end() */
+    [[nodiscard]] inline iterator lower_bound(const uint64_t index) noexcept { return { this, NextIndex(index) }; }
+    /** Returns a const iterator to the first entry at or after index, else end() */
+    [[nodiscard]] inline const_iterator lower_bound(const uint64_t index) const noexcept { return { this, NextIndex(index) }; }
+    /** Returns an iterator to the first entry after index, else end() */
+    [[nodiscard]] inline iterator upper_bound(const uint64_t index) noexcept { return { this, NextIndex(index+1) }; }
+    /** Returns a const iterator to the first entry after index, else end() */
+    [[nodiscard]] inline const_iterator upper_bound(const uint64_t index) const noexcept { return { this, NextIndex(index+1) }; }
+
+    /**
+     * Constructs a new entry at index from args if it does not exist (like std::map)
+     * @return pair of an iterator to the entry at index, and true if it was created
+     */
+    template<typename... Args>
+    inline std::pair<iterator, bool> try_emplace(const uint64_t index, Args&&... args)
+    {
+        const size_t chunkIdx { static_cast<size_t>(index >> CHUNK_BITS) };
+        const size_t slot { static_cast<size_t>(index & (CHUNK_SLOTS-1)) };
+
+        if (chunkIdx >= mChunks.size()) mChunks.resize(chunkIdx+1);
+        std::unique_ptr<Chunk>& chunk { mChunks[chunkIdx] };
+        if (!chunk) chunk = std::make_unique<Chunk>();
+
+        const uint64_t bit { static_cast<uint64_t>(1) << slot };
+        if (chunk->mMask & bit) return { { this, index }, false };
+
+        try
+        {
+            new (&chunk->mSlots[slot]) value_type(std::piecewise_construct,
+                std::forward_as_tuple(index), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        catch (...) { if (!chunk->mMask) FreeChunk(chunkIdx); throw; }
+
+        chunk->mMask |= bit; ++mSize;
+        return { { this, index }, true };
+    }
+
+    /** Same as try_emplace() - never overwrites an existing entry (like std::map) */
+    template<typename... Args>
+    inline std::pair<iterator, bool> emplace(const uint64_t index, Args&&... args) {
+        return try_emplace(index, std::forward<Args>(args)...); }
+
+    /** Removes the entry at the given (valid) iterator, returns an iterator to the next entry */
+    inline iterator erase(const const_iterator& it) noexcept
+    {
+        const uint64_t index { it.mIndex };
+        const size_t chunkIdx { static_cast<size_t>(index >> CHUNK_BITS) };
+        const size_t slot { static_cast<size_t>(index & (CHUNK_SLOTS-1)) };
+
+        Chunk& chunk { *mChunks[chunkIdx] };
+        chunk.at(slot).~value_type();
+        chunk.mMask &= ~(static_cast<uint64_t>(1) << slot); --mSize;
+
+        if (!chunk.mMask) FreeChunk(chunkIdx);
+        return { this, NextIndex(index+1) };
+    }
+
+    /** Removes the entry at index if it exists, returns the number of entries removed */
+    inline size_t erase(const uint64_t index) noexcept
+    {
+        if (!HasEntry(index)) return 0;
+        erase(const_iterator { this, index }); return 1;
+    }
+
+    /** Removes all entries */
+    inline void clear() noexcept
+    {
+        for (std::unique_ptr<Chunk>& chunk : mChunks)
+        {
+            if (!chunk) continue;
+            for (uint64_t mask { chunk->mMask }; mask; mask &= mask-1)
+                chunk->at(LowestBit(mask)).~value_type();
+        }
+        mChunks.clear(); mSize = 0;
+    }
+
+private:
+
+    /** Returns true iff an entry exists at index */
+    [[nodiscard]] inline bool HasEntry(const uint64_t index) const noexcept
+    {
+        const uint64_t chunkIdx { index >> CHUNK_BITS };
+        if (chunkIdx >= mChunks.size() || !mChunks[static_cast<size_t>(chunkIdx)]) return false;
+        return (mChunks[static_cast<size_t>(chunkIdx)]->mMask >> (index & (CHUNK_SLOTS-1))) & 1;
+    }
+
+    /** Returns the entry at index (MUST exist) */
+    [[nodiscard]] inline value_type& GetEntry(const uint64_t index) noexcept {
+        return mChunks[static_cast<size_t>(index >> CHUNK_BITS)]->at(static_cast<size_t>(index & (CHUNK_SLOTS-1))); }
+    /** Returns the entry at index (MUST exist) */
+    [[nodiscard]] inline const value_type& GetEntry(const uint64_t index) const noexcept {
+        return mChunks[static_cast<size_t>(index >> CHUNK_BITS)]->at(static_cast<size_t>(index & (CHUNK_SLOTS-1))); }
+
+    /** Returns the first index at or after the given index that has an entry, else END_INDEX */
+    [[nodiscard]] inline uint64_t NextIndex(const uint64_t index) const noexcept
+    {
+        if (index == END_INDEX) return END_INDEX;
+
+        size_t slot { static_cast<size_t>(index & (CHUNK_SLOTS-1)) };
+        for (uint64_t chunkIdx { index >> CHUNK_BITS }; chunkIdx < mChunks.size(); ++chunkIdx, slot = 0)
+        {
+            const Chunk* const chunk { mChunks[static_cast<size_t>(chunkIdx)].get() };
+            if (!chunk) continue; // skip empty
+
+            const uint64_t mask { chunk->mMask & (~static_cast<uint64_t>(0) << slot) };
+            if (mask) return (chunkIdx << CHUNK_BITS) + LowestBit(mask);
+        }
+        return END_INDEX;
+    }
+
+    /** Frees the given (empty) chunk and shrinks mChunks if it was the last */
+    inline void FreeChunk(const size_t chunkIdx) noexcept
+    {
+        mChunks[chunkIdx].reset();
+        while (!mChunks.empty() && !mChunks.back()) mChunks.pop_back();
+    }
+
+    /** Chunks indexed by (index >> CHUNK_BITS), null if empty */
+    std::vector<std::unique_ptr<Chunk>> mChunks;
+    /** The total number of entries */
+    size_t mSize { 0 };
+};
+
+} // namespace Filedata
+} // namespace Filesystem
+} // namespace Andromeda
+
+#endif // LIBA2_PAGETABLE_H_
@@ -19,11 +19,9 @@ Adopted::Adopted(BackendImpl& backend, Folder& parent) :
 }
 
 /*****************************************************/
-void Adopted::SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock)
+Folder::FetchFunc Adopted::GetFetchFunc(const SharedLockW& thisLock)
 {
-    MDBG_INFO("()");
-
-    LoadItemsFrom(mBackend.GetAdopted(), itemsLocks, thisLock);
+    return [&backend=mBackend](){ return backend.GetAdopted(); };
 }
 
 } // namespace Folders
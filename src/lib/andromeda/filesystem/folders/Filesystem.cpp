@@ -51,11 +51,15 @@ void Filesystem::LoadID(const nlohmann::json& data, const UniqueLock& idLock)
 }
 
 /*****************************************************/
-void Filesystem::SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock)
+Folder::FetchFunc Filesystem::GetFetchFunc(const SharedLockW& thisLock)
 {
-    ITDBG_INFO("()");
+    return [&backend=mBackend, fsid=mFsid](){ return backend.GetFSRoot(fsid); };
+}
 
-    const nlohmann::json data(mBackend.GetFSRoot(mFsid));
+/*****************************************************/
+void Filesystem::SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock)
+{
+    ITDBG_INFO("()");
 
     { // lock scope
         const UniqueLock idLock(mIdMutex);
@@ -54,7 +54,9 @@ protected:
      */
     virtual void LoadID(const nlohmann::json& data, const UniqueLock& idLock);
 
-    void SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock) override;
+    FetchFunc GetFetchFunc(const SharedLockW& thisLock) override;
+
+    void SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock) override;
 
     void SubDelete(const DeleteLock& deleteLock) override { throw ModifyException(); }
 
@@ -21,11 +21,15 @@ Filesystems::Filesystems(BackendImpl& backend, Folder& parent) :
 }
 
 /*****************************************************/
-void Filesystems::SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock)
+Folder::FetchFunc Filesystems::GetFetchFunc(const SharedLockW& thisLock)
 {
-    MDBG_INFO("()");
+    return [&backend=mBackend](){ return backend.GetFilesystems(); };
+}
 
-    const nlohmann::json data(mBackend.GetFilesystems());
+/*****************************************************/
+void Filesystems::SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock)
+{
+    MDBG_INFO("()");
 
     Folder::NewItemMap newItems;
 
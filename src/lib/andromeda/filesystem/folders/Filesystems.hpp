@@ -23,7 +23,9 @@ public:
 
 protected:
 
-    void SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock) override;
+    FetchFunc GetFetchFunc(const SharedLockW& thisLock) override;
+
+    void SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock) override;
 
     void SubCreateFile(const std::string& name, const SharedLockW& thisLock) override { throw ModifyException(); }
 
@@ -6,7 +6,7 @@
 #include "andromeda/backend/BackendImpl.hpp"
 using Andromeda::Backend::BackendImpl;
 #include "andromeda/backend/RunnerInput.hpp"
-using Andromeda::Backend::WriteFunc;
+using Andromeda::Backend::WriteSpanFunc;
 #include "andromeda/filesystem/FSConfig.hpp"
 #include "andromeda/filesystem/File.hpp"
 using Andromeda::Filesystem::File;
@@ -64,11 +64,17 @@ PlainFolder::PlainFolder(BackendImpl& backend, const nlohmann::json& data, bool
 }
 
 /*****************************************************/
-void PlainFolder::SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock)
+Folder::FetchFunc PlainFolder::GetFetchFunc(const SharedLockW& thisLock)
+{
+    return [&backend=mBackend, id=GetID()](){ return backend.GetFolder(id); };
+}
+
+/*****************************************************/
+void PlainFolder::SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock)
 {
     ITDBG_INFO("()");
 
-    LoadItemsFrom(mBackend.GetFolder(GetID()), itemsLocks, thisLock);
+    LoadItemsFrom(data, itemsLocks, thisLock);
 }
 
 /*****************************************************/
@@ -119,7 +125,7 @@ void PlainFolder::SubCreateFile(const std::string& name, const SharedLockW& this
     else file = std::make_unique<File>(mBackend, *this, name, *mFsConfig, // create later
         [&](const std::string& fname){ 
             return mBackend.CreateFile(GetID(), fname); },
-        [&](const std::string& fname, const WriteFunc& ffunc, bool oneshot){ 
+        [&](const std::string& fname, const WriteSpanFunc& ffunc, bool oneshot){ 
             return mBackend.UploadFile(GetID(), fname, ffunc, oneshot); });
 
     const SharedLockR subLock { file->GetReadLock() };
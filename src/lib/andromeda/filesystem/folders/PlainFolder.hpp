@@ -58,7 +58,9 @@ protected:
      */
     PlainFolder(Backend::BackendImpl& backend, const nlohmann::json& data, Folder* parent);
 
-    void SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock) override;
+    FetchFunc GetFetchFunc(const SharedLockW& thisLock) override;
+
+    void SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock) override;
 
     /** 
      * Populates the item list with items using the given files/folders JSON, calling SyncContents
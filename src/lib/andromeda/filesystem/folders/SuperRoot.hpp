@@ -23,7 +23,9 @@ protected:
 
     void LoadItems(const SharedLockW& thisLock, bool canRefresh = true) override;
 
-    void SubLoadItems(ItemLockMap& itemsLocks, const SharedLockW& thisLock) override { }; // unused
+    FetchFunc GetFetchFunc(const SharedLockW& thisLock) override { return nullptr; }; // unused
+
+    void SubLoadItems(const nlohmann::json& data, ItemLockMap& itemsLocks, const SharedLockW& thisLock) override { }; // unused
 
     void SubCreateFile(const std::string& name, const SharedLockW& thisLock) override { throw ModifyException(); }
 